@@ -0,0 +1,72 @@
+/*
+ * 给cfb_*准备一个fb_info: TRUECOLOR，颜色从pseudo_palette取
+ * 填充用1号颜色，位图的前景/背景用1、2号颜色
+ */
+#include <linux/fb.h>
+
+#include "cfb_bench.h"
+
+static struct fb_ops cfb_ops;
+static struct fb_info cfb_info;
+static u32 cfb_pal[16];
+
+void cfb_bench_init(void *base, unsigned int stride, int bpp)
+{
+	memset(&cfb_info, 0, sizeof(cfb_info));
+	cfb_info.state = FBINFO_STATE_RUNNING;
+	cfb_info.var.bits_per_pixel = bpp;
+	cfb_info.fix.type = FB_TYPE_PACKED_PIXELS;
+	cfb_info.fix.visual = FB_VISUAL_TRUECOLOR;
+	cfb_info.fix.line_length = stride;
+	cfb_info.screen_base = base;
+	cfb_info.pseudo_palette = cfb_pal;
+	cfb_info.fbops = &cfb_ops;
+}
+
+void cfb_bench_fill(int x, int y, int w, int h, unsigned int pixel, int rop_xor)
+{
+	struct fb_fillrect rect = {
+		.dx	= x,
+		.dy	= y,
+		.width	= w,
+		.height	= h,
+		.color	= 1,
+		.rop	= rop_xor ? ROP_XOR : ROP_COPY,
+	};
+
+	cfb_pal[1] = pixel;
+	cfb_fillrect(&cfb_info, &rect);
+}
+
+void cfb_bench_copy(int dx, int dy, int sx, int sy, int w, int h)
+{
+	struct fb_copyarea area = {
+		.dx	= dx,
+		.dy	= dy,
+		.width	= w,
+		.height	= h,
+		.sx	= sx,
+		.sy	= sy,
+	};
+
+	cfb_copyarea(&cfb_info, &area);
+}
+
+void cfb_bench_mono(int x, int y, int w, int h, const unsigned char *bits,
+		    unsigned int fg, unsigned int bg)
+{
+	struct fb_image image = {
+		.dx		= x,
+		.dy		= y,
+		.width		= w,
+		.height		= h,
+		.fg_color	= 1,
+		.bg_color	= 2,
+		.depth		= 1,
+		.data		= (const char *)bits,
+	};
+
+	cfb_pal[1] = fg;
+	cfb_pal[2] = bg;
+	cfb_imageblit(&cfb_info, &image);
+}
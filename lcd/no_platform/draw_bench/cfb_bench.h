@@ -0,0 +1,17 @@
+/*
+ * 内核cfb_fillrect/cfb_copyarea/cfb_imageblit的包装，draw_bench拿它们做对比
+ * 源文件从KERN_DIR/drivers/video编译，没有内核源码时不编译这部分
+ * 接口只用基本类型，draw_bench.c不用包含内核的fb.h
+ */
+#ifndef __CFB_BENCH_H
+#define __CFB_BENCH_H
+
+//之后的操作都画在这个屏幕上
+void cfb_bench_init(void *base, unsigned int stride, int bpp);
+void cfb_bench_fill(int x, int y, int w, int h, unsigned int pixel, int rop_xor);
+void cfb_bench_copy(int dx, int dy, int sx, int sy, int w, int h);
+//bits每行(w + 7) / 8字节，cfb_imageblit要求这样
+void cfb_bench_mono(int x, int y, int w, int h, const unsigned char *bits,
+		    unsigned int fg, unsigned int bg);
+
+#endif
@@ -0,0 +1,312 @@
+/*
+ * draw_bench: 在PC上验证和测速s5p_fb_draw.c(驱动里用的同一份代码)
+ *
+ * 用法: draw_bench [-i iterations] [-s seed]
+ *
+ * 16bpp和32bpp的800x480屏幕上:
+ *   1. 正确性: 随机的矩形填充(含XOR)、区域复制(上下左右各方向重叠)、单色位图(奇数x、宽度不是8的倍数)
+ *      和逐像素的参考实现比较，整个屏幕逐字节相同
+ *   2. 速度: 全屏填充、控制台滚屏(整屏上移16行)、窗口内复制、8x16字体一行100个字符，
+ *      和内核的cfb_fillrect/cfb_copyarea/cfb_imageblit(fast_draw=0时用的实现)比较，
+ *      逐像素的参考实现只作为参照
+ * cfb_*从KERN_DIR/drivers/video编译(见Makefile)，找不到内核源码时只有逐像素的对比
+ * PC上的long是64位，cfb_*按64位一次处理，ARM上是32位；板子上的结论以
+ * insmod s5p_fb.ko fast_draw=0/1分别记录控制台滚屏的时间为准
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "s5p_fb_draw.h"
+
+#ifdef WITH_CFB
+#include "cfb_bench.h"
+#define HAVE_CFB	1
+#else
+#define HAVE_CFB	0
+#define cfb_bench_init(base, stride, bpp)		do { } while (0)
+#define cfb_bench_fill(x, y, w, h, pixel, rop_xor)	do { } while (0)
+#define cfb_bench_copy(dx, dy, sx, sy, w, h)		do { } while (0)
+#define cfb_bench_mono(x, y, w, h, bits, fg, bg)	do { } while (0)
+#endif
+
+#define COL		800
+#define ROW		480
+
+static int failures;
+
+static double now_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0;
+}
+
+static u32 get_px(const struct s5p_draw_surf *s, int x, int y)
+{
+	u8 *row = s->base + y * s->stride;
+
+	return (s->bpp == 32) ? ((u32 *)row)[x] : ((u16 *)row)[x];
+}
+
+static void put_px(const struct s5p_draw_surf *s, int x, int y, u32 v)
+{
+	u8 *row = s->base + y * s->stride;
+
+	if (s->bpp == 32)
+		((u32 *)row)[x] = v;
+	else
+		((u16 *)row)[x] = v;
+}
+
+//参考实现: 逐像素
+static void ref_fill(const struct s5p_draw_surf *s, int x, int y, int w, int h,
+		     u32 pixel, int rop_xor)
+{
+	int i, j;
+
+	if (s->bpp == 16)
+		pixel &= 0xffff;
+
+	for (j = 0; j < h; j++)
+		for (i = 0; i < w; i++)
+			put_px(s, x + i, y + j, rop_xor ? get_px(s, x + i, y + j) ^ pixel : pixel);
+}
+
+static void ref_copy(const struct s5p_draw_surf *s, int dx, int dy,
+		     int sx, int sy, int w, int h)
+{
+	u32 *tmp = malloc(w * h * sizeof(u32));
+	int i, j;
+
+	for (j = 0; j < h; j++)
+		for (i = 0; i < w; i++)
+			tmp[j * w + i] = get_px(s, sx + i, sy + j);
+	for (j = 0; j < h; j++)
+		for (i = 0; i < w; i++)
+			put_px(s, dx + i, dy + j, tmp[j * w + i]);
+
+	free(tmp);
+}
+
+static void ref_mono(const struct s5p_draw_surf *s, int x, int y, int w, int h,
+		     const u8 *bits, int pitch, u32 fg, u32 bg)
+{
+	int i, j;
+
+	for (j = 0; j < h; j++)
+		for (i = 0; i < w; i++)
+			put_px(s, x + i, y + j,
+			       (bits[j * pitch + i / 8] & (0x80 >> (i % 8))) ? fg : bg);
+}
+
+static void init_surf(struct s5p_draw_surf *s, int bpp)
+{
+	int i;
+
+	s->bpp = bpp;
+	s->stride = COL * bpp / 8;
+	s->base = malloc(s->stride * ROW);
+	for (i = 0; i < s->stride * ROW; i++)
+		s->base[i] = rand();
+}
+
+static u32 rand_px(int bpp)
+{
+	u32 v = ((u32)rand() << 16) ^ rand();
+
+	return (bpp == 16) ? (v & 0xffff) : v;
+}
+
+static void rand_rect(int *x, int *y, int *w, int *h)
+{
+	*w = 1 + rand() % COL;
+	*h = 1 + rand() % ROW;
+	*x = rand() % (COL - *w + 1);
+	*y = rand() % (ROW - *h + 1);
+}
+
+static void compare(const struct s5p_draw_surf *a, const struct s5p_draw_surf *b,
+		    const char *what, int iter)
+{
+	if (memcmp(a->base, b->base, a->stride * ROW)) {
+		failures++;
+		printf("  FAIL %dbpp %s (iteration %d)\n", a->bpp, what, iter);
+	}
+}
+
+/*
+ * a: s5p_draw，b: 逐像素参考实现，c: cfb_*(有的话)
+ * cfb_*也和参考实现比较，确认替身fb_info的像素顺序是对的，测速才有意义
+ */
+static void test(int bpp, int iterations)
+{
+	struct s5p_draw_surf a, b, c;
+	struct s5p_draw_ctx ctx;
+	u8 bits[64 * ROW];
+	int x, y, w, h, sx, sy, pitch;
+	u32 fg = 0, bg = 0;
+	u32 mask = (bpp == 16) ? 0xffff : ~0U;
+	int it, i;
+
+	memset(&ctx, 0, sizeof(ctx));
+	init_surf(&a, bpp);
+	init_surf(&b, bpp);
+	init_surf(&c, bpp);
+	memcpy(b.base, a.base, a.stride * ROW);
+	memcpy(c.base, a.base, a.stride * ROW);
+	cfb_bench_init(c.base, c.stride, bpp);
+
+	for (it = 0; it < iterations; it++) {
+		rand_rect(&x, &y, &w, &h);
+		fg = rand_px(bpp);
+		i = rand() & 1;
+		s5p_draw_fill(&a, x, y, w, h, fg, i);
+		ref_fill(&b, x, y, w, h, fg, i);
+		cfb_bench_fill(x, y, w, h, fg, i);
+		compare(&a, &b, "fill", it);
+		if (HAVE_CFB)
+			compare(&c, &b, "cfb_fillrect", it);
+
+		rand_rect(&x, &y, &w, &h);
+		sx = rand() % (COL - w + 1);
+		sy = rand() % (ROW - h + 1);
+		//一部分测同一行内左右移动和整行复制
+		if (it % 4 == 1)
+			sy = y;
+		if (it % 4 == 2) {
+			x = sx = 0;
+			w = COL;
+		}
+		s5p_draw_copy(&a, x, y, sx, sy, w, h);
+		ref_copy(&b, x, y, sx, sy, w, h);
+		cfb_bench_copy(x, y, sx, sy, w, h);
+		compare(&a, &b, "copy", it);
+		if (HAVE_CFB)
+			compare(&c, &b, "cfb_copyarea", it);
+
+		w = 1 + rand() % 400;
+		h = 1 + rand() % 64;
+		x = rand() % (COL - w + 1);
+		y = rand() % (ROW - h + 1);
+		pitch = (w + 7) / 8;
+		for (i = 0; i < pitch * h; i++)
+			bits[i] = rand();
+		//前景/背景色有时不变，检查表的缓存
+		if (it % 3) {
+			fg = rand_px(bpp);
+			bg = rand_px(bpp);
+		}
+		s5p_draw_mono(&ctx, &a, x, y, w, h, bits, pitch, fg, bg);
+		ref_mono(&b, x, y, w, h, bits, pitch, fg & mask, bg & mask);
+		cfb_bench_mono(x, y, w, h, bits, fg & mask, bg & mask);
+		compare(&a, &b, "mono", it);
+		if (HAVE_CFB)
+			compare(&c, &b, "cfb_imageblit", it);
+	}
+
+	free(a.base);
+	free(b.base);
+	free(c.base);
+}
+
+//倍数是相对cfb_*的，没有cfb_*时相对逐像素实现
+#define BENCH(name, n, fast, cfb, ref)						\
+	do {									\
+		double t0, t1, t2, t3;						\
+		int k;								\
+		t0 = now_us();							\
+		for (k = 0; k < (n); k++)					\
+			fast;							\
+		t1 = now_us();							\
+		for (k = 0; HAVE_CFB && k < (n); k++)				\
+			cfb;							\
+		t2 = now_us();							\
+		for (k = 0; k < (n); k++)					\
+			ref;							\
+		t3 = now_us();							\
+		printf("  %-26s %9.1f us", name, (t1 - t0) / (n));		\
+		if (HAVE_CFB)							\
+			printf(" %9.1f us", (t2 - t1) / (n));			\
+		else								\
+			printf(" %12s", "-");					\
+		printf(" %9.1f us  x%.1f\n", (t3 - t2) / (n),			\
+		       (HAVE_CFB ? t2 - t1 : t3 - t2) / (t1 - t0));		\
+	} while (0)
+
+static void bench(int bpp)
+{
+	struct s5p_draw_surf s;
+	struct s5p_draw_ctx ctx;
+	u8 font[100 * 16];
+	int i;
+
+	memset(&ctx, 0, sizeof(ctx));
+	init_surf(&s, bpp);
+	for (i = 0; i < sizeof(font); i++)
+		font[i] = rand();
+
+	cfb_bench_init(s.base, s.stride, bpp);
+
+	printf("%dbpp                          s5p_draw        cfb_*    per-pixel\n", bpp);
+	BENCH("fill 800x480", 50,
+	      s5p_draw_fill(&s, 0, 0, COL, ROW, 0x1234, 0),
+	      cfb_bench_fill(0, 0, COL, ROW, 0x1234, 0),
+	      ref_fill(&s, 0, 0, COL, ROW, 0x1234, 0));
+	BENCH("fill 97x31 at odd x", 2000,
+	      s5p_draw_fill(&s, 101, 7, 97, 31, 0x1234, 0),
+	      cfb_bench_fill(101, 7, 97, 31, 0x1234, 0),
+	      ref_fill(&s, 101, 7, 97, 31, 0x1234, 0));
+	BENCH("scroll 800x464 up 16", 50,
+	      s5p_draw_copy(&s, 0, 0, 0, 16, COL, ROW - 16),
+	      cfb_bench_copy(0, 0, 0, 16, COL, ROW - 16),
+	      ref_copy(&s, 0, 0, 0, 16, COL, ROW - 16));
+	BENCH("copy 400x300 overlapping", 50,
+	      s5p_draw_copy(&s, 110, 100, 100, 90, 400, 300),
+	      cfb_bench_copy(110, 100, 100, 90, 400, 300),
+	      ref_copy(&s, 110, 100, 100, 90, 400, 300));
+	BENCH("text 100 chars 8x16", 500,
+	      s5p_draw_mono(&ctx, &s, 0, 32, 800, 16, font, 100, 0xffffff, 0),
+	      cfb_bench_mono(0, 32, 800, 16, font, 0xffffff & (bpp == 16 ? 0xffff : ~0U), 0),
+	      ref_mono(&s, 0, 32, 800, 16, font, 100, 0xffffff, 0));
+
+	free(s.base);
+}
+
+int main(int argc, char **argv)
+{
+	int iterations = 200;
+	unsigned int seed = time(NULL);
+	int opt;
+
+	while ((opt = getopt(argc, argv, "i:s:")) != -1) {
+		switch (opt) {
+		case 'i':
+			iterations = atoi(optarg);
+			break;
+		case 's':
+			seed = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-i iterations] [-s seed]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	printf("seed %u, %d iterations\n", seed, iterations);
+	srand(seed);
+
+	test(16, iterations);
+	test(32, iterations);
+	printf("%s\n\n", failures ? "FAILED" : "all tests passed");
+
+	bench(16);
+	bench(32);
+
+	return failures ? 1 : 0;
+}
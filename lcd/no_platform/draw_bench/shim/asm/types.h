@@ -0,0 +1,13 @@
+#ifndef __SHIM_ASM_TYPES_H
+#define __SHIM_ASM_TYPES_H
+
+#include_next <asm/types.h>
+
+typedef __u8 u8;
+typedef __u16 u16;
+typedef __u32 u32;
+typedef __u64 u64;
+
+#define BITS_PER_LONG	(__SIZEOF_LONG__ * 8)
+
+#endif
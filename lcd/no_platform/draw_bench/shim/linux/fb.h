@@ -0,0 +1,59 @@
+/*
+ * fb_info的替身: fb_fillrect/fb_copyarea/fb_image等用户空间也有的定义直接用系统的<linux/fb.h>，
+ * 这里只补cfb_*用到的内核部分
+ * 只在小端的PC上用，像素在字里的顺序和ARM小端相同(最左边的像素在低位)
+ */
+#ifndef __SHIM_LINUX_FB_H
+#define __SHIM_LINUX_FB_H
+
+#include <linux/kernel.h>
+#include <string.h>
+#include <asm/types.h>
+#include_next <linux/fb.h>
+
+#define FBINFO_STATE_RUNNING	0
+#define FBINFO_STATE_SUSPENDED	1
+
+struct fb_info;
+
+struct fb_ops {
+	int (*fb_sync)(struct fb_info *info);
+};
+
+struct fb_info {
+	int flags;
+	int state;
+	struct fb_var_screeninfo var;
+	struct fb_fix_screeninfo fix;
+	struct fb_ops *fbops;
+	char __iomem *screen_base;
+	void *pseudo_palette;
+};
+
+static inline int fb_be_math(struct fb_info *info)
+{
+	return 0;
+}
+
+#define FB_LEFT_POS(p, bpp)		(fb_be_math(p) ? (32 - (bpp)) : 0)
+#define FB_SHIFT_HIGH(p, val, bits)	(fb_be_math(p) ? (val) >> (bits) : (val) << (bits))
+#define FB_SHIFT_LOW(p, val, bits)	(fb_be_math(p) ? (val) << (bits) : (val) >> (bits))
+
+//显存就是普通内存
+#define fb_readb(addr)		(*(volatile u8 *)(addr))
+#define fb_readw(addr)		(*(volatile u16 *)(addr))
+#define fb_readl(addr)		(*(volatile u32 *)(addr))
+#define fb_readq(addr)		(*(volatile u64 *)(addr))
+#define fb_writeb(b, addr)	(*(volatile u8 *)(addr) = (b))
+#define fb_writew(b, addr)	(*(volatile u16 *)(addr) = (b))
+#define fb_writel(b, addr)	(*(volatile u32 *)(addr) = (b))
+#define fb_writeq(b, addr)	(*(volatile u64 *)(addr) = (b))
+#define fb_memset		memset
+#define fb_memcpy_fromfb	memcpy
+#define fb_memcpy_tofb		memcpy
+
+void cfb_fillrect(struct fb_info *info, const struct fb_fillrect *rect);
+void cfb_copyarea(struct fb_info *info, const struct fb_copyarea *area);
+void cfb_imageblit(struct fb_info *info, const struct fb_image *image);
+
+#endif
@@ -0,0 +1,36 @@
+/*
+ * 在PC上编译内核的cfbfillrect.c/cfbcopyarea.c/cfbimgblt.c用的替身头文件
+ * 只提供这三个文件和fb_draw.h用到的定义
+ */
+#ifndef __SHIM_LINUX_KERNEL_H
+#define __SHIM_LINUX_KERNEL_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define __iomem
+#define __force
+
+#define likely(x)	__builtin_expect(!!(x), 1)
+#define unlikely(x)	__builtin_expect(!!(x), 0)
+
+#define KERN_ERR	""
+#define KERN_WARNING	""
+#define KERN_INFO	""
+#define KERN_DEBUG	""
+#define printk		printf
+
+#define WARN(cond, ...)	({ int __c = !!(cond); if (__c) fprintf(stderr, __VA_ARGS__); __c; })
+#define WARN_ON(cond)	WARN(cond, "WARN_ON(%s)\n", #cond)
+#define BUG()		abort()
+#define BUG_ON(cond)	do { if (cond) abort(); } while (0)
+
+#define min(x, y)	((x) < (y) ? (x) : (y))
+#define max(x, y)	((x) > (y) ? (x) : (y))
+
+#define EXPORT_SYMBOL(sym)
+#define MODULE_AUTHOR(s)
+#define MODULE_DESCRIPTION(s)
+#define MODULE_LICENSE(s)
+
+#endif
@@ -15,6 +15,7 @@
 #include "fb.h"
 #include "bmp.h"
 #include "test_img.h"
+#include "../s5p_fb.h"
  
 #define ALLOW_OS_CODE 1
 /*#include "../rua/include/rua.h"*/
@@ -203,6 +204,7 @@ void printusage(char *name)
 		fprintf(stderr,"                 %s /dev/fb/0 w16 <offset> <val> <num>\n",name);
 		fprintf(stderr,"                 %s /dev/fb/0 r32 <offset> <num>\n",name);
 		fprintf(stderr,"                 %s /dev/fb/0 w32 <offset> <val> <num>\n",name);
+		fprintf(stderr,"                 %s /dev/fb/0 export <frame> <val>\n",name);
 }
 
 int main(int argc, char** argv)
@@ -246,7 +248,7 @@ int main(int argc, char** argv)
 		exit(1);
 	}
 
-    if (!strcmp(argv[1], "set"))
+    if (argc >= 6 && !strcmp(argv[2], "set"))
     {
         width = strtoul(argv[3], 0, 0);
         height = strtoul(argv[4], 0, 0);
@@ -417,6 +419,42 @@ int main(int argc, char** argv)
         for (i = 0; i < num; i++)
             pcAddr[i] = dwVal;
     }
+    else if ((argc >= 5) && !strcmp(argv[2], "export"))
+    {
+        //导出第frame帧，通过导出的fd写满val，再切换过去显示
+        struct s5p_fb_export exp;
+
+        memset(&exp, 0, sizeof(exp));
+        exp.index = strtoul(argv[3], 0, 0);
+        dwVal = strtoul(argv[4], 0, 0);
+        if (ioctl(fd, S5P_FB_EXPORT_BUF, &exp)) {
+            printf("Error export frame %d.\n", exp.index);
+            exit(1);
+        }
+        printf("frame %d: fd %d, paddr 0x%08x, size %d, offset %d\n",
+               exp.index, exp.fd, exp.paddr, exp.size, exp.offset);
+
+        pcAddr = (unsigned char *)mmap(NULL, exp.offset + exp.size, PROT_READ | PROT_WRITE, MAP_SHARED, exp.fd, 0);
+        if (pcAddr == MAP_FAILED) {
+            printf("error mapping exported frame\n");
+            exit(1);
+        }
+        num = exp.size * 8 / fb_var.bits_per_pixel;
+        pdwAddr = (unsigned int *)(pcAddr + exp.offset);
+        pwAddr = (unsigned short *)(pcAddr + exp.offset);
+        for (i = 0; i < num; i++) {
+            if (fb_var.bits_per_pixel == 32)
+                pdwAddr[i] = dwVal;
+            else
+                pwAddr[i] = dwVal;
+        }
+        munmap(pcAddr, exp.offset + exp.size);
+        close(exp.fd);
+
+        fb_var.yoffset = exp.index * fb_var.yres;
+        if (ioctl(fd, FBIOPAN_DISPLAY, &fb_var))
+            printf("Error pan to frame %d.\n", exp.index);
+    }
     
 #if (EM86XX_MODE == EM86XX_MODEID_WITHHOST)
 	munmap(fb_base_addr, screensize);
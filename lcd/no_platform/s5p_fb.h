@@ -0,0 +1,68 @@
+/*
+ * s5p_fb的私有ioctl，应用和驱动共用
+ * window0是/dev/fb0，window1~4依次是后面的fb设备，window N叠在window N-1上面
+ */
+#ifndef __S5P_FB_H
+#define __S5P_FB_H
+
+#include <linux/types.h>
+#include <linux/ioctl.h>
+
+//窗口左上角在屏幕上的位置，大小和像素格式用FBIOPUT_VSCREENINFO设置
+struct s5p_fb_pos {
+	__s32 x;
+	__s32 y;
+};
+
+#define S5P_FB_ALPHA_PLANE	0	//整个窗口使用alpha
+#define S5P_FB_ALPHA_PIXEL	1	//使用像素里的alpha，要求32bpp并且transp.length = 8
+
+struct s5p_fb_alpha {
+	__u32 mode;
+	__u32 alpha;		//0~255，硬件只用高4位
+};
+
+//窗口的像素和key相同(mask为1的bit不比较)时显示下面的窗口
+struct s5p_fb_colorkey {
+	__u32 enable;
+	__u32 key;		//RGB888，16bpp的像素扩展成888后比较
+	__u32 mask;
+};
+
+/*
+ * YUV窗口: 只有window2可以用，FIMC2把YUV转换成RGB，经local path送给这个窗口，不经过内存
+ * FBIOPUT_VSCREENINFO时var.nonstd设为下面的格式，bits_per_pixel和颜色字段由驱动填写，
+ * xres按16对齐，yres按2对齐，不支持缩放(窗口大小就是图像大小)
+ * 每帧yres行，FBIOPAN_DISPLAY的yoffset必须是yres的整数倍，nonstd设回0恢复RGB
+ * 颜色范围: 默认按BT.601有限范围转换(Y 16~235，CbCr 16~240)，视频解码器、摄像头的输出都是这种；
+ * JPEG解码出来的是全范围(0~255)，格式再或上S5P_FB_NONSTD_FULL_RANGE
+ */
+#define S5P_FB_YUV_WIN		2
+#define S5P_FB_NONSTD_NV12	1	//12bpp，Y平面(line_length * yres)后面紧跟CbCr交错平面
+#define S5P_FB_NONSTD_YUYV	2	//16bpp，Y0 Cb Y1 Cr
+#define S5P_FB_NONSTD_FULL_RANGE	(1 << 8)
+
+#define S5P_FB_NONSTD_FMT(nonstd)	((nonstd) & 0xff)
+
+//只对window1~4有效
+#define S5P_FB_SET_POSITION	_IOW('F', 0x80, struct s5p_fb_pos)
+#define S5P_FB_SET_ALPHA	_IOW('F', 0x81, struct s5p_fb_alpha)
+#define S5P_FB_SET_COLORKEY	_IOW('F', 0x82, struct s5p_fb_colorkey)
+
+/*
+ * 导出第index帧(yoffset = index * yres的那一帧)，所有窗口都可以用
+ * 返回的fd可以mmap，也可以用SCM_RIGHTS传给解码、摄像头等进程，它们直接写进显存，
+ * 写完由打开fb的进程FBIOPAN_DISPLAY切换过去
+ */
+struct s5p_fb_export {
+	__u32 index;		//输入: 帧号
+	__s32 fd;		//输出: mmap这个fd得到这一帧所在的页
+	__u32 offset;		//输出: 帧在mmap出来的区域里的偏移，16bpp时一帧不一定页对齐
+	__u32 size;		//输出: 一帧的字节数
+	__u32 line_length;	//输出: 一行的字节数
+	__u32 paddr;		//输出: 物理地址，给按物理地址做DMA的设备
+};
+
+#define S5P_FB_EXPORT_BUF	_IOWR('F', 0x83, struct s5p_fb_export)
+
+#endif
@@ -0,0 +1,1852 @@
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/errno.h>
+#include <linux/string.h>
+#include <linux/mm.h>
+#include <linux/device.h>
+#include <linux/fb.h>
+#include <linux/init.h>
+#include <linux/interrupt.h>
+#include <linux/ctype.h>
+#include <linux/dma-mapping.h>
+#include <linux/platform_device.h>
+#include <linux/slab.h>
+#include <linux/clk.h>
+#include <linux/cpufreq.h>
+#include <linux/wait.h>
+#include <linux/ktime.h>
+#include <linux/workqueue.h>
+#include <linux/delay.h>
+#include <linux/anon_inodes.h>
+#include <linux/file.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/spinlock.h>
+#include <linux/mutex.h>
+#include <plat/fb.h>
+#include <mach/irqs.h>
+
+#include "s5p_fb.h"
+#include "s5p_fb_draw.h"
+#include "s5p_fb_fimc.h"
+
+#include <asm/io.h>
+#include <asm/uaccess.h>
+#include <asm/div64.h>
+#include <asm/mach/map.h>
+
+//gpio
+#define GPF0CON			(0xE0200120)
+#define GPF1CON			(0xE0200140)
+#define GPF2CON			(0xE0200160)
+#define GPF3CON			(0xE0200180)
+
+#define GPD0CON			(0xE02000A0)
+#define GPD0DAT			(0xE02000A4)
+#define GPD0PUD			(0xE02000A8)
+
+//lcd
+#define VIDCON0			(0xF8000000)
+#define VIDCON1			(0xF8000004)
+#define VIDTCON2		(0xF8000018)
+#define WINCON0 		(0xF8000020)
+#define WINCON2 		(0xF8000028)
+#define SHADOWCON 		(0xF8000034)
+#define VIDOSD0A 		(0xF8000040)
+#define VIDOSD0B 		(0xF8000044)
+#define VIDOSD0C 		(0xF8000048)
+
+#define VIDW00ADD0B0 	(0xF80000A0)
+#define VIDW00ADD1B0 	(0xF80000D0)
+
+#define VIDTCON0 		(0xF8000010)
+#define VIDTCON1 		(0xF8000014)
+
+//window0~4的寄存器，相对FIMD_BASE的偏移
+#define FIMD_BASE		(0xF8000000)
+#define FIMD_SIZE		(0x200)
+#define WINCON(w)		(0x20 + (w) * 4)
+#define WINCON_ENWIN		(1 << 0)
+#define WINCON_ALPHA_SEL	(1 << 1)
+#define WINCON_BPPMODE_565	(0x5 << 2)
+#define WINCON_BPPMODE_888	(0xb << 2)
+#define WINCON_BPPMODE_A4888	(0xd << 2)
+#define WINCON_BLD_PIX		(1 << 6)
+#define WINCON_ENLOCAL		(1 << 22)	//数据从FIMC的local path来，不用DMA
+#define WINCON_WSWP		(1 << 15)
+#define WINCON_HAWSWP		(1 << 16)
+#define VIDOSDA(w)		(0x40 + (w) * 0x10)
+#define VIDOSDB(w)		(0x44 + (w) * 0x10)
+#define VIDOSDC(w)		(0x48 + (w) * 0x10)	//window0是大小，window1~4是alpha
+#define VIDOSDD(w)		(0x4C + (w) * 0x10)	//window1、2的大小
+#define VIDOSD_POS(x, y)	(((x) << 11) | (y))
+#define VIDWADD0B0(w)		(0xA0 + (w) * 8)
+#define VIDWADD1B0(w)		(0xD0 + (w) * 8)
+#define VIDWADD2(w)		(0x100 + (w) * 4)
+#define VIDWADD2_OFFSIZE(x)	((x) << 13)
+#define WKEYCON0(w)		(0x140 + ((w) - 1) * 8)
+#define WKEYCON1(w)		(0x144 + ((w) - 1) * 8)
+#define WKEYCON0_KEYEN		(1 << 25)
+#define SHADOWCON_CH_ENABLE(w)	(1 << (w))
+#define SHADOWCON_PROTECT(w)	(1 << (10 + (w)))	//置1时这个window的影子寄存器不更新
+#define SHADOWCON_LOCAL_ENABLE(w)	(1 << (5 + (w)))	//window0~2的local path
+
+#define MAX_WINS		5
+
+#define VIDINTCON0		(0xF8000130)
+#define VIDINTCON1		(0xF8000134)
+#define VIDINTCON0_INT_ENABLE	(1 << 0)
+#define VIDINTCON0_INT_FIFO	(1 << 1)
+#define VIDINTCON0_FIFOLEVEL_MASK	(7 << 2)
+#define VIDINTCON0_FIFOLEVEL_EMPTY	(3 << 2)	//FIFO空了，DMA跟不上扫描
+#define VIDINTCON0_FIFOSEL_MASK	(0x7f << 5)
+#define VIDINTCON0_FIFOSEL_ALL	(0x73 << 5)	//window0、1、2、3、4
+#define VIDINTCON0_INT_FRAME	(1 << 12)
+#define VIDINTCON0_FRAMESEL0_MASK	(3 << 15)
+#define VIDINTCON0_FRAMESEL0_VSYNC	(1 << 15)
+#define VIDINTCON1_INT_FIFO	(1 << 0)	//写1清除
+#define VIDINTCON1_INT_FRAME	(1 << 1)	//写1清除
+
+
+//clock regs
+#define DISPLAY_CONTROL		(0xe0107008)
+
+
+//VIDCON0
+#define VIDCON0_CLKVAL_MASK	(0xff << 6)
+#define VIDCON0_CLKVAL(x)	((x) << 6)	//VCLK = HCLK_DSYS / (CLKVAL + 1)
+#define VIDCON0_CLKDIR		(1 << 4)	//使用CLKVAL分频
+
+//VIDCON1，s5pv210的时序图里VSYNC/HSYNC高电平有效，低电平有效的面板要反转
+#define VIDCON1_IVCLK		(1 << 7)	//在VCLK的上升沿取数据
+#define VIDCON1_IHSYNC		(1 << 6)
+#define VIDCON1_IVSYNC		(1 << 5)
+#define VIDCON1_INV_MASK	(VIDCON1_IVCLK | VIDCON1_IHSYNC | VIDCON1_IVSYNC)
+
+//HCLK_DSYS，拿不到lcd时钟时用它计算分频
+#define DEFAULT_HCLK		(166750000)
+
+/*
+ * 面板时序，按各自的datasheet填写，和fb_var_screeninfo的含义一样:
+ * left_margin/upper_margin是同步之后的后沿，right_margin/lower_margin是同步之前的前沿
+ * 写寄存器时减1
+ */
+struct s5p_fb_panel {
+	const char *name;
+	int xres;
+	int yres;
+	int refresh;			//Hz
+	int hsync_len;
+	int left_margin;
+	int right_margin;
+	int vsync_len;
+	int upper_margin;
+	int lower_margin;
+	u32 vidcon1;			//VIDCON1_I*
+};
+
+static const struct s5p_fb_panel s5p_fb_panels[] = {
+	{
+		//S70，AT070TN92(p13): DCLK 33.3MHz，HSYNC/VSYNC低电平有效
+		.name		= "s70",
+		.xres		= 800,
+		.yres		= 480,
+		.refresh	= 60,
+		.hsync_len	= 1,
+		.left_margin	= 46,
+		.right_margin	= 210,
+		.vsync_len	= 1,
+		.upper_margin	= 23,
+		.lower_margin	= 22,
+		.vidcon1	= VIDCON1_IHSYNC | VIDCON1_IVSYNC,
+	}, {
+		//H43，4.3寸480x272: DCLK 9MHz
+		.name		= "h43",
+		.xres		= 480,
+		.yres		= 272,
+		.refresh	= 60,
+		.hsync_len	= 41,
+		.left_margin	= 2,
+		.right_margin	= 2,
+		.vsync_len	= 10,
+		.upper_margin	= 2,
+		.lower_margin	= 2,
+		.vidcon1	= VIDCON1_IHSYNC | VIDCON1_IVSYNC,
+	}, {
+		//RGB转VGA，VESA 640x480@60: 25.175MHz，同步负极性
+		.name		= "vga",
+		.xres		= 640,
+		.yres		= 480,
+		.refresh	= 60,
+		.hsync_len	= 96,
+		.left_margin	= 48,
+		.right_margin	= 16,
+		.vsync_len	= 2,
+		.upper_margin	= 33,
+		.lower_margin	= 10,
+		.vidcon1	= VIDCON1_IHSYNC | VIDCON1_IVSYNC,
+	},
+};
+
+//显存里的帧数，2或3时应用可以在不显示的帧里画完再用FBIOPAN_DISPLAY切换
+#define MAX_NBUFS		3
+
+#define MHZ (1000*1000)
+#define PRINT_MHZ(m) 			((m) / MHZ), ((m / 1000) % 1000)
+
+
+static struct fb_info *tiny210_fbinfo;
+
+static int nbufs = 2;
+module_param(nbufs, int, 0444);
+MODULE_PARM_DESC(nbufs, "Number of frames in video memory (1-3)");
+
+static int windows = 3;
+module_param(windows, int, 0444);
+MODULE_PARM_DESC(windows, "Number of hardware windows exposed as framebuffers (1-5)");
+
+static int fast_draw = 1;
+module_param(fast_draw, int, 0644);
+MODULE_PARM_DESC(fast_draw, "Use word-wide fillrect/copyarea/imageblit instead of cfb_* (0/1)");
+
+static char *panel = "s70";
+module_param(panel, charp, 0444);
+MODULE_PARM_DESC(panel, "LCD panel timing: s70, h43, vga");
+
+//panel参数选中的面板，分辨率和时序都从这里取
+static const struct s5p_fb_panel *cur_panel;
+//实际的VCLK，Hz
+static unsigned long s5p_fb_vclk;
+
+struct s5p_fb_win {
+	int id;
+	struct fb_info *info;
+	u32 pseudo_pal[16];
+	int x;				//左上角在屏幕上的位置
+	int y;
+	int enabled;
+	struct s5p_fb_alpha alpha;
+	struct s5p_fb_colorkey ckey;
+	struct s5p_draw_ctx draw;	//imageblit的前景/背景色表
+	int local;			//FIMC2正在往这个窗口送YUV转换后的数据
+	struct s5p_fimc_src local_src;	//FIMC2启动时的输入
+	int flip_pending;		//翻页还没有显示出来
+	unsigned long flip_target;	//希望在第几次VSYNC显示
+	unsigned long flip_land;	//写完寄存器后最早在第几次VSYNC显示
+	ktime_t flip_time;		//请求的时间
+};
+
+//window1~4
+static struct fb_info *s5p_fb_wins[MAX_WINS];
+
+//gpio regs
+static volatile unsigned long *gpf0con;
+static volatile unsigned long *gpf1con;
+static volatile unsigned long *gpf2con;
+static volatile unsigned long *gpf3con;
+static volatile unsigned long *gpd0con;
+static volatile unsigned long *gpd0dat;
+static volatile unsigned long *gpd0pud;
+
+//lcd regs
+static volatile unsigned long *vidcon0;
+static volatile unsigned long *vidcon1;
+static volatile unsigned long *vidtcon2;
+static volatile unsigned long *wincon0;
+static volatile unsigned long *wincon2;
+static volatile unsigned long *shadowcon;
+static volatile unsigned long *vidosd0a;
+static volatile unsigned long *vidosd0b;
+static volatile unsigned long *vidosd0c;
+static volatile unsigned long *vidw00add0b0;
+static volatile unsigned long *vidw00add1b0;
+static volatile unsigned long *vidtcon0;
+static volatile unsigned long *vidtcon1;
+static volatile unsigned long *vidintcon0;
+static volatile unsigned long *vidintcon1;
+static void __iomem *fimd_regs;
+
+#define fimd_readl(ofs)		readl(fimd_regs + (ofs))
+#define fimd_writel(val, ofs)	writel(val, fimd_regs + (ofs))
+
+
+//clock regs
+static volatile unsigned long *display_control;
+
+/*
+ * VSYNC
+ * 帧中断(IRQ_LCD1)选在VSYNC开始时产生，每次中断计数加1并唤醒等待者
+ * FBIO_WAITFORVSYNC: 睡眠到下一次VSYNC
+ * /sys/class/graphics/fbN/vsync_event: 读出"计数 时间戳(ns)"，
+ *   每次VSYNC都sysfs_notify，可以poll(POLLPRI)等待
+ */
+static DECLARE_WAIT_QUEUE_HEAD(s5p_fb_vsync_wait);
+static unsigned long s5p_fb_vsync_count;
+static ktime_t s5p_fb_vsync_time;
+
+/*
+ * window0的fb_blank，级别越高关得越多，恢复时反过来:
+ *   FB_BLANK_NORMAL                 关背光，控制器照常扫描，恢复最快
+ *   FB_BLANK_VSYNC/HSYNC_SUSPEND    再停止视频输出(ENVID_F)，显存不再被读
+ *   FB_BLANK_POWERDOWN              再关掉"lcd"时钟，期间不能访问FIMD寄存器，
+ *                                   窗口和翻页的设置只记下来，恢复时重新写一遍
+ */
+#define S5P_FB_POWER_ON		0
+#define S5P_FB_POWER_BL_OFF	1
+#define S5P_FB_POWER_VIDEO_OFF	2
+#define S5P_FB_POWER_CLK_OFF	3
+
+static int s5p_fb_power = S5P_FB_POWER_ON;
+static struct clk *s5p_fb_clk;
+
+/*
+ * SHADOWCON、WINCON、VIDCON0、VIDINTCON0是各窗口共用的，fb核心的锁只管自己那个fb_info，
+ * 几个窗口同时设置、中断里的读改写都会互相覆盖
+ * s5p_fb_reg_lock: 这些寄存器的读改写，以及根据s5p_fb_power决定能不能访问寄存器，中断里也用
+ * s5p_fb_lock: 窗口设置(s5p_fb_win_update)和fb_blank的整个过程，中间会睡眠(启停FIMC2、等VSYNC)
+ * s5p_fb_power和win->local在两个锁都拿着时修改，只拿其中一个就可以读
+ */
+static DEFINE_SPINLOCK(s5p_fb_reg_lock);
+static DEFINE_MUTEX(s5p_fb_lock);
+//恢复时从打开输出到第一帧开始扫描
+static int s5p_fb_wake_pending;
+static ktime_t s5p_fb_wake_start;
+
+static void s5p_fb_vsync_notify(struct work_struct *work)
+{
+	//中断在register_framebuffer之前就打开了
+	if (tiny210_fbinfo->dev)
+		sysfs_notify(&tiny210_fbinfo->dev->kobj, NULL, "vsync_event");
+}
+
+static DECLARE_WORK(s5p_fb_vsync_work, s5p_fb_vsync_notify);
+
+/*
+ * 统计: /sys/kernel/debug/s5p_fb/stats，写任意内容清零
+ * 翻页(FBIOPAN_DISPLAY)记下请求时间和目标VSYNC，新地址在下一次VSYNC装入，
+ * 帧中断里算出从请求到开始扫描的延迟:
+ *   missed: 写寄存器期间已经过了VSYNC(protect挡住了那次装入)，晚了一帧
+ *   dropped: 上一次翻页还没显示就被新的覆盖
+ * FIFO下溢中断(IRQ_LCD0)每帧最多记一次: 中断里关掉，下一次VSYNC再打开
+ */
+#define LAT_BUCKETS		8
+
+//延迟直方图的上限(ms)，最后一格是34ms以上(两帧多)
+static const unsigned int s5p_fb_lat_ms[LAT_BUCKETS - 1] = { 2, 4, 8, 12, 17, 25, 34 };
+
+struct s5p_fb_stats {
+	unsigned long vblanks;
+	unsigned long flips;
+	unsigned long missed;
+	unsigned long dropped;
+	unsigned long underruns;
+	unsigned long lat[LAT_BUCKETS];
+	unsigned long lat_cnt;
+	u64 lat_sum_us;
+	s64 lat_max_us;
+	unsigned long wakes;
+	s64 wake_last_us;
+	s64 wake_max_us;
+};
+
+static struct s5p_fb_stats s5p_fb_stats;
+static DEFINE_SPINLOCK(s5p_fb_stats_lock);
+static struct dentry *s5p_fb_debugfs;
+static int s5p_fb_fifo_irq_on;
+
+//pan写完寄存器后调用，target是请求时的下一次VSYNC
+static void s5p_fb_flip_queued(struct s5p_fb_win *win, unsigned long target, ktime_t t)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&s5p_fb_stats_lock, flags);
+	s5p_fb_stats.flips++;
+	if (win->flip_pending)
+		s5p_fb_stats.dropped++;
+	win->flip_pending = 1;
+	win->flip_time = t;
+	win->flip_target = target;
+	win->flip_land = s5p_fb_vsync_count + 1;
+	spin_unlock_irqrestore(&s5p_fb_stats_lock, flags);
+}
+
+//帧中断里调用，VSYNC计数已经加过
+static void s5p_fb_flip_done(struct s5p_fb_win *win, ktime_t now)
+{
+	s64 us;
+	int i;
+
+	if (!win->flip_pending || (long)(s5p_fb_vsync_count - win->flip_land) < 0)
+		return;
+
+	win->flip_pending = 0;
+	if (s5p_fb_vsync_count != win->flip_target)
+		s5p_fb_stats.missed++;
+
+	us = ktime_us_delta(now, win->flip_time);
+	for (i = 0; i < LAT_BUCKETS - 1 && us >= s5p_fb_lat_ms[i] * 1000; i++)
+		;
+	s5p_fb_stats.lat[i]++;
+	s5p_fb_stats.lat_cnt++;
+	s5p_fb_stats.lat_sum_us += us;
+	if (us > s5p_fb_stats.lat_max_us)
+		s5p_fb_stats.lat_max_us = us;
+}
+
+static void s5p_fb_stats_vsync(ktime_t now)
+{
+	int i;
+
+	spin_lock(&s5p_fb_stats_lock);
+	s5p_fb_stats.vblanks++;
+	if (s5p_fb_wake_pending) {
+		s5p_fb_wake_pending = 0;
+		s5p_fb_stats.wakes++;
+		s5p_fb_stats.wake_last_us = ktime_us_delta(now, s5p_fb_wake_start);
+		if (s5p_fb_stats.wake_last_us > s5p_fb_stats.wake_max_us)
+			s5p_fb_stats.wake_max_us = s5p_fb_stats.wake_last_us;
+	}
+	s5p_fb_flip_done(tiny210_fbinfo->par, now);
+	for (i = 1; i < MAX_WINS; i++)
+		if (s5p_fb_wins[i])
+			s5p_fb_flip_done(s5p_fb_wins[i]->par, now);
+	spin_unlock(&s5p_fb_stats_lock);
+
+	spin_lock(&s5p_fb_reg_lock);
+	if (s5p_fb_fifo_irq_on && s5p_fb_power < S5P_FB_POWER_VIDEO_OFF)
+		*vidintcon0 |= VIDINTCON0_INT_FIFO;
+	spin_unlock(&s5p_fb_reg_lock);
+}
+
+static irqreturn_t s5p_fb_fifo_irq(int irq, void *dev_id)
+{
+	if (!(*vidintcon1 & VIDINTCON1_INT_FIFO))
+		return IRQ_NONE;
+
+	//下溢时每一行都会中断，这一帧不再记
+	spin_lock(&s5p_fb_reg_lock);
+	*vidintcon0 &= ~VIDINTCON0_INT_FIFO;
+	spin_unlock(&s5p_fb_reg_lock);
+	*vidintcon1 = VIDINTCON1_INT_FIFO;
+
+	spin_lock(&s5p_fb_stats_lock);
+	s5p_fb_stats.underruns++;
+	spin_unlock(&s5p_fb_stats_lock);
+
+	return IRQ_HANDLED;
+}
+
+static int s5p_fb_stats_show(struct seq_file *m, void *v)
+{
+	struct s5p_fb_stats st;
+	unsigned long flags;
+	unsigned int lo = 0;
+	int i;
+
+	spin_lock_irqsave(&s5p_fb_stats_lock, flags);
+	st = s5p_fb_stats;
+	spin_unlock_irqrestore(&s5p_fb_stats_lock, flags);
+
+	seq_printf(m, "vblanks:         %lu\n", st.vblanks);
+	seq_printf(m, "flips:           %lu (%lu missed vblank, %lu dropped)\n",
+		   st.flips, st.missed, st.dropped);
+	seq_printf(m, "fifo underruns:  %lu%s\n", st.underruns,
+		   s5p_fb_fifo_irq_on ? "" : " (irq not available)");
+	seq_printf(m, "flip latency:    avg %llu us, max %lld us\n",
+		   st.lat_cnt ? div_u64(st.lat_sum_us, st.lat_cnt) : 0, st.lat_max_us);
+	for (i = 0; i < LAT_BUCKETS - 1; i++) {
+		seq_printf(m, "  %2u - %2u ms:     %lu\n", lo, s5p_fb_lat_ms[i], st.lat[i]);
+		lo = s5p_fb_lat_ms[i];
+	}
+	seq_printf(m, "  >= %2u ms:       %lu\n", lo, st.lat[LAT_BUCKETS - 1]);
+	seq_printf(m, "power:           %d (0 on, 1 backlight off, 2 video off, 3 clock off)\n",
+		   s5p_fb_power);
+	seq_printf(m, "unblank to first frame: %lu wakes, last %lld us, max %lld us\n",
+		   st.wakes, st.wake_last_us, st.wake_max_us);
+
+	return 0;
+}
+
+static int s5p_fb_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, s5p_fb_stats_show, NULL);
+}
+
+static ssize_t s5p_fb_stats_write(struct file *file, const char __user *buf,
+				  size_t count, loff_t *ppos)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&s5p_fb_stats_lock, flags);
+	memset(&s5p_fb_stats, 0, sizeof(s5p_fb_stats));
+	spin_unlock_irqrestore(&s5p_fb_stats_lock, flags);
+
+	return count;
+}
+
+static const struct file_operations s5p_fb_stats_fops = {
+	.owner		= THIS_MODULE,
+	.open		= s5p_fb_stats_open,
+	.read		= seq_read,
+	.write		= s5p_fb_stats_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static irqreturn_t s5p_fb_irq(int irq, void *dev_id)
+{
+	if (!(*vidintcon1 & VIDINTCON1_INT_FRAME))
+		return IRQ_NONE;
+
+	*vidintcon1 = VIDINTCON1_INT_FRAME;
+
+	s5p_fb_vsync_time = ktime_get();
+	s5p_fb_vsync_count++;
+	s5p_fb_stats_vsync(s5p_fb_vsync_time);
+	wake_up_interruptible_all(&s5p_fb_vsync_wait);
+	schedule_work(&s5p_fb_vsync_work);
+
+	return IRQ_HANDLED;
+}
+
+static int s5p_fb_wait_for_vsync(void)
+{
+	unsigned long count = s5p_fb_vsync_count;
+	unsigned int ms = 100;
+	int ret;
+
+	//视频输出停止时没有帧中断，按一帧的时间睡眠，调用者的绘制循环不会空转
+	//期间恢复显示的话第一次VSYNC就会唤醒
+	if (s5p_fb_power >= S5P_FB_POWER_VIDEO_OFF)
+		ms = 1000 / cur_panel->refresh + 1;
+
+	//60Hz一帧16.7ms，100ms还没有中断说明显示已经关了
+	ret = wait_event_interruptible_timeout(s5p_fb_vsync_wait,
+					       count != s5p_fb_vsync_count,
+					       msecs_to_jiffies(ms));
+	if (ret == 0)
+		return -ETIMEDOUT;
+	if (ret < 0)
+		return ret;
+
+	return 0;
+}
+
+static ssize_t s5p_fb_vsync_show(struct device *dev,
+				 struct device_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%lu %lld\n", s5p_fb_vsync_count,
+		       ktime_to_ns(s5p_fb_vsync_time));
+}
+
+static DEVICE_ATTR(vsync_event, S_IRUGO, s5p_fb_vsync_show, NULL);
+
+static inline unsigned int chan_to_field(unsigned int chan, struct fb_bitfield *bf)
+{
+	chan &= 0xffff;
+	chan >>= 16 - bf->length;
+	return chan << bf->offset;
+}
+
+static int s5p_fb_setcolreg(unsigned int regno, unsigned int red,
+			     unsigned int green, unsigned int blue,
+			     unsigned int transp, struct fb_info *info)
+{
+	unsigned int val;
+	
+	if (regno >= 16)
+		return 1;
+
+	/* 用red,green,blue三原色构造出val */
+	val  = chan_to_field(red,	&info->var.red);
+	val |= chan_to_field(green, &info->var.green);
+	val |= chan_to_field(blue,	&info->var.blue);
+	
+	((u32 *)(info->pseudo_palette))[regno] = val;
+	return 0;
+}
+
+//一帧的字节数，NV12的一帧是Y平面加上一半大小的CbCr平面
+static u32 s5p_fb_frame_size(struct fb_info *info)
+{
+	u32 size = info->var.yres * info->fix.line_length;
+
+	if (S5P_FB_NONSTD_FMT(info->var.nonstd) == S5P_FB_NONSTD_NV12)
+		size += size / 2;
+
+	return size;
+}
+
+//YUV窗口按帧编号取地址，yoffset是yres的整数倍
+static void s5p_fb_yuv_src(struct fb_info *info, u32 yoffset, struct s5p_fimc_src *src)
+{
+	u32 base = info->fix.smem_start + yoffset / info->var.yres * s5p_fb_frame_size(info);
+
+	src->nonstd = S5P_FB_NONSTD_FMT(info->var.nonstd);
+	src->full_range = !!(info->var.nonstd & S5P_FB_NONSTD_FULL_RANGE);
+	src->width = info->var.xres;
+	src->height = info->var.yres;
+	src->stride = info->fix.line_length;
+	src->paddr_y = base;
+	src->paddr_c = (src->nonstd == S5P_FB_NONSTD_NV12) ? base + info->var.yres * info->fix.line_length : 0;
+}
+
+//FIMC2的输入格式或大小变了，需要重新启动，只是地址变了不用
+static int s5p_fb_src_changed(const struct s5p_fimc_src *a, const struct s5p_fimc_src *b)
+{
+	return a->nonstd != b->nonstd || a->full_range != b->full_range || a->width != b->width ||
+	       a->height != b->height || a->stride != b->stride;
+}
+
+/*
+ * 切换显示的帧
+ * 在SHADOWCON的protect置位期间改起止地址，清除后控制器在下一帧开始时
+ * 把两个地址一起装入，不会出现上半屏旧帧、下半屏新帧
+ */
+static int s5p_fb_pan_display(struct fb_var_screeninfo *var, struct fb_info *info)
+{
+	struct s5p_fb_win *win = info->par;
+	unsigned long target = s5p_fb_vsync_count + 1;
+	ktime_t t = ktime_get();
+	unsigned long start;
+	unsigned long flags;
+	int scanning;
+
+	if (var->xoffset != 0 || var->yoffset + info->var.yres > info->var.yres_virtual)
+		return -EINVAL;
+	if (info->var.nonstd && var->yoffset % info->var.yres)
+		return -EINVAL;
+
+	//控制台滚屏也会调用，不能睡眠，只拿寄存器的锁
+	spin_lock_irqsave(&s5p_fb_reg_lock, flags);
+
+	//时钟关着，fb核心会记下yoffset，恢复时s5p_fb_win_update按它写地址
+	if (s5p_fb_power == S5P_FB_POWER_CLK_OFF) {
+		spin_unlock_irqrestore(&s5p_fb_reg_lock, flags);
+		return 0;
+	}
+
+	//YUV窗口: FIMC2的输入DMA在下一帧开始时换地址
+	if (info->var.nonstd) {
+		struct s5p_fimc_src src;
+
+		s5p_fb_yuv_src(info, var->yoffset, &src);
+		if (win->local)
+			s5p_fimc_local_set_addr(src.paddr_y, src.paddr_c);
+	} else {
+		start = info->fix.smem_start + var->yoffset * info->fix.line_length;
+
+		*shadowcon |= SHADOWCON_PROTECT(win->id);
+		fimd_writel(start, VIDWADD0B0(win->id));
+		fimd_writel(start + info->var.yres * info->fix.line_length, VIDWADD1B0(win->id));
+		*shadowcon &= ~SHADOWCON_PROTECT(win->id);
+	}
+
+	//关闭的窗口、停止的视频输出不扫描，不算翻页，也不用等VSYNC
+	scanning = win->enabled && s5p_fb_power < S5P_FB_POWER_VIDEO_OFF;
+	spin_unlock_irqrestore(&s5p_fb_reg_lock, flags);
+
+	if (!scanning)
+		return 0;
+
+	s5p_fb_flip_queued(win, target, t);
+
+	//FB_ACTIVATE_VBL: 等新地址生效后再返回，调用者可以马上往旧帧里画
+	if (var->activate & FB_ACTIVATE_VBL)
+		return s5p_fb_wait_for_vsync();
+
+	return 0;
+}
+
+static const struct s5p_fb_panel *s5p_fb_find_panel(const char *name)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(s5p_fb_panels); i++)
+		if (!strcmp(s5p_fb_panels[i].name, name))
+			return &s5p_fb_panels[i];
+
+	return NULL;
+}
+
+/*
+ * 按面板的刷新率选CLKVAL: 一帧htotal * vtotal个VCLK，
+ * 分频取最接近的整数，实际刷新率会和要求的有一点偏差
+ */
+static u32 s5p_fb_calc_clkval(unsigned long rate)
+{
+	const struct s5p_fb_panel *p = cur_panel;
+	u32 htotal = p->xres + p->hsync_len + p->left_margin + p->right_margin;
+	u32 vtotal = p->yres + p->vsync_len + p->upper_margin + p->lower_margin;
+	unsigned long want = htotal * vtotal * p->refresh;
+	u32 div;
+	u64 hz100;
+
+	div = DIV_ROUND_CLOSEST(rate, want);
+	div = clamp(div, 1U, 256U);
+	s5p_fb_vclk = rate / div;
+
+	//刷新率精确到0.01Hz
+	hz100 = (u64)s5p_fb_vclk * 100;
+	do_div(hz100, htotal * vtotal);
+	printk(KERN_INFO "s5p_fb: panel %s %dx%d, VCLK %ld.%03ld MHz (HCLK/%u), %u.%02u Hz\n",
+	       p->name, p->xres, p->yres, PRINT_MHZ(s5p_fb_vclk), div,
+	       (u32)hz100 / 100, (u32)hz100 % 100);
+
+	return div - 1;
+}
+
+//window0的时序只由面板决定，FBIOPUT_VSCREENINFO传进来的值不用
+static void s5p_fb_panel_var(struct fb_var_screeninfo *var)
+{
+	const struct s5p_fb_panel *p = cur_panel;
+
+	var->pixclock = s5p_fb_vclk ? KHZ2PICOS(s5p_fb_vclk / 1000) : 0;
+	var->hsync_len = p->hsync_len;
+	var->left_margin = p->left_margin;
+	var->right_margin = p->right_margin;
+	var->vsync_len = p->vsync_len;
+	var->upper_margin = p->upper_margin;
+	var->lower_margin = p->lower_margin;
+	var->sync = 0;
+	var->vmode = FB_VMODE_NONINTERLACED;
+}
+
+/*
+ * 叠加窗口(window1~4)
+ * 每个窗口一个fb设备，FBIOPUT_VSCREENINFO设置大小和像素格式(16bpp RGB565，32bpp RGB888/ARGB)，
+ * S5P_FB_SET_POSITION/ALPHA/COLORKEY设置位置、透明度和色键，FBIOBLANK打开/关闭窗口
+ * 控制器按window0->4的顺序逐层混合，CPU不用再合成整帧
+ * ARGB像素的alpha硬件只用高4位(A4888)
+ */
+static u32 s5p_fb_wincon(struct s5p_fb_win *win)
+{
+	struct fb_var_screeninfo *var = &win->info->var;
+	u32 val;
+
+	//FIMC2输出RGB888
+	if (var->nonstd)
+		return WINCON_BPPMODE_888 | WINCON_ENLOCAL | (win->enabled ? WINCON_ENWIN : 0);
+
+	if (var->bits_per_pixel == 16)
+		val = WINCON_BPPMODE_565 | WINCON_HAWSWP;
+	else if (var->transp.length)
+		val = WINCON_BPPMODE_A4888 | WINCON_WSWP;
+	else
+		val = WINCON_BPPMODE_888 | WINCON_WSWP;
+
+	if (win->alpha.mode == S5P_FB_ALPHA_PIXEL && var->transp.length)
+		val |= WINCON_BLD_PIX | WINCON_ALPHA_SEL;
+
+	if (win->enabled)
+		val |= WINCON_ENWIN;
+
+	return val;
+}
+
+/*
+ * 把窗口的所有设置写到影子寄存器，下一帧一起生效
+ * YUV窗口刚打开、或者输入的格式和大小变了才(重新)启动FIMC2，启动时会软复位，
+ * 位置、透明度、色键、翻页这些只改FIMD的寄存器和FIMC2的输入地址
+ * 关闭或者切回RGB时等FIMD不再从FIFO取数据后再停FIMC2
+ * 调用者拿着s5p_fb_lock
+ */
+static int s5p_fb_win_update(struct s5p_fb_win *win)
+{
+	struct fb_info *info = win->info;
+	struct fb_var_screeninfo *var = &info->var;
+	int id = win->id;
+	u32 pagewidth = var->xres * var->bits_per_pixel / 8;
+	u32 start = info->fix.smem_start + var->yoffset * info->fix.line_length;
+	u32 alpha = (win->alpha.alpha >> 4) * 0x111;
+	int yuv = var->nonstd && win->enabled;
+	//视频输出停止期间FIMC2的输出没有人取，恢复时再启动
+	int run = yuv && s5p_fb_power < S5P_FB_POWER_VIDEO_OFF;
+	struct s5p_fimc_src src;
+	unsigned long flags;
+	int restart = 0;
+	int stop;
+	int err;
+
+	//时钟关着，恢复时再写
+	if (s5p_fb_power == S5P_FB_POWER_CLK_OFF)
+		return 0;
+
+	if (run) {
+		s5p_fb_yuv_src(info, var->yoffset, &src);
+		restart = !win->local || s5p_fb_src_changed(&win->local_src, &src);
+	}
+
+	if (restart) {
+		err = s5p_fimc_local_start(&src);
+		if (err)
+			return err;
+		win->local_src = src;
+	}
+
+	spin_lock_irqsave(&s5p_fb_reg_lock, flags);
+	if (restart)
+		win->local = 1;
+	else if (run)
+		s5p_fimc_local_set_addr(src.paddr_y, src.paddr_c);
+
+	*shadowcon |= SHADOWCON_PROTECT(id);
+
+	fimd_writel(VIDOSD_POS(win->x, win->y), VIDOSDA(id));
+	fimd_writel(VIDOSD_POS(win->x + var->xres - 1, win->y + var->yres - 1), VIDOSDB(id));
+	if (id == 0)
+		fimd_writel(pagewidth / 4 * var->yres, VIDOSDC(id));
+	else
+		fimd_writel((alpha << 12) | alpha, VIDOSDC(id));
+	if (id == 1 || id == 2)
+		fimd_writel(var->nonstd ? var->xres * var->yres : pagewidth / 4 * var->yres, VIDOSDD(id));
+
+	if (!var->nonstd) {
+		fimd_writel(start, VIDWADD0B0(id));
+		fimd_writel(start + var->yres * info->fix.line_length, VIDWADD1B0(id));
+		fimd_writel(VIDWADD2_OFFSIZE(info->fix.line_length - pagewidth) | pagewidth, VIDWADD2(id));
+	}
+
+	if (id > 0) {
+		fimd_writel((win->ckey.enable ? WKEYCON0_KEYEN : 0) | (win->ckey.mask & 0xffffff), WKEYCON0(id));
+		fimd_writel(win->ckey.key & 0xffffff, WKEYCON1(id));
+	}
+
+	fimd_writel(s5p_fb_wincon(win), WINCON(id));
+
+	*shadowcon &= ~(SHADOWCON_CH_ENABLE(id) | SHADOWCON_LOCAL_ENABLE(id));
+	if (yuv)
+		*shadowcon |= SHADOWCON_LOCAL_ENABLE(id);
+	else if (win->enabled)
+		*shadowcon |= SHADOWCON_CH_ENABLE(id);
+
+	*shadowcon &= ~SHADOWCON_PROTECT(id);
+
+	//先清掉local，pan_display不再往FIMC2写地址
+	stop = !yuv && win->local;
+	if (stop)
+		win->local = 0;
+	spin_unlock_irqrestore(&s5p_fb_reg_lock, flags);
+
+	if (stop) {
+		s5p_fb_wait_for_vsync();
+		s5p_fimc_local_stop();
+	}
+
+	return 0;
+}
+
+/*
+ * 像素格式和大小，window0和叠加窗口共用
+ * 16bpp RGB565，24/32bpp都按32位一个像素(x888或ARGB)存放:
+ * 控制器的DMA通道不支持3字节一个像素的紧凑24bpp
+ * 16bpp时显存带宽和CPU画图的数据量都减半
+ */
+static int s5p_fb_check_yuv(struct fb_var_screeninfo *var, struct fb_info *info)
+{
+	struct s5p_fb_win *win = info->par;
+	u32 frame, frames, n;
+
+	if (win->id != S5P_FB_YUV_WIN || (var->nonstd & ~(S5P_FB_NONSTD_FULL_RANGE | 0xff)) ||
+	    !S5P_FB_NONSTD_FMT(var->nonstd) || S5P_FB_NONSTD_FMT(var->nonstd) > S5P_FB_NONSTD_YUYV)
+		return -EINVAL;
+
+	var->bits_per_pixel = (S5P_FB_NONSTD_FMT(var->nonstd) == S5P_FB_NONSTD_NV12) ? 12 : 16;
+	memset(&var->red, 0, sizeof(var->red));
+	memset(&var->green, 0, sizeof(var->green));
+	memset(&var->blue, 0, sizeof(var->blue));
+	memset(&var->transp, 0, sizeof(var->transp));
+
+	//FIMC的输入DMA要求宽度是16的倍数，4:2:0的高度是偶数
+	var->xres = ALIGN(var->xres, 16);
+	var->yres = ALIGN(var->yres, 2);
+	if (!var->xres || !var->yres ||
+	    win->x + var->xres > cur_panel->xres || win->y + var->yres > cur_panel->yres)
+		return -EINVAL;
+
+	frame = var->xres * var->yres * var->bits_per_pixel / 8;
+	frames = info->fix.smem_len / frame;
+	if (!frames)
+		return -ENOMEM;
+
+	//按整帧计，yres_virtual是yres的整数倍
+	n = clamp(var->yres_virtual / var->yres, 1U, frames);
+	var->xres_virtual = var->xres;
+	var->yres_virtual = n * var->yres;
+	var->xoffset = 0;
+	var->yoffset = rounddown(var->yoffset, var->yres);
+	if (var->yoffset >= var->yres_virtual)
+		var->yoffset = 0;
+
+	return 0;
+}
+
+static int s5p_fb_check_var(struct fb_var_screeninfo *var, struct fb_info *info)
+{
+	struct s5p_fb_win *win = info->par;
+
+	if (var->nonstd)
+		return s5p_fb_check_yuv(var, info);
+
+	if (var->bits_per_pixel <= 16) {
+		var->bits_per_pixel = 16;
+		var->red.offset = 11;
+		var->red.length = 5;
+		var->green.offset = 5;
+		var->green.length = 6;
+		var->blue.offset = 0;
+		var->blue.length = 5;
+		var->transp.offset = 0;
+		var->transp.length = 0;
+		//一行要是整数个字
+		var->xres = ALIGN(var->xres, 2);
+	} else {
+		var->bits_per_pixel = 32;
+		var->red.offset = 16;
+		var->red.length = 8;
+		var->green.offset = 8;
+		var->green.length = 8;
+		var->blue.offset = 0;
+		var->blue.length = 8;
+		var->transp.offset = var->transp.length ? 24 : 0;
+		var->transp.length = var->transp.length ? 8 : 0;
+	}
+	var->red.msb_right = var->green.msb_right = var->blue.msb_right = var->transp.msb_right = 0;
+
+	if (!var->xres || !var->yres ||
+	    win->x + var->xres > cur_panel->xres || win->y + var->yres > cur_panel->yres)
+		return -EINVAL;
+
+	var->xres_virtual = var->xres;
+	if (var->yres_virtual < var->yres)
+		var->yres_virtual = var->yres;
+	if (var->xres_virtual * var->bits_per_pixel / 8 * var->yres_virtual > info->fix.smem_len)
+		return -ENOMEM;
+
+	var->xoffset = 0;
+	if (var->yoffset + var->yres > var->yres_virtual)
+		var->yoffset = 0;
+
+	if (win->id == 0)
+		s5p_fb_panel_var(var);
+
+	return 0;
+}
+
+static int s5p_fb_set_par(struct fb_info *info)
+{
+	struct s5p_fb_win *win = info->par;
+	int err;
+
+	mutex_lock(&s5p_fb_lock);
+
+	//NV12的line_length是Y平面一行的字节数
+	if (S5P_FB_NONSTD_FMT(info->var.nonstd) == S5P_FB_NONSTD_NV12)
+		info->fix.line_length = info->var.xres_virtual;
+	else
+		info->fix.line_length = info->var.xres_virtual * info->var.bits_per_pixel / 8;
+	info->fix.visual = FB_VISUAL_TRUECOLOR;
+
+	err = s5p_fb_win_update(win);
+	mutex_unlock(&s5p_fb_lock);
+
+	return err;
+}
+
+static int s5p_fb_win_blank(int blank, struct fb_info *info)
+{
+	struct s5p_fb_win *win = info->par;
+	int enabled;
+	int err;
+
+	mutex_lock(&s5p_fb_lock);
+	enabled = win->enabled;
+	win->enabled = (blank == FB_BLANK_UNBLANK);
+	err = s5p_fb_win_update(win);
+	//打开失败(FIMC2被占用等)时寄存器没有动，状态也要保持原样
+	if (err)
+		win->enabled = enabled;
+	mutex_unlock(&s5p_fb_lock);
+
+	return err;
+}
+
+static int s5p_fb_win_ioctl(struct s5p_fb_win *win, unsigned int cmd, void __user *argp)
+{
+	struct fb_var_screeninfo *var = &win->info->var;
+	struct s5p_fb_pos pos;
+	struct s5p_fb_alpha alpha;
+	struct s5p_fb_colorkey ckey;
+	int err;
+
+	switch (cmd) {
+	case S5P_FB_SET_POSITION:
+		if (copy_from_user(&pos, argp, sizeof(pos)))
+			return -EFAULT;
+		if (pos.x < 0 || pos.y < 0 || pos.x + var->xres > cur_panel->xres ||
+		    pos.y + var->yres > cur_panel->yres)
+			return -EINVAL;
+		break;
+
+	case S5P_FB_SET_ALPHA:
+		if (copy_from_user(&alpha, argp, sizeof(alpha)))
+			return -EFAULT;
+		if (alpha.mode > S5P_FB_ALPHA_PIXEL || alpha.alpha > 255)
+			return -EINVAL;
+		break;
+
+	case S5P_FB_SET_COLORKEY:
+		if (copy_from_user(&ckey, argp, sizeof(ckey)))
+			return -EFAULT;
+		break;
+
+	default:
+		return -ENOTTY;
+	}
+
+	//window0的fb_blank恢复时会重写所有窗口的设置
+	mutex_lock(&s5p_fb_lock);
+	if (cmd == S5P_FB_SET_POSITION) {
+		win->x = pos.x;
+		win->y = pos.y;
+	} else if (cmd == S5P_FB_SET_ALPHA) {
+		win->alpha = alpha;
+	} else {
+		win->ckey = ckey;
+	}
+	err = s5p_fb_win_update(win);
+	mutex_unlock(&s5p_fb_lock);
+
+	return err;
+}
+
+/*
+ * 导出一帧显存，生产者直接写进扫描的显存，省掉一次整帧memcpy
+ * 3.0没有dma-buf，用匿名inode的fd代替: mmap只能映射这一帧所在的页，fd可以传给别的进程，
+ * 按物理地址工作的设备(FIMC、MFC)用paddr
+ * fd持有模块的引用，显存在模块卸载前不会释放
+ */
+struct s5p_fb_export_buf {
+	unsigned long start;		//页对齐的物理地址
+	unsigned long len;		//页对齐的长度
+};
+
+static int s5p_fb_export_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct s5p_fb_export_buf *buf = file->private_data;
+	unsigned long off = vma->vm_pgoff << PAGE_SHIFT;
+	unsigned long size = vma->vm_end - vma->vm_start;
+
+	if (off >= buf->len || size > buf->len - off)
+		return -EINVAL;
+
+	vma->vm_page_prot = pgprot_writecombine(vma->vm_page_prot);
+	vma->vm_flags |= VM_IO | VM_RESERVED;
+
+	return io_remap_pfn_range(vma, vma->vm_start, (buf->start + off) >> PAGE_SHIFT,
+				  size, vma->vm_page_prot);
+}
+
+static int s5p_fb_export_release(struct inode *inode, struct file *file)
+{
+	kfree(file->private_data);
+
+	return 0;
+}
+
+static const struct file_operations s5p_fb_export_fops = {
+	.owner		= THIS_MODULE,
+	.mmap		= s5p_fb_export_mmap,
+	.release	= s5p_fb_export_release,
+};
+
+static int s5p_fb_export(struct fb_info *info, void __user *argp)
+{
+	struct fb_var_screeninfo *var = &info->var;
+	struct s5p_fb_export exp;
+	struct s5p_fb_export_buf *buf;
+	struct file *file;
+	u32 frame = s5p_fb_frame_size(info);
+	u32 paddr;
+	int fd, err;
+
+	if (copy_from_user(&exp, argp, sizeof(exp)))
+		return -EFAULT;
+	if (exp.index >= var->yres_virtual / var->yres)
+		return -EINVAL;
+
+	paddr = info->fix.smem_start + exp.index * frame;
+
+	buf = kzalloc(sizeof(*buf), GFP_KERNEL);
+	if (!buf)
+		return -ENOMEM;
+	buf->start = paddr & PAGE_MASK;
+	buf->len = PAGE_ALIGN(paddr + frame) - buf->start;
+
+	fd = get_unused_fd();
+	if (fd < 0) {
+		err = fd;
+		goto err_free;
+	}
+
+	file = anon_inode_getfile("s5p_fb_buf", &s5p_fb_export_fops, buf, O_RDWR);
+	if (IS_ERR(file)) {
+		err = PTR_ERR(file);
+		goto err_put_fd;
+	}
+
+	exp.fd = fd;
+	exp.offset = paddr - buf->start;
+	exp.size = frame;
+	exp.line_length = info->fix.line_length;
+	exp.paddr = paddr;
+	if (copy_to_user(argp, &exp, sizeof(exp))) {
+		//release里释放buf
+		fput(file);
+		put_unused_fd(fd);
+
+		return -EFAULT;
+	}
+
+	fd_install(fd, file);
+
+	return 0;
+
+err_put_fd:
+	put_unused_fd(fd);
+err_free:
+	kfree(buf);
+
+	return err;
+}
+
+static int s5p_fb_ioctl(struct fb_info *info, unsigned int cmd, unsigned long arg)
+{
+	struct s5p_fb_win *win = info->par;
+	u32 crtc;
+
+	switch (cmd) {
+	case FBIO_WAITFORVSYNC:
+		if (get_user(crtc, (u32 __user *)arg))
+			return -EFAULT;
+		if (crtc != 0)
+			return -ENODEV;
+
+		return s5p_fb_wait_for_vsync();
+
+	case S5P_FB_SET_POSITION:
+	case S5P_FB_SET_ALPHA:
+	case S5P_FB_SET_COLORKEY:
+		//window0在最下面，没有位置、透明度和色键
+		if (win->id == 0)
+			return -EINVAL;
+
+		return s5p_fb_win_ioctl(win, cmd, (void __user *)arg);
+
+	case S5P_FB_EXPORT_BUF:
+		return s5p_fb_export(info, (void __user *)arg);
+	}
+
+	return -ENOTTY;
+}
+
+/*
+ * 控制台的画图，16bpp和32bpp用s5p_fb_draw.c里按字对齐的实现，其他情况交给cfb_*
+ * 挂起时显存可能不能访问(FBINFO_STATE_RUNNING以外)，也交给cfb_*按它的规则处理
+ */
+static int s5p_fb_can_draw(struct fb_info *info, struct s5p_draw_surf *s)
+{
+	int bpp = info->var.bits_per_pixel;
+
+	if (!fast_draw || info->state != FBINFO_STATE_RUNNING || info->var.nonstd)
+		return 0;
+	if (bpp != 16 && bpp != 32)
+		return 0;
+
+	s->base = (u8 *)info->screen_base;
+	s->stride = info->fix.line_length;
+	s->bpp = bpp;
+
+	return 1;
+}
+
+//控制台传进来的颜色是调色板的下标，真彩色时换成像素值
+static u32 s5p_fb_color(struct fb_info *info, u32 color)
+{
+	if (info->fix.visual == FB_VISUAL_TRUECOLOR ||
+	    info->fix.visual == FB_VISUAL_DIRECTCOLOR)
+		return ((u32 *)info->pseudo_palette)[color & 0xf];
+
+	return color;
+}
+
+static void s5p_fb_fillrect(struct fb_info *info, const struct fb_fillrect *rect)
+{
+	struct s5p_draw_surf s;
+
+	if (!s5p_fb_can_draw(info, &s)) {
+		cfb_fillrect(info, rect);
+		return;
+	}
+
+	s5p_draw_fill(&s, rect->dx, rect->dy, rect->width, rect->height,
+		      s5p_fb_color(info, rect->color), rect->rop == ROP_XOR);
+}
+
+static void s5p_fb_copyarea(struct fb_info *info, const struct fb_copyarea *area)
+{
+	struct s5p_draw_surf s;
+
+	if (!s5p_fb_can_draw(info, &s)) {
+		cfb_copyarea(info, area);
+		return;
+	}
+
+	s5p_draw_copy(&s, area->dx, area->dy, area->sx, area->sy,
+		      area->width, area->height);
+}
+
+static void s5p_fb_imageblit(struct fb_info *info, const struct fb_image *image)
+{
+	struct s5p_fb_win *win = info->par;
+	struct s5p_draw_surf s;
+
+	//logo是彩色图，只有字体是单色位图
+	if (image->depth != 1 || !s5p_fb_can_draw(info, &s)) {
+		cfb_imageblit(info, image);
+		return;
+	}
+
+	s5p_draw_mono(&win->draw, &s, image->dx, image->dy, image->width, image->height,
+		      (const u8 *)image->data, (image->width + 7) / 8,
+		      s5p_fb_color(info, image->fg_color), s5p_fb_color(info, image->bg_color));
+}
+
+static int s5p_fb_blank_level(int blank)
+{
+	switch (blank) {
+	case FB_BLANK_UNBLANK:
+		return S5P_FB_POWER_ON;
+	case FB_BLANK_NORMAL:
+		return S5P_FB_POWER_BL_OFF;
+	case FB_BLANK_VSYNC_SUSPEND:
+	case FB_BLANK_HSYNC_SUSPEND:
+		return S5P_FB_POWER_VIDEO_OFF;
+	default:
+		return S5P_FB_POWER_CLK_OFF;
+	}
+}
+
+/*
+ * 恢复显示时重写窗口设置，YUV窗口在这里重新启动FIMC2
+ * 失败的窗口(例如FIMC2被别的驱动占用)关掉，不能让它的通道打开却没有数据
+ */
+static void s5p_fb_win_restore(struct fb_info *info)
+{
+	struct s5p_fb_win *win = info->par;
+	int err;
+
+	err = s5p_fb_win_update(win);
+	if (!err)
+		return;
+
+	printk(KERN_ERR "s5p_fb: failed to restore window %d (%d), disabled\n", win->id, err);
+	win->enabled = 0;
+	s5p_fb_win_update(win);
+}
+
+//视频输出已经停止，停掉所有YUV窗口的FIMC2
+static void s5p_fb_local_stop_all(void)
+{
+	struct s5p_fb_win *win;
+	unsigned long flags;
+	int i;
+
+	for (i = 1; i < MAX_WINS; i++) {
+		if (!s5p_fb_wins[i])
+			continue;
+		win = s5p_fb_wins[i]->par;
+		if (!win->local)
+			continue;
+
+		spin_lock_irqsave(&s5p_fb_reg_lock, flags);
+		win->local = 0;
+		spin_unlock_irqrestore(&s5p_fb_reg_lock, flags);
+		s5p_fimc_local_stop();
+	}
+}
+
+//调用者拿着s5p_fb_lock
+static void s5p_fb_set_power(int level)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&s5p_fb_reg_lock, flags);
+	s5p_fb_power = level;
+	spin_unlock_irqrestore(&s5p_fb_reg_lock, flags);
+}
+
+//window0: 背光 -> 视频输出 -> 时钟依次关闭，恢复时反过来
+static int s5p_fb_blank(int blank, struct fb_info *info)
+{
+	int level = s5p_fb_blank_level(blank);
+	int cur;
+	unsigned long flags;
+	int i;
+
+	mutex_lock(&s5p_fb_lock);
+	cur = s5p_fb_power;
+	if (level == cur)
+		goto out;
+
+	if (level >= S5P_FB_POWER_BL_OFF && cur < S5P_FB_POWER_BL_OFF)
+		*gpd0dat &= ~(1 << 1);
+
+	if (level >= S5P_FB_POWER_VIDEO_OFF && cur < S5P_FB_POWER_VIDEO_OFF) {
+		//ENVID_F清0，当前帧扫描完后停止，等一帧
+		//FIFO下溢中断先关掉，恢复后第一次VSYNC再打开
+		spin_lock_irqsave(&s5p_fb_reg_lock, flags);
+		*vidintcon0 &= ~VIDINTCON0_INT_FIFO;
+		*vidcon0 &= ~(1 << 0);
+		s5p_fb_power = S5P_FB_POWER_VIDEO_OFF;
+		spin_unlock_irqrestore(&s5p_fb_reg_lock, flags);
+		msleep(1000 / cur_panel->refresh + 1);
+		s5p_fb_local_stop_all();
+	}
+
+	if (level == S5P_FB_POWER_CLK_OFF && cur < S5P_FB_POWER_CLK_OFF) {
+		s5p_fb_set_power(S5P_FB_POWER_CLK_OFF);
+		if (!IS_ERR_OR_NULL(s5p_fb_clk))
+			clk_disable(s5p_fb_clk);
+	}
+
+	if (level < S5P_FB_POWER_CLK_OFF && cur == S5P_FB_POWER_CLK_OFF) {
+		if (!IS_ERR_OR_NULL(s5p_fb_clk))
+			clk_enable(s5p_fb_clk);
+		s5p_fb_set_power(S5P_FB_POWER_VIDEO_OFF);
+
+		//关时钟期间的窗口设置和翻页
+		s5p_fb_win_restore(info);
+		for (i = 1; i < MAX_WINS; i++)
+			if (s5p_fb_wins[i])
+				s5p_fb_win_restore(s5p_fb_wins[i]);
+	}
+
+	if (level < S5P_FB_POWER_VIDEO_OFF && cur >= S5P_FB_POWER_VIDEO_OFF) {
+		//先按新的级别重启YUV窗口的FIMC2，再打开视频输出
+		s5p_fb_set_power(level);
+		for (i = 1; i < MAX_WINS; i++) {
+			if (s5p_fb_wins[i] && s5p_fb_wins[i]->var.nonstd)
+				s5p_fb_win_restore(s5p_fb_wins[i]);
+		}
+
+		spin_lock_irqsave(&s5p_fb_stats_lock, flags);
+		s5p_fb_wake_start = ktime_get();
+		s5p_fb_wake_pending = 1;
+		spin_unlock_irqrestore(&s5p_fb_stats_lock, flags);
+
+		spin_lock_irqsave(&s5p_fb_reg_lock, flags);
+		*vidcon0 |= (1 << 0);
+		s5p_fb_power = level;
+		spin_unlock_irqrestore(&s5p_fb_reg_lock, flags);
+		//第一帧开始扫描后再开背光，不会看到花屏
+		s5p_fb_wait_for_vsync();
+	}
+
+	if (level < S5P_FB_POWER_BL_OFF)
+		*gpd0dat |= (1 << 1);
+
+	s5p_fb_set_power(level);
+out:
+	mutex_unlock(&s5p_fb_lock);
+
+	return 0;
+}
+
+static struct fb_ops s5p_fb_ops = {
+	.owner			= THIS_MODULE,
+	.fb_check_var	= s5p_fb_check_var,
+	.fb_set_par		= s5p_fb_set_par,
+	.fb_setcolreg	= s5p_fb_setcolreg,
+	.fb_blank		= s5p_fb_blank,
+	.fb_pan_display	= s5p_fb_pan_display,
+	.fb_ioctl		= s5p_fb_ioctl,
+	.fb_fillrect	= s5p_fb_fillrect,
+	.fb_copyarea	= s5p_fb_copyarea,
+	.fb_imageblit	= s5p_fb_imageblit,
+};
+
+static struct fb_ops s5p_fb_win_ops = {
+	.owner			= THIS_MODULE,
+	.fb_check_var	= s5p_fb_check_var,
+	.fb_set_par		= s5p_fb_set_par,
+	.fb_setcolreg	= s5p_fb_setcolreg,
+	.fb_blank		= s5p_fb_win_blank,
+	.fb_pan_display	= s5p_fb_pan_display,
+	.fb_ioctl		= s5p_fb_ioctl,
+	.fb_fillrect	= s5p_fb_fillrect,
+	.fb_copyarea	= s5p_fb_copyarea,
+	.fb_imageblit	= s5p_fb_imageblit,
+};
+
+//分配显存并注册，窗口先关闭，应用设置好以后用FBIOBLANK打开
+static int s5p_fb_win_create(int id)
+{
+	struct fb_info *info;
+	struct s5p_fb_win *win;
+	int err;
+
+	info = framebuffer_alloc(sizeof(struct s5p_fb_win), NULL);
+	if (!info)
+		return -ENOMEM;
+
+	win = info->par;
+	win->id = id;
+	win->info = info;
+	win->alpha.alpha = 255;
+
+	sprintf(info->fix.id, "tiny210_win%d", id);
+	info->fix.smem_len = cur_panel->xres * cur_panel->yres * 4 * nbufs;
+	info->fix.type = FB_TYPE_PACKED_PIXELS;
+	info->fix.visual = FB_VISUAL_TRUECOLOR;
+	info->fix.ypanstep = 1;
+
+	info->var.xres = cur_panel->xres;
+	info->var.yres = cur_panel->yres;
+	info->var.bits_per_pixel = 32;
+	info->var.activate = FB_ACTIVATE_NOW;
+	s5p_fb_check_var(&info->var, info);
+	info->var.yres_virtual = cur_panel->yres * nbufs;
+	info->fix.line_length = cur_panel->xres * 4;
+
+	info->fbops = &s5p_fb_win_ops;
+	info->pseudo_palette = win->pseudo_pal;
+
+	info->screen_base = dma_alloc_writecombine(NULL, PAGE_ALIGN(info->fix.smem_len),
+						   (dma_addr_t *)&info->fix.smem_start, GFP_KERNEL);
+	if (!info->screen_base) {
+		err = -ENOMEM;
+		goto err_release;
+	}
+	memset(info->screen_base, 0x00, info->fix.smem_len);
+	info->screen_size = info->fix.smem_len;
+
+	mutex_lock(&s5p_fb_lock);
+	s5p_fb_win_update(win);
+	mutex_unlock(&s5p_fb_lock);
+
+	err = register_framebuffer(info);
+	if (err < 0)
+		goto err_free_dma;
+
+	s5p_fb_wins[id] = info;
+
+	return 0;
+
+err_free_dma:
+	dma_free_writecombine(NULL, PAGE_ALIGN(info->fix.smem_len), info->screen_base, info->fix.smem_start);
+err_release:
+	framebuffer_release(info);
+
+	return err;
+}
+
+static void s5p_fb_win_destroy(int id)
+{
+	struct fb_info *info = s5p_fb_wins[id];
+	struct s5p_fb_win *win;
+	unsigned long flags;
+
+	if (!info)
+		return;
+
+	win = info->par;
+	mutex_lock(&s5p_fb_lock);
+	win->enabled = 0;
+	s5p_fb_win_update(win);
+	mutex_unlock(&s5p_fb_lock);
+
+	//帧中断里统计翻页时会访问s5p_fb_wins
+	spin_lock_irqsave(&s5p_fb_stats_lock, flags);
+	s5p_fb_wins[id] = NULL;
+	spin_unlock_irqrestore(&s5p_fb_stats_lock, flags);
+
+	unregister_framebuffer(info);
+	dma_free_writecombine(NULL, PAGE_ALIGN(info->fix.smem_len), info->screen_base, info->fix.smem_start);
+	framebuffer_release(info);
+}
+
+static void tiny210_remap_regs(void)
+{
+	//remap gpio regs
+	gpf0con = ioremap(GPF0CON, 4);
+	gpf1con = ioremap(GPF1CON, 4);
+	gpf2con = ioremap(GPF2CON, 4);
+	gpf3con = ioremap(GPF3CON, 4);
+
+	gpd0con = ioremap(GPD0CON, 4);
+	gpd0dat = ioremap(GPD0DAT, 4);
+	gpd0pud = ioremap(GPD0PUD, 4);
+
+	//remap lcd regs
+	vidcon0 = ioremap(VIDCON0, 4);
+	vidcon1 = ioremap(VIDCON1, 4);
+	vidtcon2 = ioremap(VIDTCON2, 4);
+	wincon0 = ioremap(WINCON0, 4);
+	wincon2 = ioremap(WINCON2, 4);
+	shadowcon = ioremap(SHADOWCON, 4);
+	vidosd0a = ioremap(VIDOSD0A, 4);
+	vidosd0b = ioremap(VIDOSD0B, 4);
+	vidosd0c = ioremap(VIDOSD0C, 4);
+	vidw00add0b0 = ioremap(VIDW00ADD0B0, 4);
+	vidw00add1b0 = ioremap(VIDW00ADD1B0, 4);
+	vidtcon0 = ioremap(VIDTCON0, 4);
+	vidtcon1 = ioremap(VIDTCON1, 4);
+	vidintcon0 = ioremap(VIDINTCON0, 4);
+	vidintcon1 = ioremap(VIDINTCON1, 4);
+	fimd_regs = ioremap(FIMD_BASE, FIMD_SIZE);
+
+	//remap clock regs
+	display_control = ioremap(DISPLAY_CONTROL, 4);
+}
+
+static void tiny210_unmap_regs(void)
+{
+	//unmap gpio regs
+	iounmap(gpf0con);
+	iounmap(gpf1con);
+	iounmap(gpf2con);
+	iounmap(gpf3con);
+
+	iounmap(gpd0con);
+	iounmap(gpd0dat);
+
+	//unmap lcd regs
+	iounmap(vidcon0);
+	iounmap(vidcon1);
+	iounmap(vidtcon2);
+	iounmap(wincon0);
+	iounmap(wincon2);
+	iounmap(shadowcon);
+	iounmap(vidosd0a);
+	iounmap(vidosd0b);
+	iounmap(vidosd0c);
+	iounmap(vidw00add0b0);
+	iounmap(vidw00add1b0);
+	iounmap(vidtcon0);
+	iounmap(vidtcon1);
+	iounmap(vidintcon0);
+	iounmap(vidintcon1);
+	iounmap(fimd_regs);
+
+	//unmap clock regs	
+	iounmap(display_control);
+}
+
+
+static int __init tiny210_lcdfb_init(void)
+{
+	int err;
+	int i;
+	struct clk	*tiny210_clk;
+	struct s5p_fb_win *win0;
+	unsigned long rate;
+	u32 clkval;
+
+	printk("tiny210 lcd init!\n");
+
+	nbufs = clamp(nbufs, 1, MAX_NBUFS);
+	windows = clamp(windows, 1, MAX_WINS);
+
+	cur_panel = s5p_fb_find_panel(panel);
+	if (!cur_panel) {
+		printk(KERN_ERR "unknown panel %s\n", panel);
+
+		return -EINVAL;
+	}
+
+	// 1、分配一个fb_info结构
+	tiny210_fbinfo = framebuffer_alloc(sizeof(struct s5p_fb_win), NULL);
+
+	if (!tiny210_fbinfo) {
+		printk("failed to alloc framebuffer!\n");
+
+		return -ENOMEM;
+	}
+
+	win0 = tiny210_fbinfo->par;
+	win0->id = 0;
+	win0->info = tiny210_fbinfo;
+	win0->enabled = 1;
+	
+	// 2、设置
+	// 2.1 设置固定参数
+	strcpy(tiny210_fbinfo->fix.id, "tiny210_lcd");
+	tiny210_fbinfo->fix.smem_len = cur_panel->xres * cur_panel->yres * 4 * nbufs;//显存大小bytes，24bpp，nbufs帧
+	tiny210_fbinfo->fix.type = FB_TYPE_PACKED_PIXELS;
+	tiny210_fbinfo->fix.visual = FB_VISUAL_TRUECOLOR;//TFT屏幕为真彩色
+	tiny210_fbinfo->fix.line_length = cur_panel->xres * 4;//24bpp
+	tiny210_fbinfo->fix.ypanstep = 1;
+	
+	//tiny210_fbinfo->fix.accel = FB_ACCEL_NONE;
+	
+
+	// 2.2 设置可变参数
+	tiny210_fbinfo->var.xres = cur_panel->xres;
+	tiny210_fbinfo->var.yres = cur_panel->yres;
+	tiny210_fbinfo->var.xres_virtual = cur_panel->xres;
+	tiny210_fbinfo->var.yres_virtual = cur_panel->yres * nbufs;
+	tiny210_fbinfo->var.xoffset = 0;
+	tiny210_fbinfo->var.yoffset = 0;
+	tiny210_fbinfo->var.bits_per_pixel = 32;
+
+	// RGB:888
+	tiny210_fbinfo->var.red.length 		= 8;
+	tiny210_fbinfo->var.red.offset 		= 16;
+	tiny210_fbinfo->var.green.length 	= 8;
+	tiny210_fbinfo->var.green.offset 	= 8;
+	tiny210_fbinfo->var.blue.length 	= 8;
+	tiny210_fbinfo->var.blue.offset 	= 0;
+	
+	tiny210_fbinfo->var.activate = FB_ACTIVATE_NOW;
+//	tiny210_fbinfo->var.vmode = FB_VMODE_NONINTERLACED;
+	
+	// 2.3 设置操作函数
+	tiny210_fbinfo->fbops = &s5p_fb_ops;
+
+	// 2.4 其他的设置
+//	tiny210_fbinfo->flags = FBINFO_FLAG_DEFAULT;
+	tiny210_fbinfo->pseudo_palette = win0->pseudo_pal;
+	tiny210_fbinfo->screen_size = tiny210_fbinfo->fix.smem_len;//显存大小
+
+	// 3、硬件相关的操作
+	// 3.1 配置GPIO用于lcd
+	tiny210_remap_regs();
+
+	//配置引脚用于lcd
+	*gpf0con = 0x22222222;
+	*gpf1con = 0x22222222;
+	*gpf2con = 0x22222222;
+	*gpf3con = 0x22222222;
+
+	//配置背光管脚
+	*gpd0con &= (0xf << 4);
+	*gpd0con |= (1 << 4);
+//	*gpd0dat |= (1<<1);
+
+	// 3.2 使能时钟
+	//这里一定要打开lcd时钟，因为系统在初始化时默认是把lcd始终关闭的！
+	tiny210_clk = clk_get(NULL, "lcd");
+	if (!tiny210_clk || IS_ERR(tiny210_clk)) {
+		printk(KERN_INFO "failed to get lcd clock source\n");
+	}
+	//使能时钟，实际上就是设置寄存器CLK_GATE_IP1 bit0为1
+	clk_enable(tiny210_clk);
+	printk("Tiny210 LCD clock got enabled :: %ld.%03ld Mhz\n", PRINT_MHZ(clk_get_rate(tiny210_clk)));
+
+	s5p_fb_clk = tiny210_clk;
+
+	//lcd时钟就是HCLK_DSYS，VCLK从它分频
+	rate = clk_get_rate(tiny210_clk);
+	if (!rate)
+		rate = DEFAULT_HCLK;
+	clkval = s5p_fb_calc_clkval(rate);
+	s5p_fb_panel_var(&tiny210_fbinfo->var);
+
+	// 3.3 根据手册设置lcd控制器，比如VCLOCK频率，HSPW等参数
+	//10: RGB=FIMD I80=FIMD ITU=FIMD
+	*display_control = (2 << 0);
+	
+	// bit[26~28]:使用RGB接口
+	// bit[18]:RGB 并行
+	// bit[2]:选择时钟源为HCLK_DSYS=166MHz
+	*vidcon0 &= ~((3 << 26) | (1 << 18) | (1 << 2));
+
+	// bit[1]:使能lcd控制器
+	// bit[0]:当前帧结束后使能lcd控制器
+	*vidcon0 |= ((1 << 1));
+
+	// bit[4]:选择需要分频
+	// bit[6~13]:分频系数CLKVAL，VCLK = HCLK_DSYS/(CLKVAL+1)，按面板的时序和刷新率计算
+	*vidcon0 &= ~VIDCON0_CLKVAL_MASK;
+	*vidcon0 |= (VIDCON0_CLKVAL(clkval) | VIDCON0_CLKDIR);
+
+	// 同步信号和VCLK的极性，见s5p_fb_panels
+	*vidcon1 &= ~VIDCON1_INV_MASK;
+	*vidcon1 |= cur_panel->vidcon1;
+	
+	// 设置时序
+	*vidtcon0 = (((cur_panel->upper_margin - 1) << 16) | ((cur_panel->lower_margin - 1) << 8) |
+		     ((cur_panel->vsync_len - 1) << 0));
+	*vidtcon1 = (((cur_panel->left_margin - 1) << 16) | ((cur_panel->right_margin - 1) << 8) |
+		     ((cur_panel->hsync_len - 1) << 0));
+	// 设置长宽
+	*vidtcon2 = (((cur_panel->yres - 1) << 11) | ((cur_panel->xres - 1) << 0));
+
+	// 设置window0
+	// bit[0]:使能
+	// bit[2~5]:24bpp
+	//*wincon0 |= (1 << 0);
+	*wincon0 &= ~(0xf << 2);
+	*wincon0 |= ((0xB << 2) | (1 << 15));
+
+	
+	// 设置window0的上下左右
+	*vidosd0a = ((0 << 11) | (0 << 0));
+	*vidosd0b = (((cur_panel->xres - 1) << 11) | ((cur_panel->yres - 1) << 0));
+	*vidosd0c = (cur_panel->xres * cur_panel->yres);
+
+	// 3.3 分配显存(framebuffer)，并把地址告诉lcd控制器
+	tiny210_fbinfo->screen_base = dma_alloc_writecombine(NULL, PAGE_ALIGN(tiny210_fbinfo->fix.smem_len), 
+															(dma_addr_t *)&tiny210_fbinfo->fix.smem_start, GFP_KERNEL);
+	if (tiny210_fbinfo->screen_base) {
+		/* prevent initial garbage on screen */
+		printk("map_video_memory: clear %p:%08x\n",
+			tiny210_fbinfo->screen_base, tiny210_fbinfo->fix.smem_len);
+		memset(tiny210_fbinfo->screen_base, 0x00, tiny210_fbinfo->fix.smem_len);
+
+		printk("map_video_memory: dma=%08lx cpu=%p size=%08x\n",
+			tiny210_fbinfo->fix.smem_start, tiny210_fbinfo->screen_base, tiny210_fbinfo->fix.smem_len);
+	} else {
+		printk(KERN_ERR "unable to allocate screen memory\n");
+		
+		err =  -ENOMEM;
+		goto unmap_regs;
+	}
+
+	// 设置fb的地址，先显示第0帧
+	*vidw00add0b0 = tiny210_fbinfo->fix.smem_start;
+	*vidw00add1b0 = tiny210_fbinfo->fix.smem_start + tiny210_fbinfo->fix.line_length * cur_panel->yres;
+
+	//使能lcd控制器
+	*vidcon0 |= (1 << 0);
+	*wincon0 |= (1 << 0);
+	// 使能channel 0传输数据
+	*shadowcon = 0x1;
+	//打开背光
+	*gpd0dat |= (1 << 1);
+
+	// 3.4 VSYNC中断
+	err = request_irq(IRQ_LCD1, s5p_fb_irq, 0, "s5p_fb", NULL);
+	if (err) {
+		printk(KERN_ERR "failed to request lcd irq\n");
+
+		goto free_dma_buffer;
+	}
+	*vidintcon1 = VIDINTCON1_INT_FRAME;
+	*vidintcon0 &= ~VIDINTCON0_FRAMESEL0_MASK;
+	*vidintcon0 |= (VIDINTCON0_INT_ENABLE | VIDINTCON0_INT_FRAME | VIDINTCON0_FRAMESEL0_VSYNC);
+
+	//FIFO下溢中断只用于统计，拿不到也能工作
+	if (request_irq(IRQ_LCD0, s5p_fb_fifo_irq, 0, "s5p_fb_fifo", NULL)) {
+		printk(KERN_INFO "failed to request lcd fifo irq\n");
+	} else {
+		s5p_fb_fifo_irq_on = 1;
+		*vidintcon1 = VIDINTCON1_INT_FIFO;
+		*vidintcon0 &= ~(VIDINTCON0_FIFOLEVEL_MASK | VIDINTCON0_FIFOSEL_MASK);
+		*vidintcon0 |= (VIDINTCON0_FIFOLEVEL_EMPTY | VIDINTCON0_FIFOSEL_ALL | VIDINTCON0_INT_FIFO);
+	}
+
+	// 4、注册
+	err = register_framebuffer(tiny210_fbinfo);
+	if (err < 0) {
+		pr_err("unable to register framebuffer\n");
+
+		err = -EINVAL;
+		goto free_irq;
+	}
+
+	if (device_create_file(tiny210_fbinfo->dev, &dev_attr_vsync_event))
+		printk(KERN_INFO "failed to create vsync_event\n");
+
+	s5p_fb_debugfs = debugfs_create_dir("s5p_fb", NULL);
+	if (!IS_ERR_OR_NULL(s5p_fb_debugfs))
+		debugfs_create_file("stats", S_IRUSR | S_IWUSR, s5p_fb_debugfs, NULL, &s5p_fb_stats_fops);
+
+	//叠加窗口是辅助功能，显存不够时少注册几个
+	for (i = 1; i < windows; i++) {
+		err = s5p_fb_win_create(i);
+		if (err) {
+			printk(KERN_INFO "failed to create window %d: %d\n", i, err);
+			break;
+		}
+	}
+
+	return 0;
+
+free_irq:
+	*vidintcon0 &= ~(VIDINTCON0_INT_ENABLE | VIDINTCON0_INT_FRAME | VIDINTCON0_INT_FIFO);
+	if (s5p_fb_fifo_irq_on)
+		free_irq(IRQ_LCD0, NULL);
+	s5p_fb_fifo_irq_on = 0;
+	free_irq(IRQ_LCD1, NULL);
+	cancel_work_sync(&s5p_fb_vsync_work);
+free_dma_buffer:
+	dma_free_writecombine(NULL, tiny210_fbinfo->fix.smem_len, tiny210_fbinfo->screen_base, tiny210_fbinfo->fix.smem_start);
+	//关闭lcd控制器
+	*vidcon0 &= ~(1 << 0);
+	*wincon0 &= ~(1 << 0);
+	// 关闭channel 0传输数据
+	*shadowcon &= ~0x1;
+	//关闭背光
+	*gpd0dat &= ~(1 << 1);
+unmap_regs:
+	tiny210_unmap_regs();
+	framebuffer_release(tiny210_fbinfo);
+
+	return err;
+}
+
+static void __exit tiny210_lcdfb_exit(void)
+{
+	int i;
+	
+	//下面要访问寄存器，时钟关着时先打开
+	mutex_lock(&s5p_fb_lock);
+	if (s5p_fb_power == S5P_FB_POWER_CLK_OFF) {
+		if (!IS_ERR_OR_NULL(s5p_fb_clk))
+			clk_enable(s5p_fb_clk);
+		s5p_fb_set_power(S5P_FB_POWER_VIDEO_OFF);
+	}
+	mutex_unlock(&s5p_fb_lock);
+
+	for (i = MAX_WINS - 1; i > 0; i--)
+		s5p_fb_win_destroy(i);
+
+	debugfs_remove_recursive(s5p_fb_debugfs);
+	device_remove_file(tiny210_fbinfo->dev, &dev_attr_vsync_event);
+	*vidintcon0 &= ~(VIDINTCON0_INT_ENABLE | VIDINTCON0_INT_FRAME | VIDINTCON0_INT_FIFO);
+	if (s5p_fb_fifo_irq_on)
+		free_irq(IRQ_LCD0, NULL);
+	s5p_fb_fifo_irq_on = 0;
+	free_irq(IRQ_LCD1, NULL);
+	cancel_work_sync(&s5p_fb_vsync_work);
+
+	unregister_framebuffer(tiny210_fbinfo);
+	dma_free_writecombine(NULL, tiny210_fbinfo->fix.smem_len, tiny210_fbinfo->screen_base, tiny210_fbinfo->fix.smem_start);
+	
+	//关闭lcd控制器
+	*vidcon0 &= ~(1 << 0);
+	*wincon0 &= ~(1 << 0);
+	// 关闭channel 0传输数据
+	*shadowcon &= ~0x1;
+	//关闭背光
+	*gpd0dat &= ~(1 << 1);
+
+	//关闭时钟，和init里的clk_enable对应
+	if (!IS_ERR_OR_NULL(s5p_fb_clk)) {
+		clk_disable(s5p_fb_clk);
+		clk_put(s5p_fb_clk);
+	}
+	tiny210_unmap_regs();
+	framebuffer_release(tiny210_fbinfo);
+}
+
+module_init(tiny210_lcdfb_init);
+module_exit(tiny210_lcdfb_exit);
+
+MODULE_AUTHOR("Nick <hbjsxieqi@163.com>");
+MODULE_DESCRIPTION("TINY210 LCD Driver");
+MODULE_LICENSE("GPL");
+
+
@@ -0,0 +1,247 @@
+/*
+ * s5p_fb的画图函数
+ *
+ * cfb_*按任意bpp写成逐个unsigned long的位流运算，每个字都要移位、拼接、掩码
+ * 这里只处理16bpp和32bpp，像素和字对齐:
+ *   填充: 16bpp先把像素复制成一个字，每行处理完不对齐的头尾后按8个字一组写，
+ *         编译器生成stm，一次突发写32字节
+ *   复制: 按行memcpy/memmove(内核里是ldm/stm的汇编实现)，目标在源下面时从最后一行往上复制，
+ *         整行复制并且行之间没有空隙(控制台滚屏)时整块一次memmove
+ *   单色位图: 字体每4个bit查一次表得到4个像素，前景/背景色不变时表不用重建
+ * 2.6/3.0的ARM内核不能在内核态使用NEON，这里全部是普通的字操作
+ */
+#ifdef __KERNEL__
+#include <linux/kernel.h>
+#include <linux/string.h>
+#else
+#include <string.h>
+#endif
+
+#include "s5p_fb_draw.h"
+
+static void fill_words(u32 *p, int n, u32 v)
+{
+	while (n >= 8) {
+		p[0] = v;
+		p[1] = v;
+		p[2] = v;
+		p[3] = v;
+		p[4] = v;
+		p[5] = v;
+		p[6] = v;
+		p[7] = v;
+		p += 8;
+		n -= 8;
+	}
+
+	while (n-- > 0)
+		*p++ = v;
+}
+
+static void xor_words(u32 *p, int n, u32 v)
+{
+	while (n >= 4) {
+		p[0] ^= v;
+		p[1] ^= v;
+		p[2] ^= v;
+		p[3] ^= v;
+		p += 4;
+		n -= 4;
+	}
+
+	while (n-- > 0)
+		*p++ ^= v;
+}
+
+void s5p_draw_fill(const struct s5p_draw_surf *s, int x, int y, int w, int h,
+		   u32 pixel, int rop_xor)
+{
+	u8 *row = s->base + y * s->stride;
+	u16 *p;
+	u32 v;
+	int n;
+
+	if (w <= 0 || h <= 0)
+		return;
+
+	if (s->bpp == 32) {
+		for (; h > 0; h--, row += s->stride) {
+			if (rop_xor)
+				xor_words((u32 *)row + x, w, pixel);
+			else
+				fill_words((u32 *)row + x, w, pixel);
+		}
+		return;
+	}
+
+	pixel &= 0xffff;
+	v = pixel | (pixel << 16);
+
+	for (; h > 0; h--, row += s->stride) {
+		p = (u16 *)row + x;
+		n = w;
+
+		//不对齐的第一个像素
+		if (((unsigned long)p & 2) && n) {
+			*p = rop_xor ? (*p ^ pixel) : pixel;
+			p++;
+			n--;
+		}
+
+		if (rop_xor)
+			xor_words((u32 *)p, n / 2, v);
+		else
+			fill_words((u32 *)p, n / 2, v);
+
+		if (n & 1) {
+			p += n - 1;
+			*p = rop_xor ? (*p ^ pixel) : pixel;
+		}
+	}
+}
+
+void s5p_draw_copy(const struct s5p_draw_surf *s, int dx, int dy,
+		   int sx, int sy, int w, int h)
+{
+	int bytes = s->bpp / 8;
+	int len = w * bytes;
+	u8 *dst = s->base + dy * s->stride + dx * bytes;
+	u8 *src = s->base + sy * s->stride + sx * bytes;
+
+	if (w <= 0 || h <= 0)
+		return;
+
+	//整行，行与行之间连续
+	if (len == s->stride) {
+		memmove(dst, src, h * len);
+		return;
+	}
+
+	if (dy == sy) {
+		//同一行里左右移动，源和目标重叠
+		for (; h > 0; h--, dst += s->stride, src += s->stride)
+			memmove(dst, src, len);
+	} else if (dy > sy) {
+		dst += (h - 1) * s->stride;
+		src += (h - 1) * s->stride;
+		for (; h > 0; h--, dst -= s->stride, src -= s->stride)
+			memcpy(dst, src, len);
+	} else {
+		for (; h > 0; h--, dst += s->stride, src += s->stride)
+			memcpy(dst, src, len);
+	}
+}
+
+static void build_tab(struct s5p_draw_ctx *ctx, int bpp, u32 fg, u32 bg)
+{
+	u32 px[4];
+	int n, i;
+
+	if (bpp == 16) {
+		fg &= 0xffff;
+		bg &= 0xffff;
+	}
+
+	for (n = 0; n < 16; n++) {
+		for (i = 0; i < 4; i++)
+			px[i] = (n & (8 >> i)) ? fg : bg;
+
+		if (bpp == 32) {
+			memcpy(ctx->tab[n], px, sizeof(px));
+		} else {
+			//小端: 左边的像素在低16位
+			ctx->tab[n][0] = px[0] | (px[1] << 16);
+			ctx->tab[n][1] = px[2] | (px[3] << 16);
+		}
+	}
+
+	ctx->bpp = bpp;
+	ctx->fg = fg;
+	ctx->bg = bg;
+	ctx->valid = 1;
+}
+
+static void mono_row32(struct s5p_draw_ctx *ctx, u32 *p, const u8 *src, int w)
+{
+	const u32 *t;
+	int i;
+	u8 b;
+
+	for (; w >= 8; w -= 8, p += 8) {
+		b = *src++;
+		t = ctx->tab[b >> 4];
+		p[0] = t[0];
+		p[1] = t[1];
+		p[2] = t[2];
+		p[3] = t[3];
+		t = ctx->tab[b & 0xf];
+		p[4] = t[0];
+		p[5] = t[1];
+		p[6] = t[2];
+		p[7] = t[3];
+	}
+
+	for (i = 0; i < w; i++)
+		p[i] = (*src & (0x80 >> i)) ? ctx->fg : ctx->bg;
+}
+
+static void mono_row16(struct s5p_draw_ctx *ctx, u16 *p, const u8 *src, int w)
+{
+	const u32 *t;
+	u32 *q;
+	int i;
+	u8 b;
+
+	if (!((unsigned long)p & 2)) {
+		for (q = (u32 *)p; w >= 8; w -= 8, q += 4) {
+			b = *src++;
+			t = ctx->tab[b >> 4];
+			q[0] = t[0];
+			q[1] = t[1];
+			t = ctx->tab[b & 0xf];
+			q[2] = t[0];
+			q[3] = t[1];
+		}
+		p = (u16 *)q;
+	} else {
+		//x是奇数，按半字写
+		for (; w >= 8; w -= 8, p += 8) {
+			b = *src++;
+			t = ctx->tab[b >> 4];
+			p[0] = t[0];
+			p[1] = t[0] >> 16;
+			p[2] = t[1];
+			p[3] = t[1] >> 16;
+			t = ctx->tab[b & 0xf];
+			p[4] = t[0];
+			p[5] = t[0] >> 16;
+			p[6] = t[1];
+			p[7] = t[1] >> 16;
+		}
+	}
+
+	for (i = 0; i < w; i++)
+		p[i] = (*src & (0x80 >> i)) ? ctx->fg : ctx->bg;
+}
+
+void s5p_draw_mono(struct s5p_draw_ctx *ctx, const struct s5p_draw_surf *s,
+		   int x, int y, int w, int h, const u8 *bits, int pitch,
+		   u32 fg, u32 bg)
+{
+	u8 *row = s->base + y * s->stride;
+
+	if (s->bpp == 16) {
+		fg &= 0xffff;
+		bg &= 0xffff;
+	}
+
+	if (!ctx->valid || ctx->bpp != s->bpp || ctx->fg != fg || ctx->bg != bg)
+		build_tab(ctx, s->bpp, fg, bg);
+
+	for (; h > 0; h--, row += s->stride, bits += pitch) {
+		if (s->bpp == 32)
+			mono_row32(ctx, (u32 *)row + x, bits, w);
+		else
+			mono_row16(ctx, (u16 *)row + x, bits, w);
+	}
+}
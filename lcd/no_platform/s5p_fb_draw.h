@@ -0,0 +1,41 @@
+/*
+ * s5p_fb的画图函数: 填充矩形、复制区域、单色位图(字体)展开
+ * 只处理这个驱动用到的16bpp和32bpp，不依赖内核，可以在PC上测试(draw_bench)
+ */
+#ifndef __S5P_FB_DRAW_H
+#define __S5P_FB_DRAW_H
+
+#ifdef __KERNEL__
+#include <linux/types.h>
+#else
+#include <stdint.h>
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+#endif
+
+struct s5p_draw_surf {
+	u8 *base;
+	u32 stride;		//一行的字节数，4的倍数
+	int bpp;		//16或32
+};
+
+//单色位图展开用的表，前景/背景色不变时不用重建
+struct s5p_draw_ctx {
+	int bpp;
+	u32 fg;
+	u32 bg;
+	int valid;
+	u32 tab[16][4];		//4个bit对应的4个像素(16bpp时前两个字是4个像素)
+};
+
+void s5p_draw_fill(const struct s5p_draw_surf *s, int x, int y, int w, int h,
+		   u32 pixel, int rop_xor);
+void s5p_draw_copy(const struct s5p_draw_surf *s, int dx, int dy,
+		   int sx, int sy, int w, int h);
+//bits每行pitch字节，最高位是最左边的像素
+void s5p_draw_mono(struct s5p_draw_ctx *ctx, const struct s5p_draw_surf *s,
+		   int x, int y, int w, int h, const u8 *bits, int pitch,
+		   u32 fg, u32 bg);
+
+#endif
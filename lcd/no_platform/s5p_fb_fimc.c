@@ -0,0 +1,201 @@
+/*
+ * FIMC2做YUV->RGB转换，结果经local path(FIFO)送给FIMD的window2，不经过内存
+ *
+ * 输入DMA从显存读NV12(Y平面+CbCr交错平面)或YUYV，缩放器1:1，
+ * CSC转换成RGB888后输出到FIFO，FIMD那边window2打开ENLOCAL直接接收
+ * FIMC2可能被摄像头驱动使用，只在窗口切换到YUV时才申请寄存器和时钟，
+ * 内核里编了s5p-fimc驱动时它在probe时就占了寄存器区域，这里申请失败返回EBUSY;
+ * 没有申请寄存器区域就直接用FIMC2的驱动(bootloader的camera预览等)从寄存器状态判断，正在用就不复位
+ * 寄存器见s5pv210芯片手册的Camera Interface一章
+ */
+#include <linux/kernel.h>
+#include <linux/errno.h>
+#include <linux/io.h>
+#include <linux/ioport.h>
+#include <linux/clk.h>
+#include <linux/err.h>
+#include <linux/delay.h>
+
+#include "s5p_fb.h"
+#include "s5p_fb_fimc.h"
+
+#define FIMC2_BASE		(0xFB400000)
+#define FIMC_SIZE		(0x1000)
+
+#define CIGCTRL			(0x08)
+#define CIGCTRL_SWRST		(1 << 31)
+#define CIGCTRL_IRQ_ENABLE	(1 << 16)
+#define CIGCTRL_IRQ_LEVEL	(1 << 20)
+
+#define CITRGFMT		(0x48)
+#define CITRGFMT_OUT_RGB	(3 << 29)
+#define CITRGFMT_HSIZE(x)	((x) << 16)
+#define CITRGFMT_VSIZE(x)	((x) << 0)
+
+#define CISCPRERATIO		(0x50)
+#define CISCPREDST		(0x54)
+
+#define CISCCTRL		(0x58)
+#define CISCCTRL_CSCY2R_WIDE	(1 << 27)	//全范围YCbCr(0~255)，清0是BT.601有限范围
+#define CISCCTRL_LCDPATHEN	(1 << 26)	//输出到FIFO
+#define CISCCTRL_MAIN_H(x)	((x) << 16)
+#define CISCCTRL_SCALERSTART	(1 << 15)
+#define CISCCTRL_OUTRGB_888	(2 << 11)
+#define CISCCTRL_MAIN_V(x)	((x) << 0)
+
+#define CITAREA			(0x5C)
+
+#define CIIMGCPT		(0xC0)
+#define CIIMGCPT_EN		(1 << 31)
+#define CIIMGCPT_EN_SC		(1 << 30)
+
+#define CIIYSA0			(0xD4)
+#define CIICBSA0		(0xD8)
+
+#define CIREAL_ISIZE		(0xF8)
+#define CIREAL_ISIZE_AUTOLOAD	(1 << 31)
+
+#define MSCTRL			(0xFC)
+#define MSCTRL_BURST(x)		((x) << 24)
+#define MSCTRL_C_2PLANE		(1 << 15)
+#define MSCTRL_ORDER_YCBYCR	(0 << 4)
+#define MSCTRL_INPUT_MEMORY	(1 << 3)
+#define MSCTRL_IN_YCBCR420	(0 << 1)
+#define MSCTRL_IN_YCBCR422_1P	(2 << 1)
+#define MSCTRL_ENVID		(1 << 0)
+
+#define ORGISIZE		(0x194)
+
+static void __iomem *fimc_regs;
+static struct clk *fimc_clk;
+
+#define fimc_readl(ofs)		readl(fimc_regs + (ofs))
+#define fimc_writel(val, ofs)	writel(val, fimc_regs + (ofs))
+
+static void s5p_fimc_reset(void)
+{
+	fimc_writel(fimc_readl(CIGCTRL) | CIGCTRL_SWRST, CIGCTRL);
+	udelay(10);
+	fimc_writel(CIGCTRL_IRQ_LEVEL, CIGCTRL);
+}
+
+//输入DMA、捕获或者中断已经打开，说明有别的驱动在用
+static int s5p_fimc_busy(void)
+{
+	return (fimc_readl(CIGCTRL) & CIGCTRL_IRQ_ENABLE) ||
+	       (fimc_readl(CIIMGCPT) & CIIMGCPT_EN) ||
+	       (fimc_readl(MSCTRL) & MSCTRL_ENVID);
+}
+
+static int s5p_fimc_get(void)
+{
+	int ret;
+
+	if (!request_mem_region(FIMC2_BASE, FIMC_SIZE, "s5p_fb_fimc")) {
+		printk(KERN_ERR "FIMC2 registers at 0x%08x are claimed by another driver "
+		       "(s5p-fimc built in?), YUV windows are not available\n", FIMC2_BASE);
+
+		return -EBUSY;
+	}
+
+	fimc_regs = ioremap(FIMC2_BASE, FIMC_SIZE);
+	if (!fimc_regs) {
+		ret = -ENOMEM;
+		goto err_region;
+	}
+
+	fimc_clk = clk_get_sys("s5pv210-fimc.2", "fimc");
+	if (IS_ERR(fimc_clk))
+		fimc_clk = clk_get(NULL, "fimc");
+	if (!IS_ERR(fimc_clk))
+		clk_enable(fimc_clk);
+
+	if (s5p_fimc_busy()) {
+		printk(KERN_ERR "FIMC2 is running (CIGCTRL 0x%08x, MSCTRL 0x%08x), not resetting it\n",
+		       fimc_readl(CIGCTRL), fimc_readl(MSCTRL));
+		ret = -EBUSY;
+		goto err_busy;
+	}
+
+	return 0;
+
+err_busy:
+	if (!IS_ERR(fimc_clk)) {
+		clk_disable(fimc_clk);
+		clk_put(fimc_clk);
+	}
+	iounmap(fimc_regs);
+	fimc_regs = NULL;
+err_region:
+	release_mem_region(FIMC2_BASE, FIMC_SIZE);
+
+	return ret;
+}
+
+void s5p_fimc_local_set_addr(u32 paddr_y, u32 paddr_c)
+{
+	//输入DMA每一帧开始时取这两个地址
+	fimc_writel(paddr_y, CIIYSA0);
+	fimc_writel(paddr_c, CIICBSA0);
+}
+
+int s5p_fimc_local_start(const struct s5p_fimc_src *src)
+{
+	u32 w = src->width, h = src->height;
+	u32 msctrl, orgw;
+	u32 csc = src->full_range ? CISCCTRL_CSCY2R_WIDE : 0;
+	int ret;
+
+	//已经是自己在用(换了分辨率/格式重新启动)时直接复位
+	if (!fimc_regs) {
+		ret = s5p_fimc_get();
+		if (ret)
+			return ret;
+	}
+
+	s5p_fimc_reset();
+
+	if (src->nonstd == S5P_FB_NONSTD_NV12) {
+		msctrl = MSCTRL_IN_YCBCR420 | MSCTRL_C_2PLANE;
+		orgw = src->stride;
+	} else {
+		msctrl = MSCTRL_IN_YCBCR422_1P | MSCTRL_ORDER_YCBYCR;
+		orgw = src->stride / 2;
+	}
+
+	//输入: 原图宽度按一行的像素数，DMA只读w x h
+	fimc_writel((h << 16) | orgw, ORGISIZE);
+	fimc_writel(CIREAL_ISIZE_AUTOLOAD | (h << 16) | w, CIREAL_ISIZE);
+	s5p_fimc_local_set_addr(src->paddr_y, src->paddr_c);
+
+	//缩放器1:1: 预缩放比例1，SHfactor = 10，主缩放比例 = 1 << 8
+	fimc_writel((10 << 28) | (1 << 16) | 1, CISCPRERATIO);
+	fimc_writel((w << 16) | h, CISCPREDST);
+	fimc_writel(CITRGFMT_OUT_RGB | CITRGFMT_HSIZE(w) | CITRGFMT_VSIZE(h), CITRGFMT);
+	fimc_writel(w * h, CITAREA);
+	fimc_writel(csc | CISCCTRL_LCDPATHEN | CISCCTRL_OUTRGB_888 |
+		    CISCCTRL_MAIN_H(1 << 8) | CISCCTRL_MAIN_V(1 << 8) | CISCCTRL_SCALERSTART, CISCCTRL);
+
+	fimc_writel(CIIMGCPT_EN | CIIMGCPT_EN_SC, CIIMGCPT);
+	fimc_writel(msctrl | MSCTRL_BURST(4) | MSCTRL_INPUT_MEMORY | MSCTRL_ENVID, MSCTRL);
+
+	return 0;
+}
+
+void s5p_fimc_local_stop(void)
+{
+	if (!fimc_regs)
+		return;
+
+	fimc_writel(fimc_readl(MSCTRL) & ~MSCTRL_ENVID, MSCTRL);
+	fimc_writel(0, CIIMGCPT);
+	fimc_writel(fimc_readl(CISCCTRL) & ~(CISCCTRL_SCALERSTART | CISCCTRL_LCDPATHEN), CISCCTRL);
+
+	if (!IS_ERR(fimc_clk)) {
+		clk_disable(fimc_clk);
+		clk_put(fimc_clk);
+	}
+	iounmap(fimc_regs);
+	fimc_regs = NULL;
+	release_mem_region(FIMC2_BASE, FIMC_SIZE);
+}
@@ -0,0 +1,24 @@
+/*
+ * FIMC2的local path: 从内存读YUV，转换成RGB888后经FIFO直接送给FIMD的window2
+ * 只在s5p_fb内部使用
+ */
+#ifndef __S5P_FB_FIMC_H
+#define __S5P_FB_FIMC_H
+
+#include <linux/types.h>
+
+struct s5p_fimc_src {
+	u32 nonstd;		//S5P_FB_NONSTD_NV12/YUYV
+	int full_range;		//YCbCr是0~255，否则按BT.601的16~235/16~240
+	int width;
+	int height;
+	u32 stride;		//Y平面(NV12)或者整行(YUYV)的字节数
+	u32 paddr_y;
+	u32 paddr_c;		//NV12的CbCr平面，YUYV不用
+};
+
+int s5p_fimc_local_start(const struct s5p_fimc_src *src);
+void s5p_fimc_local_set_addr(u32 paddr_y, u32 paddr_c);
+void s5p_fimc_local_stop(void);
+
+#endif
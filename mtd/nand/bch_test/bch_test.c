@@ -0,0 +1,351 @@
+/*
+ * bch_test: 在PC上验证和测速s5p_nand_bch.c(驱动里用的同一份代码)
+ *
+ * 用法: bch_test [-i iterations] [-s seed]
+ *
+ * 对t = 4..8分别检查:
+ *   1. 生成多项式: 次数为13t，alpha^1..alpha^2t都是根(用逐bit的GF乘法验证，不用查表)
+ *   2. 编码: 查表编码和逐bit LFSR参考编码的结果一致，码字在alpha^1..alpha^2t处为0
+ *   3. 擦除页: 全0xff数据的ECC全是0xff，擦除页上的bitflip可以纠正
+ *   4. 纠错: 数据和ECC中随机翻转0..t个bit，都能纠正并恢复原数据
+ *   5. t+1个错: 统计检测出的比例(BCH超出纠错能力时可能误纠，只报告不算失败)
+ * 最后输出查表编码/参考编码的速度和纠t个错的耗时
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "s5p_nand_bch.h"
+
+#define DATA_BYTES	S5P_BCH_DATA_BYTES
+#define DATA_BITS	(DATA_BYTES * 8)
+
+static int failures;
+
+#define CHECK(cond, fmt, ...)							\
+	do {									\
+		if (!(cond)) {							\
+			failures++;						\
+			printf("  FAIL t=%d: " fmt "\n", bch->t, ##__VA_ARGS__);\
+		}								\
+	} while (0)
+
+static double now_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0;
+}
+
+//参考实现: 逐bit的GF(2^13)乘法
+static u16 ref_gf_mul(u16 a, u16 b)
+{
+	u32 x = a;
+	u32 r = 0;
+
+	while (b) {
+		if (b & 1)
+			r ^= x;
+		b >>= 1;
+		x <<= 1;
+		if (x & (1 << S5P_BCH_M))
+			x ^= S5P_BCH_PRIM_POLY;
+	}
+
+	return r;
+}
+
+static u16 ref_alpha_pow(int j)
+{
+	u16 x = 1;
+
+	while (j--)
+		x = ref_gf_mul(x, 2);
+
+	return x;
+}
+
+//生成多项式的系数g[0..r]，g[r] = 1
+static void get_genpoly(struct s5p_bch *bch, u8 *g)
+{
+	int r = bch->ecc_bits;
+	int i;
+
+	memset(g, 0, r + 1);
+	g[r] = 1;
+	for (i = 0; i < r; i++)
+		g[r - 1 - i] = (bch->genpoly[i / 32] >> (31 - i % 32)) & 1;
+}
+
+//参考编码: 逐bit LFSR，结果异或擦除页掩码(也由参考实现计算)
+static void ref_parity(struct s5p_bch *bch, const u8 *g, const u8 *data, u8 *par)
+{
+	int r = bch->ecc_bits;
+	u8 reg[S5P_BCH_M * S5P_BCH_MAX_T];	//reg[i]是x^i的系数
+	int i, k, fb;
+
+	memset(reg, 0, sizeof(reg));
+	for (i = 0; i < DATA_BITS; i++) {
+		fb = reg[r - 1] ^ ((data[i / 8] >> (7 - i % 8)) & 1);
+		for (k = r - 1; k > 0; k--)
+			reg[k] = reg[k - 1] ^ (fb & g[k]);
+		reg[0] = fb & g[0];
+	}
+
+	memset(par, 0, bch->ecc_bytes);
+	for (i = 0; i < r; i++)
+		if (reg[r - 1 - i])
+			par[i / 8] |= 0x80 >> (i % 8);
+}
+
+static void ref_encode(struct s5p_bch *bch, const u8 *g, const u8 *data, u8 *ecc)
+{
+	u8 ff[DATA_BYTES];
+	u8 mask[S5P_BCH_MAX_ECC_BYTES];
+	int i;
+
+	memset(ff, 0xff, sizeof(ff));
+	ref_parity(bch, g, ff, mask);
+	ref_parity(bch, g, data, ecc);
+	for (i = 0; i < bch->ecc_bytes; i++)
+		ecc[i] ^= ~mask[i];
+}
+
+//码字c(x) = d(x) x^r + p(x)在alpha^j处的值，Horner法从最高次开始
+static u16 ref_eval(struct s5p_bch *bch, const u8 *data, const u8 *par, int j)
+{
+	u16 aj = ref_alpha_pow(j);
+	u16 v = 0;
+	int i;
+
+	for (i = 0; i < DATA_BITS; i++)
+		v = ref_gf_mul(v, aj) ^ ((data[i / 8] >> (7 - i % 8)) & 1);
+	for (i = 0; i < bch->ecc_bits; i++)
+		v = ref_gf_mul(v, aj) ^ ((par[i / 8] >> (7 - i % 8)) & 1);
+
+	return v;
+}
+
+static void random_fill(u8 *buf, int len)
+{
+	int i;
+
+	for (i = 0; i < len; i++)
+		buf[i] = rand();
+}
+
+//在数据+ECC的DATA_BITS + ecc_bits个bit中选n个不同的位置翻转
+static void flip_bits(struct s5p_bch *bch, u8 *data, u8 *ecc, int n)
+{
+	int total = DATA_BITS + bch->ecc_bits;
+	int pos[S5P_BCH_MAX_T + 1];
+	int i, j, p;
+
+	for (i = 0; i < n; i++) {
+again:
+		p = rand() % total;
+		for (j = 0; j < i; j++)
+			if (pos[j] == p)
+				goto again;
+		pos[i] = p;
+
+		if (p < DATA_BITS)
+			data[p / 8] ^= 0x80 >> (p % 8);
+		else
+			ecc[(p - DATA_BITS) / 8] ^= 0x80 >> ((p - DATA_BITS) % 8);
+	}
+}
+
+static void test_genpoly(struct s5p_bch *bch, const u8 *g)
+{
+	int r = bch->ecc_bits;
+	int j, i;
+	u16 v, x;
+
+	CHECK(r == S5P_BCH_M * bch->t, "genpoly degree %d", r);
+
+	for (j = 1; j <= 2 * bch->t; j++) {
+		x = ref_alpha_pow(j);
+		v = 0;
+		for (i = r; i >= 0; i--)
+			v = ref_gf_mul(v, x) ^ g[i];
+		CHECK(v == 0, "alpha^%d is not a root of g(x)", j);
+	}
+}
+
+static void test_encode(struct s5p_bch *bch, const u8 *g, int iterations)
+{
+	u8 data[DATA_BYTES];
+	u8 ecc[S5P_BCH_MAX_ECC_BYTES], ref[S5P_BCH_MAX_ECC_BYTES];
+	u8 par[S5P_BCH_MAX_ECC_BYTES];
+	int i, j, k;
+
+	for (i = 0; i < iterations; i++) {
+		random_fill(data, sizeof(data));
+		//稀疏的数据也要覆盖到
+		if (i % 4 == 1)
+			for (k = 0; k < DATA_BYTES; k++)
+				data[k] &= (rand() % 16) ? 0x00 : 0xff;
+
+		s5p_bch_encode(bch, data, ecc);
+		ref_encode(bch, g, data, ref);
+		if (memcmp(ecc, ref, bch->ecc_bytes)) {
+			CHECK(0, "encode mismatch on iteration %d", i);
+			return;
+		}
+
+		//码字在alpha^j处为0，逐bit计算比较慢，只做几次
+		if (i < 4) {
+			ref_parity(bch, g, data, par);
+			for (j = 1; j <= 2 * bch->t; j++)
+				CHECK(ref_eval(bch, data, par, j) == 0, "codeword nonzero at alpha^%d", j);
+		}
+	}
+}
+
+static void test_erased(struct s5p_bch *bch)
+{
+	u8 data[DATA_BYTES], ecc[S5P_BCH_MAX_ECC_BYTES], calc[S5P_BCH_MAX_ECC_BYTES];
+	int i, ret;
+
+	memset(data, 0xff, sizeof(data));
+	s5p_bch_encode(bch, data, ecc);
+	for (i = 0; i < bch->ecc_bytes; i++)
+		CHECK(ecc[i] == 0xff, "erased page ecc[%d] = %02x", i, ecc[i]);
+
+	CHECK(s5p_bch_correct(bch, data, ecc, ecc) == 0, "erased page reported errors");
+
+	flip_bits(bch, data, ecc, bch->t);
+	s5p_bch_encode(bch, data, calc);
+	ret = s5p_bch_correct(bch, data, ecc, calc);
+	CHECK(ret == bch->t, "erased page with %d flips: ret %d", bch->t, ret);
+	for (i = 0; i < DATA_BYTES; i++)
+		if (data[i] != 0xff)
+			break;
+	CHECK(i == DATA_BYTES, "erased page not restored");
+}
+
+static void test_correct(struct s5p_bch *bch, int iterations)
+{
+	u8 orig[DATA_BYTES], data[DATA_BYTES];
+	u8 ecc[S5P_BCH_MAX_ECC_BYTES], calc[S5P_BCH_MAX_ECC_BYTES];
+	int detected = 0;
+	int n, i, ret;
+
+	for (n = 0; n <= bch->t + 1; n++) {
+		for (i = 0; i < iterations; i++) {
+			random_fill(orig, sizeof(orig));
+			s5p_bch_encode(bch, orig, ecc);
+			memcpy(data, orig, sizeof(data));
+
+			flip_bits(bch, data, ecc, n);
+			s5p_bch_encode(bch, data, calc);
+			ret = s5p_bch_correct(bch, data, ecc, calc);
+
+			if (n > bch->t) {
+				detected += (ret < 0);
+				continue;
+			}
+
+			if (ret != n || memcmp(data, orig, sizeof(data))) {
+				CHECK(0, "%d errors: ret %d, data %s", n, ret,
+				      memcmp(data, orig, sizeof(data)) ? "wrong" : "ok");
+				break;
+			}
+		}
+	}
+
+	printf("  %d errors: %d/%d detected\n", bch->t + 1, detected, iterations);
+}
+
+static void bench(struct s5p_bch *bch, const u8 *g)
+{
+	u8 data[DATA_BYTES], orig[DATA_BYTES];
+	u8 ecc[S5P_BCH_MAX_ECC_BYTES], calc[S5P_BCH_MAX_ECC_BYTES];
+	int rounds = 20000;
+	double start, fast, ref, dec;
+	int i;
+
+	random_fill(orig, sizeof(orig));
+
+	start = now_us();
+	for (i = 0; i < rounds; i++) {
+		orig[0] = i;
+		s5p_bch_encode(bch, orig, ecc);
+	}
+	fast = now_us() - start;
+
+	start = now_us();
+	for (i = 0; i < rounds / 100; i++) {
+		orig[0] = i;
+		ref_encode(bch, g, orig, ecc);
+	}
+	ref = (now_us() - start) * 100;
+
+	start = now_us();
+	for (i = 0; i < rounds / 10; i++) {
+		memcpy(data, orig, sizeof(data));
+		s5p_bch_encode(bch, orig, ecc);
+		flip_bits(bch, data, ecc, bch->t);
+		s5p_bch_encode(bch, data, calc);
+		s5p_bch_correct(bch, data, ecc, calc);
+	}
+	dec = (now_us() - start) / (rounds / 10);
+
+	printf("  encode %.1f MB/s (reference %.1f MB/s), correct %d errors %.1f us/512B\n",
+	       rounds * DATA_BYTES / fast, rounds * DATA_BYTES / ref, bch->t, dec);
+}
+
+int main(int argc, char **argv)
+{
+	static struct s5p_bch bch_buf;
+	struct s5p_bch *bch = &bch_buf;
+	u8 g[S5P_BCH_M * S5P_BCH_MAX_T + 1];
+	int iterations = 1000;
+	unsigned int seed = time(NULL);
+	int opt;
+	int t;
+
+	while ((opt = getopt(argc, argv, "i:s:")) != -1) {
+		switch (opt) {
+		case 'i':
+			iterations = atoi(optarg);
+			break;
+		case 's':
+			seed = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			fprintf(stderr, "Usage: %s [-i iterations] [-s seed]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	printf("seed %u, %d iterations\n", seed, iterations);
+	srand(seed);
+
+	for (t = S5P_BCH_MIN_T; t <= S5P_BCH_MAX_T; t++) {
+		if (s5p_bch_init(bch, t)) {
+			printf("t=%d: init failed\n", t);
+			failures++;
+			continue;
+		}
+
+		printf("t=%d: %d ecc bytes per %d bytes\n", t, bch->ecc_bytes, DATA_BYTES);
+		get_genpoly(bch, g);
+
+		test_genpoly(bch, g);
+		test_encode(bch, g, iterations);
+		test_erased(bch);
+		test_correct(bch, iterations);
+		bench(bch, g);
+	}
+
+	printf("%s\n", failures ? "FAILED" : "PASSED");
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,317 @@
+/*
+ * model_test: 在PC上用寄存器模型跑s5p_nand_core.c(驱动里用的同一份代码)
+ *
+ * 用法: model_test [-s seed]
+ *
+ * 驱动和模型以源码形式包含进来，测试可以直接看它们的static变量；
+ * nand_base由nand_stub.c代替，shim/是内核头文件的替身
+ * 每一轮按insmod的顺序调用s5p_nand_init，做完检查后调用s5p_nand_exit，模型的flash随之清空:
+ *   1. 汉明码: 识别K9F1G08U0B，写flash坏块表，顺序写(cache program)读回比较
+ *   2. 子页写: 一页分4次写512字节，NOP不超过4次，按子页和整页读回
+ *   3. 纠错: model_flips=1，读出的数据都正确，有-EUCLEAN，ecc_stats.corrected增加
+ *   4. 坏块: 标记坏块后flash坏块表版本加1，重新读坏块表后仍是坏块
+ *   5. 加载缓存: 用flash坏块表时attach_cache不生效，不写缓存块
+ *   6. BCH: ecc_bch=1，model_flips=4，读出的数据都正确
+ *   7. 加载缓存: 内存坏块表下重新建表，比较不用/使用attach_cache时模型的读页次数和总线+阵列时间
+ * 最后打印debugfs的summary和model
+ */
+
+#include <unistd.h>
+
+#include "../s5p_nand_core.c"
+#include "../s5p_nand_model.c"
+
+static int failures;
+
+#define CHECK(cond, fmt, ...)							\
+	do {									\
+		if (!(cond)) {							\
+			failures++;						\
+			printf("  FAIL %s:%d: " fmt "\n", __func__, __LINE__, ##__VA_ARGS__);\
+		}								\
+	} while (0)
+
+static void fill_random(u8 *buf, int len)
+{
+	int i;
+
+	for (i = 0; i < len; i++)
+		buf[i] = random();
+}
+
+static int erase_block(struct mtd_info *mtd, loff_t ofs)
+{
+	struct erase_info ei;
+
+	memset(&ei, 0, sizeof(ei));
+	ei.mtd = mtd;
+	ei.addr = ofs;
+	ei.len = mtd->erasesize;
+
+	return mtd->erase(mtd, &ei);
+}
+
+static int load(void)
+{
+	int err;
+
+	printf("\n--- insmod s5p_nand.ko regs=%s use_flash_bbt=%d ecc_bch=%d model_flips=%d\n",
+	       regs, use_flash_bbt, ecc_bch, model_flips);
+
+	err = host_module_init();
+	if (err)
+		printf("  s5p_nand_init failed: %d\n", err);
+
+	return err;
+}
+
+static void unload(void)
+{
+	host_module_exit();
+}
+
+//整块顺序写再读回，非最后一页都用15h编程
+static void test_rw(struct mtd_info *mtd, loff_t ofs)
+{
+	int len = mtd->erasesize;
+	u8 *wbuf = malloc(len);
+	u8 *rbuf = malloc(len);
+	unsigned long progs = model_stat.page_progs;
+	size_t retlen;
+	int ret;
+
+	printf("read/write block at 0x%llx\n", (unsigned long long)ofs);
+
+	CHECK(!erase_block(mtd, ofs), "erase");
+
+	fill_random(wbuf, len);
+	ret = mtd->write(mtd, ofs, len, &retlen, wbuf);
+	CHECK(!ret && retlen == len, "write ret %d retlen %zu", ret, retlen);
+	CHECK(model_stat.page_progs - progs == len / mtd->writesize,
+	      "%lu programs for %u pages", model_stat.page_progs - progs, len / mtd->writesize);
+
+	memset(rbuf, 0, len);
+	ret = mtd->read(mtd, ofs, len, &retlen, rbuf);
+	CHECK(!ret && retlen == len, "read ret %d retlen %zu", ret, retlen);
+	CHECK(!memcmp(wbuf, rbuf, len), "read back differs");
+
+	//擦除后读出全0xff，ECC也是0xff
+	CHECK(!erase_block(mtd, ofs), "erase");
+	ret = mtd->read(mtd, ofs, mtd->writesize, &retlen, rbuf);
+	CHECK(!ret, "read erased page ret %d", ret);
+	CHECK(s5p_nand_is_ff(rbuf, mtd->writesize), "erased page not 0xff");
+
+	CHECK(model_stat.unknown_cmds == 0, "%lu unknown commands", model_stat.unknown_cmds);
+
+	free(wbuf);
+	free(rbuf);
+}
+
+//一页分成4个512字节的子页分别写，每次只传输和编程一个子页
+static void test_subpage(struct mtd_info *mtd, loff_t ofs)
+{
+	struct nand_chip *chip = mtd->priv;
+	int sub = chip->subpagesize;
+	int nsub = mtd->writesize / sub;
+	u8 *wbuf = malloc(mtd->writesize);
+	u8 *rbuf = malloc(mtd->writesize);
+	unsigned long nop = model_stat.nop_violations;
+	unsigned long long data_in;
+	size_t retlen;
+	int ret;
+	int i;
+
+	printf("subpage writes at 0x%llx, subpage %d\n", (unsigned long long)ofs, sub);
+	CHECK(sub == 512, "subpage size %d", sub);
+
+	CHECK(!erase_block(mtd, ofs), "erase");
+	fill_random(wbuf, mtd->writesize);
+
+	for (i = 0; i < nsub; i++) {
+		data_in = model_stat.data_in;
+		ret = mtd->write(mtd, ofs + i * sub, sub, &retlen, wbuf + i * sub);
+		CHECK(!ret && retlen == sub, "subpage %d write ret %d", i, ret);
+		//子页数据 + 它的ECC(汉明码2步6字节，BCH 1步)
+		CHECK(model_stat.data_in - data_in == sub + sub / chip->ecc.size * chip->ecc.bytes,
+		      "subpage %d transferred %llu bytes", i, model_stat.data_in - data_in);
+	}
+	CHECK(model_stat.nop_violations == nop, "%lu NOP violations", model_stat.nop_violations - nop);
+
+	for (i = 0; i < nsub; i++) {
+		memset(rbuf, 0, sub);
+		ret = mtd->read(mtd, ofs + i * sub, sub, &retlen, rbuf);
+		CHECK(!ret && retlen == sub, "subpage %d read ret %d", i, ret);
+		CHECK(!memcmp(rbuf, wbuf + i * sub, sub), "subpage %d differs", i);
+	}
+
+	ret = mtd->read(mtd, ofs, mtd->writesize, &retlen, rbuf);
+	CHECK(!ret, "page read ret %d", ret);
+	CHECK(!memcmp(rbuf, wbuf, mtd->writesize), "page differs");
+
+	free(wbuf);
+	free(rbuf);
+}
+
+//每次读页注入flips个bit错误，数据都要纠正回来
+static void test_flips(struct mtd_info *mtd, loff_t ofs, int flips, int rounds)
+{
+	u8 *wbuf = malloc(mtd->writesize);
+	u8 *rbuf = malloc(mtd->writesize);
+	unsigned int corrected = mtd->ecc_stats.corrected;
+	int euclean = 0;
+	size_t retlen;
+	int ret;
+	int i;
+
+	printf("%d random bitflips per page read, %d reads\n", flips, rounds);
+
+	CHECK(!erase_block(mtd, ofs), "erase");
+	fill_random(wbuf, mtd->writesize);
+	ret = mtd->write(mtd, ofs, mtd->writesize, &retlen, wbuf);
+	CHECK(!ret, "write ret %d", ret);
+
+	model_flips = flips;
+	for (i = 0; i < rounds; i++) {
+		ret = mtd->read(mtd, ofs, mtd->writesize, &retlen, rbuf);
+		CHECK(!ret || ret == -EUCLEAN, "read %d ret %d", i, ret);
+		CHECK(!memcmp(rbuf, wbuf, mtd->writesize), "read %d not corrected", i);
+		euclean += (ret == -EUCLEAN);
+	}
+	model_flips = 0;
+
+	printf("  %d of %d reads returned -EUCLEAN, %u bits corrected\n",
+	       euclean, rounds, mtd->ecc_stats.corrected - corrected);
+	CHECK(euclean > 0, "no -EUCLEAN");
+	CHECK(mtd->ecc_stats.corrected > corrected, "ecc_stats.corrected unchanged");
+
+	free(wbuf);
+	free(rbuf);
+}
+
+static void test_markbad(struct mtd_info *mtd, loff_t ofs)
+{
+	struct nand_chip *chip = mtd->priv;
+	u8 version = s5p_nand_bbt_main_descr.version[0];
+
+	printf("mark block at 0x%llx bad\n", (unsigned long long)ofs);
+
+	CHECK(mtd->block_isbad(mtd, ofs) == 0, "good block reported bad");
+	CHECK(!mtd->block_markbad(mtd, ofs), "markbad");
+	CHECK(mtd->block_isbad(mtd, ofs) == 1, "marked block not bad");
+	CHECK(s5p_nand_bbt_main_descr.version[0] == (u8)(version + 1),
+	      "bbt version %d -> %d", version, s5p_nand_bbt_main_descr.version[0]);
+
+	//和下次加载一样从flash读坏块表
+	kfree(chip->bbt);
+	chip->bbt = NULL;
+	CHECK(!s5p_nand_scan_bbt(mtd), "rescan");
+	CHECK(mtd->block_isbad(mtd, ofs) == 1, "bad block lost after rescan");
+	CHECK(mtd->block_isbad(mtd, ofs + mtd->erasesize) == 0, "neighbour block bad");
+}
+
+//按加载时的流程重新建坏块表，返回模型的总线时间+阵列忙时间(ns)
+static unsigned long long bbt_cost(struct mtd_info *mtd, const char *what)
+{
+	struct nand_chip *chip = mtd->priv;
+	unsigned long long bus_ns;
+
+	kfree(chip->bbt);
+	chip->bbt = NULL;
+	memset(&model_stat, 0, sizeof(model_stat));
+
+	CHECK(!s5p_nand_scan_bbt(mtd), "%s", what);
+
+	bus_ns = div_u64(model_stat.bus_cycles * 1000, S5P_NAND_MODEL_HCLK / 1000000);
+	printf("  %-20s %5lu page reads, %3lu programs, %lu erases, bus %6llu us, array %6llu us\n",
+	       what, model_stat.page_reads, model_stat.page_progs, model_stat.erases,
+	       bus_ns / 1000, model_stat.array_ns / 1000);
+
+	return bus_ns + model_stat.array_ns;
+}
+
+static void test_attach(struct mtd_info *mtd, loff_t ofs)
+{
+	struct nand_chip *chip = mtd->priv;
+	int len = s5p_nand_attach_bbt_len(mtd);
+	unsigned long long scan, cached;
+	u8 *bbt = malloc(len);
+
+	printf("attach cache at 0x%llx, use_flash_bbt=%d\n", (unsigned long long)ofs, use_flash_bbt);
+
+	attach_cache = 0;
+	scan = bbt_cost(mtd, "no cache");
+	memcpy(bbt, chip->bbt, len);
+
+	attach_cache = 1;
+	attach_cache_ofs = ofs;
+	bbt_cost(mtd, "cache write");
+	if (use_flash_bbt) {
+		CHECK(model_stat.page_progs == 0, "attach cache written with flash bbt");
+	} else {
+		cached = bbt_cost(mtd, "from cache");
+		CHECK(!memcmp(bbt, chip->bbt, len), "bad block table from cache differs");
+		CHECK(cached < scan, "attach cache slower than scanning");
+		printf("  %llu us -> %llu us\n", scan / 1000, cached / 1000);
+	}
+	attach_cache = 0;
+
+	free(bbt);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int seed = 1;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "s:")) != -1) {
+		switch (opt) {
+		case 's':
+			seed = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			printf("usage: %s [-s seed]\n", argv[0]);
+			return 2;
+		}
+	}
+	srandom(seed);
+
+	//汉明码，flash坏块表
+	if (!load()) {
+		CHECK(s5p_mtd->size == 128 << 20, "size %llu", (unsigned long long)s5p_mtd->size);
+		CHECK(s5p_mtd->erasesize == 128 << 10, "erasesize %u", s5p_mtd->erasesize);
+		CHECK(s5p_nand_bbt_main_descr.pages[0] != -1 && s5p_nand_bbt_mirror_descr.pages[0] != -1,
+		      "flash bbt not written");
+
+		test_rw(s5p_mtd, 8 * s5p_mtd->erasesize);
+		test_subpage(s5p_mtd, 9 * s5p_mtd->erasesize);
+		test_flips(s5p_mtd, 10 * s5p_mtd->erasesize, 1, 32);
+		test_markbad(s5p_mtd, 11 * s5p_mtd->erasesize);
+		test_attach(s5p_mtd, 16 * s5p_mtd->erasesize);
+
+		printf("\n/sys/kernel/debug/s5p_nand/summary:\n");
+		host_debugfs_show("summary", stdout);
+		printf("\n/sys/kernel/debug/s5p_nand/model:\n");
+		host_debugfs_show("model", stdout);
+		unload();
+	} else {
+		failures++;
+	}
+
+	//BCH，内存坏块表
+	use_flash_bbt = 0;
+	ecc_bch = 1;
+	if (!load()) {
+		CHECK(s5p_nand_bch != NULL, "BCH not enabled");
+		test_rw(s5p_mtd, 8 * s5p_mtd->erasesize);
+		test_subpage(s5p_mtd, 9 * s5p_mtd->erasesize);
+		test_flips(s5p_mtd, 10 * s5p_mtd->erasesize, 4, 32);
+		test_attach(s5p_mtd, 16 * s5p_mtd->erasesize);
+		unload();
+	} else {
+		failures++;
+	}
+
+	printf("\n%s: %d failures\n", failures ? "FAILED" : "PASSED", failures);
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,1629 @@
+/*
+ * model_test用的最小nand_base/nand_bbt/mtd核心
+ *
+ * 只实现s5p_nand_core.c用到的路径，流程按3.0内核的nand_base.c/nand_bbt.c:
+ *   大页命令(nand_command_lp)、nand_wait、按ID第4字节识别几何参数
+ *   软件汉明码(每256字节3字节，取反存放，擦除页的ECC是ff ff ff)和NAND_ECC_HW的calculate/correct
+ *   read_subpage、子页写的subpagesize规则、按页的读写/OOB读写/擦除、坏块查询和标记
+ *   flash坏块表: 在最后maxblocks个块里找pattern，版本号比较，没有就扫描OOB建表并写入，
+ *   内存中每块2bit(00好，01坏，10保留，11出厂坏块)
+ * 汉明码的bit排列和内核nand_ecc.c不同，只在这个测试里自洽
+ * 另外提供替身头文件里声明的jiffies、ktime、crc32和debugfs
+ */
+#include <time.h>
+
+#include <linux/kernel.h>
+#include <linux/mtd/mtd.h>
+#include <linux/mtd/nand.h>
+#include <linux/mtd/nand_ecc.h>
+#include <linux/mtd/partitions.h>
+
+struct task_struct *host_current;
+
+unsigned long host_jiffies(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000UL + ts.tv_nsec / 1000000;
+}
+
+ktime_t ktime_get(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (ktime_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+//和内核lib/crc32.c的crc32_le相同(多项式0xedb88320，不取反)
+u32 crc32_le(u32 crc, const void *p, size_t len)
+{
+	const u8 *s = p;
+	int i;
+
+	while (len--) {
+		crc ^= *s++;
+		for (i = 0; i < 8; i++)
+			crc = (crc >> 1) ^ ((crc & 1) ? 0xedb88320 : 0);
+	}
+
+	return crc;
+}
+
+/*
+ * debugfs: 只记录文件名和fops，host_debugfs_show按名字打开并调用show
+ */
+#define HOST_DEBUGFS_MAX	16
+
+struct dentry {
+	const char *name;
+	struct dentry *parent;
+	const struct file_operations *fops;
+	void *data;
+	int used;
+};
+
+static struct dentry host_debugfs[HOST_DEBUGFS_MAX];
+
+static struct dentry *host_debugfs_add(const char *name, struct dentry *parent,
+				       void *data, const struct file_operations *fops)
+{
+	int i;
+
+	for (i = 0; i < HOST_DEBUGFS_MAX; i++) {
+		if (host_debugfs[i].used)
+			continue;
+		host_debugfs[i].name = name;
+		host_debugfs[i].parent = parent;
+		host_debugfs[i].fops = fops;
+		host_debugfs[i].data = data;
+		host_debugfs[i].used = 1;
+		return &host_debugfs[i];
+	}
+
+	return NULL;
+}
+
+struct dentry *debugfs_create_dir(const char *name, struct dentry *parent)
+{
+	return host_debugfs_add(name, parent, NULL, NULL);
+}
+
+struct dentry *debugfs_create_file(const char *name, mode_t mode, struct dentry *parent,
+				   void *data, const struct file_operations *fops)
+{
+	return host_debugfs_add(name, parent, data, fops);
+}
+
+struct dentry *debugfs_create_blob(const char *name, mode_t mode, struct dentry *parent,
+				   struct debugfs_blob_wrapper *blob)
+{
+	return host_debugfs_add(name, parent, blob, NULL);
+}
+
+void debugfs_remove(struct dentry *dentry)
+{
+	if (dentry)
+		dentry->used = 0;
+}
+
+void debugfs_remove_recursive(struct dentry *dentry)
+{
+	int i;
+
+	if (!dentry)
+		return;
+
+	for (i = 0; i < HOST_DEBUGFS_MAX; i++)
+		if (host_debugfs[i].used && host_debugfs[i].parent == dentry)
+			debugfs_remove_recursive(&host_debugfs[i]);
+	dentry->used = 0;
+}
+
+int single_open(struct file *file, int (*show)(struct seq_file *, void *), void *data)
+{
+	struct seq_file *m = calloc(1, sizeof(*m));
+
+	if (!m)
+		return -ENOMEM;
+
+	m->show = show;
+	m->private = data;
+	file->private_data = m;
+
+	return 0;
+}
+
+int single_release(struct inode *inode, struct file *file)
+{
+	free(file->private_data);
+
+	return 0;
+}
+
+ssize_t seq_read(struct file *file, char __user *buf, size_t count, loff_t *ppos)
+{
+	return 0;
+}
+
+loff_t seq_lseek(struct file *file, loff_t offset, int whence)
+{
+	return 0;
+}
+
+//找不到文件或者不是seq_file返回-ENOENT
+int host_debugfs_show(const char *name, FILE *out)
+{
+	struct inode inode;
+	struct file file;
+	struct seq_file *m;
+	int i;
+
+	for (i = 0; i < HOST_DEBUGFS_MAX; i++) {
+		struct dentry *d = &host_debugfs[i];
+
+		if (!d->used || !d->fops || !d->fops->open || strcmp(d->name, name))
+			continue;
+
+		inode.i_private = d->data;
+		file.private_data = NULL;
+		if (d->fops->open(&inode, &file))
+			return -ENOENT;
+		m = file.private_data;
+		m->out = out;
+		m->show(m, NULL);
+		d->fops->release(&inode, &file);
+
+		return 0;
+	}
+
+	return -ENOENT;
+}
+
+/*
+ * 分区: 没有命令行，打印按mtdpart规则算出的位置
+ */
+int parse_mtd_partitions(struct mtd_info *master, const char **types,
+			 struct mtd_partition **pparts, unsigned long origin)
+{
+	return 0;
+}
+
+int mtd_device_register(struct mtd_info *master, const struct mtd_partition *parts,
+			int nr_parts)
+{
+	uint64_t cur = 0, ofs, size;
+	int i;
+
+	printk("Creating %d MTD partitions on \"%s\":\n", nr_parts, master->name);
+	for (i = 0; i < nr_parts; i++) {
+		ofs = parts[i].offset;
+		if (ofs == MTDPART_OFS_APPEND)
+			ofs = cur;
+		else if (ofs == MTDPART_OFS_NXTBLK)
+			ofs = ALIGN(cur, (uint64_t)master->erasesize);
+		if (ofs >= master->size) {
+			printk("mtd: partition \"%s\" is out of reach -- disabled\n", parts[i].name);
+			continue;
+		}
+		size = (parts[i].size == MTDPART_SIZ_FULL || ofs + parts[i].size > master->size) ?
+			master->size - ofs : parts[i].size;
+		cur = ofs + size;
+		printk("0x%012llx-0x%012llx : \"%s\"\n",
+		       (unsigned long long)ofs, (unsigned long long)cur, parts[i].name);
+	}
+
+	return 0;
+}
+
+int mtd_device_unregister(struct mtd_info *master)
+{
+	return 0;
+}
+
+/*
+ * 软件汉明码
+ * 256字节 = 2048bit，bit地址11位，每位地址对应两个奇偶校验: 地址位为1的bit的异或、为0的bit的异或
+ * 22个校验位取反后放在3个字节里(多出的2bit为1)，全0xff的数据每组都有1024个1，ECC为ff ff ff
+ */
+int nand_calculate_ecc(struct mtd_info *mtd, const u_char *dat, u_char *ecc_code)
+{
+	u32 par[2][11];
+	u32 code = 0;
+	int i, bit, k;
+
+	memset(par, 0, sizeof(par));
+	for (i = 0; i < 256; i++) {
+		for (bit = 0; bit < 8; bit++) {
+			int v = (dat[i] >> bit) & 1;
+			int addr = i * 8 + bit;
+
+			if (!v)
+				continue;
+			for (k = 0; k < 11; k++)
+				par[(addr >> k) & 1][k] ^= 1;
+		}
+	}
+
+	for (k = 0; k < 11; k++)
+		code |= (par[1][k] << (2 * k)) | (par[0][k] << (2 * k + 1));
+	code = ~code;
+
+	ecc_code[0] = code;
+	ecc_code[1] = code >> 8;
+	ecc_code[2] = code >> 16;
+
+	return 0;
+}
+
+//纠正1bit返回1，ECC字节本身错1bit也返回1，不可纠正返回-1
+int nand_correct_data(struct mtd_info *mtd, u_char *dat, u_char *read_ecc, u_char *calc_ecc)
+{
+	u32 syn = (read_ecc[0] ^ calc_ecc[0]) | (read_ecc[1] ^ calc_ecc[1]) << 8 |
+		  (read_ecc[2] ^ calc_ecc[2]) << 16;
+	int addr = 0;
+	int k;
+
+	syn &= (1 << 22) - 1;
+	if (!syn)
+		return 0;
+
+	if (hweight32(syn) == 1)
+		return 1;
+
+	for (k = 0; k < 11; k++) {
+		int p = (syn >> (2 * k)) & 3;
+
+		if (p != 1 && p != 2)
+			return -1;
+		if (p == 1)
+			addr |= 1 << k;
+	}
+
+	dat[addr >> 3] ^= 1 << (addr & 7);
+
+	return 1;
+}
+
+/*
+ * 命令和等待
+ */
+#define NAND_STUB_TIMEOUT_MS	400
+
+void nand_wait_ready(struct mtd_info *mtd)
+{
+	struct nand_chip *chip = mtd->priv;
+	unsigned long timeo = jiffies + msecs_to_jiffies(NAND_STUB_TIMEOUT_MS);
+
+	while (time_before(jiffies, timeo)) {
+		if (chip->dev_ready(mtd))
+			return;
+	}
+
+	printk("nand_wait_ready: timeout\n");
+}
+
+static void nand_command_lp(struct mtd_info *mtd, unsigned int command,
+			    int column, int page_addr)
+{
+	struct nand_chip *chip = mtd->priv;
+
+	if (command == NAND_CMD_READOOB) {
+		column += mtd->writesize;
+		command = NAND_CMD_READ0;
+	}
+
+	chip->cmd_ctrl(mtd, command & 0xff, NAND_NCE | NAND_CLE | NAND_CTRL_CHANGE);
+
+	if (column != -1 || page_addr != -1) {
+		int ctrl = NAND_CTRL_CHANGE | NAND_NCE | NAND_ALE;
+
+		if (column != -1) {
+			chip->cmd_ctrl(mtd, column, ctrl);
+			ctrl &= ~NAND_CTRL_CHANGE;
+			chip->cmd_ctrl(mtd, column >> 8, ctrl);
+		}
+		if (page_addr != -1) {
+			chip->cmd_ctrl(mtd, page_addr, ctrl);
+			chip->cmd_ctrl(mtd, page_addr >> 8, NAND_NCE | NAND_ALE);
+			if (chip->chipsize > (128 << 20))
+				chip->cmd_ctrl(mtd, page_addr >> 16, NAND_NCE | NAND_ALE);
+		}
+	}
+	chip->cmd_ctrl(mtd, NAND_CMD_NONE, NAND_NCE | NAND_CTRL_CHANGE);
+
+	switch (command) {
+	case NAND_CMD_CACHEDPROG:
+	case NAND_CMD_PAGEPROG:
+	case NAND_CMD_ERASE1:
+	case NAND_CMD_ERASE2:
+	case NAND_CMD_SEQIN:
+	case NAND_CMD_RNDIN:
+	case NAND_CMD_STATUS:
+		return;
+
+	case NAND_CMD_RESET:
+		break;
+
+	case NAND_CMD_RNDOUT:
+		chip->cmd_ctrl(mtd, NAND_CMD_RNDOUTSTART, NAND_NCE | NAND_CLE | NAND_CTRL_CHANGE);
+		chip->cmd_ctrl(mtd, NAND_CMD_NONE, NAND_NCE | NAND_CTRL_CHANGE);
+		return;
+
+	case NAND_CMD_READ0:
+		chip->cmd_ctrl(mtd, NAND_CMD_READSTART, NAND_NCE | NAND_CLE | NAND_CTRL_CHANGE);
+		chip->cmd_ctrl(mtd, NAND_CMD_NONE, NAND_NCE | NAND_CTRL_CHANGE);
+		break;
+
+	default:
+		break;
+	}
+
+	nand_wait_ready(mtd);
+}
+
+static int nand_wait(struct mtd_info *mtd, struct nand_chip *chip)
+{
+	unsigned long timeo = jiffies + msecs_to_jiffies(chip->state == FL_ERASING ? 400 : 20);
+
+	chip->cmdfunc(mtd, NAND_CMD_STATUS, -1, -1);
+	while (time_before(jiffies, timeo)) {
+		if (chip->dev_ready(mtd))
+			break;
+	}
+
+	return chip->read_byte(mtd);
+}
+
+static void single_erase_cmd(struct mtd_info *mtd, int page)
+{
+	struct nand_chip *chip = mtd->priv;
+
+	chip->cmdfunc(mtd, NAND_CMD_ERASE1, -1, page);
+	chip->cmdfunc(mtd, NAND_CMD_ERASE2, -1, -1);
+}
+
+//测试是单线程的，芯片不空闲说明驱动没有配对地取放
+static void nand_get_device(struct nand_chip *chip, nand_state_t new_state)
+{
+	if (chip->state != FL_READY) {
+		printk("nand_get_device: chip busy (state %d)\n", chip->state);
+		abort();
+	}
+
+	chip->controller->active = chip;
+	chip->state = new_state;
+}
+
+static void nand_release_device(struct mtd_info *mtd)
+{
+	struct nand_chip *chip = mtd->priv;
+
+	chip->select_chip(mtd, -1);
+	chip->controller->active = NULL;
+	chip->state = FL_READY;
+}
+
+/*
+ * 页读写
+ */
+static int nand_read_page_raw(struct mtd_info *mtd, struct nand_chip *chip,
+			      uint8_t *buf, int page)
+{
+	chip->read_buf(mtd, buf, mtd->writesize);
+	chip->read_buf(mtd, chip->oob_poi, mtd->oobsize);
+
+	return 0;
+}
+
+static void nand_write_page_raw(struct mtd_info *mtd, struct nand_chip *chip,
+				const uint8_t *buf)
+{
+	chip->write_buf(mtd, buf, mtd->writesize);
+	chip->write_buf(mtd, chip->oob_poi, mtd->oobsize);
+}
+
+static void nand_ecc_check(struct mtd_info *mtd, struct nand_chip *chip,
+			   uint8_t *p, int first, int nsteps)
+{
+	uint8_t *ecc_code = chip->buffers->ecccode;
+	uint8_t *ecc_calc = chip->buffers->ecccalc;
+	int eccbytes = chip->ecc.bytes;
+	int i, stat;
+
+	for (i = 0; i < nsteps * eccbytes; i++)
+		ecc_code[i] = chip->oob_poi[chip->ecc.layout->eccpos[first * eccbytes + i]];
+
+	for (i = 0; i < nsteps; i++, p += chip->ecc.size) {
+		stat = chip->ecc.correct(mtd, p, &ecc_code[i * eccbytes], &ecc_calc[i * eccbytes]);
+		if (stat < 0)
+			mtd->ecc_stats.failed++;
+		else
+			mtd->ecc_stats.corrected += stat;
+	}
+}
+
+static int nand_read_page_swecc(struct mtd_info *mtd, struct nand_chip *chip,
+				uint8_t *buf, int page)
+{
+	uint8_t *ecc_calc = chip->buffers->ecccalc;
+	int i;
+
+	chip->ecc.read_page_raw(mtd, chip, buf, page);
+
+	for (i = 0; i < chip->ecc.steps; i++)
+		chip->ecc.calculate(mtd, buf + i * chip->ecc.size, &ecc_calc[i * chip->ecc.bytes]);
+
+	nand_ecc_check(mtd, chip, buf, 0, chip->ecc.steps);
+
+	return 0;
+}
+
+static int nand_read_page_hwecc(struct mtd_info *mtd, struct nand_chip *chip,
+				uint8_t *buf, int page)
+{
+	uint8_t *ecc_calc = chip->buffers->ecccalc;
+	int i;
+
+	for (i = 0; i < chip->ecc.steps; i++) {
+		uint8_t *p = buf + i * chip->ecc.size;
+
+		chip->ecc.hwctl(mtd, NAND_ECC_READ);
+		chip->read_buf(mtd, p, chip->ecc.size);
+		chip->ecc.calculate(mtd, p, &ecc_calc[i * chip->ecc.bytes]);
+	}
+	chip->read_buf(mtd, chip->oob_poi, mtd->oobsize);
+
+	nand_ecc_check(mtd, chip, buf, 0, chip->ecc.steps);
+
+	return 0;
+}
+
+//只读需要的ECC步和它们的ECC字节(ECC位置连续时)
+static int nand_read_subpage(struct mtd_info *mtd, struct nand_chip *chip,
+			     uint32_t data_offs, uint32_t readlen, uint8_t *bufpoi)
+{
+	uint32_t *eccpos = chip->ecc.layout->eccpos;
+	int start_step = data_offs / chip->ecc.size;
+	int end_step = (data_offs + readlen - 1) / chip->ecc.size;
+	int num_steps = end_step - start_step + 1;
+	int data_col_addr = start_step * chip->ecc.size;
+	int eccfrag_len = num_steps * chip->ecc.bytes;
+	int index = start_step * chip->ecc.bytes;
+	uint8_t *p = bufpoi + data_col_addr;
+	int gaps = 0;
+	int i;
+
+	if (data_offs != 0)
+		chip->cmdfunc(mtd, NAND_CMD_RNDOUT, data_col_addr, -1);
+
+	chip->read_buf(mtd, p, num_steps * chip->ecc.size);
+	for (i = 0; i < num_steps; i++)
+		chip->ecc.calculate(mtd, p + i * chip->ecc.size,
+				    &chip->buffers->ecccalc[i * chip->ecc.bytes]);
+
+	for (i = 0; i < eccfrag_len - 1; i++) {
+		if (eccpos[i + index] + 1 != eccpos[i + index + 1]) {
+			gaps = 1;
+			break;
+		}
+	}
+
+	if (gaps) {
+		chip->cmdfunc(mtd, NAND_CMD_RNDOUT, mtd->writesize, -1);
+		chip->read_buf(mtd, chip->oob_poi, mtd->oobsize);
+	} else {
+		chip->cmdfunc(mtd, NAND_CMD_RNDOUT, mtd->writesize + eccpos[index], -1);
+		chip->read_buf(mtd, &chip->oob_poi[eccpos[index]], eccfrag_len);
+	}
+
+	nand_ecc_check(mtd, chip, p, start_step, num_steps);
+
+	return 0;
+}
+
+static void nand_write_page_swecc(struct mtd_info *mtd, struct nand_chip *chip,
+				  const uint8_t *buf)
+{
+	uint8_t *ecc_calc = chip->buffers->ecccalc;
+	int i;
+
+	for (i = 0; i < chip->ecc.steps; i++)
+		chip->ecc.calculate(mtd, buf + i * chip->ecc.size, &ecc_calc[i * chip->ecc.bytes]);
+
+	for (i = 0; i < chip->ecc.total; i++)
+		chip->oob_poi[chip->ecc.layout->eccpos[i]] = ecc_calc[i];
+
+	chip->ecc.write_page_raw(mtd, chip, buf);
+}
+
+static void nand_write_page_hwecc(struct mtd_info *mtd, struct nand_chip *chip,
+				  const uint8_t *buf)
+{
+	uint8_t *ecc_calc = chip->buffers->ecccalc;
+	int i;
+
+	for (i = 0; i < chip->ecc.steps; i++) {
+		const uint8_t *p = buf + i * chip->ecc.size;
+
+		chip->ecc.hwctl(mtd, NAND_ECC_WRITE);
+		chip->write_buf(mtd, p, chip->ecc.size);
+		chip->ecc.calculate(mtd, p, &ecc_calc[i * chip->ecc.bytes]);
+	}
+
+	for (i = 0; i < chip->ecc.total; i++)
+		chip->oob_poi[chip->ecc.layout->eccpos[i]] = ecc_calc[i];
+
+	chip->write_buf(mtd, chip->oob_poi, mtd->oobsize);
+}
+
+static int nand_read_oob_std(struct mtd_info *mtd, struct nand_chip *chip, int page, int sndcmd)
+{
+	if (sndcmd) {
+		chip->cmdfunc(mtd, NAND_CMD_READOOB, 0, page);
+		sndcmd = 0;
+	}
+	chip->read_buf(mtd, chip->oob_poi, mtd->oobsize);
+
+	return sndcmd;
+}
+
+static int nand_write_oob_std(struct mtd_info *mtd, struct nand_chip *chip, int page)
+{
+	int status;
+
+	chip->cmdfunc(mtd, NAND_CMD_SEQIN, mtd->writesize, page);
+	chip->write_buf(mtd, chip->oob_poi, mtd->oobsize);
+	chip->cmdfunc(mtd, NAND_CMD_PAGEPROG, -1, -1);
+	status = chip->waitfunc(mtd, chip);
+
+	return (status & NAND_STATUS_FAIL) ? -EIO : 0;
+}
+
+//MTD_OOB_AUTO按oobfree拷贝，其他按ooboffs整段拷贝
+static void nand_copy_oob(struct nand_chip *chip, uint8_t *oob, struct mtd_oob_ops *ops,
+			  size_t len, int to_chip)
+{
+	struct nand_oobfree *free;
+	size_t bytes;
+
+	if (ops->mode != MTD_OOB_AUTO) {
+		if (to_chip)
+			memcpy(chip->oob_poi + ops->ooboffs, oob, len);
+		else
+			memcpy(oob, chip->oob_poi + ops->ooboffs, len);
+		return;
+	}
+
+	for (free = chip->ecc.layout->oobfree; free->length && len; free++, len -= bytes) {
+		bytes = min_t(size_t, len, free->length);
+		if (to_chip)
+			memcpy(chip->oob_poi + free->offset, oob, bytes);
+		else
+			memcpy(oob, chip->oob_poi + free->offset, bytes);
+		oob += bytes;
+	}
+}
+
+static size_t nand_oob_len(struct mtd_info *mtd, struct mtd_oob_ops *ops)
+{
+	return ops->mode == MTD_OOB_AUTO ? mtd->oobavail : mtd->oobsize - ops->ooboffs;
+}
+
+static int nand_do_read_ops(struct mtd_info *mtd, loff_t from, struct mtd_oob_ops *ops)
+{
+	struct nand_chip *chip = mtd->priv;
+	struct mtd_ecc_stats stats = mtd->ecc_stats;
+	int chipnr = (int)(from >> chip->chip_shift);
+	int realpage = (int)(from >> chip->page_shift);
+	int page = realpage & chip->pagemask;
+	int col = (int)(from & (mtd->writesize - 1));
+	uint32_t readlen = ops->len;
+	uint32_t oobreadlen = ops->ooblen;
+	uint8_t *buf = ops->datbuf;
+	uint8_t *oob = ops->oobbuf;
+	uint8_t *bufpoi;
+	int bytes, aligned;
+	int ret = 0;
+
+	chip->select_chip(mtd, chipnr);
+
+	while (1) {
+		bytes = min(mtd->writesize - col, readlen);
+		aligned = (bytes == mtd->writesize);
+
+		if (realpage != chip->pagebuf || oob) {
+			bufpoi = aligned ? buf : chip->buffers->databuf;
+
+			chip->cmdfunc(mtd, NAND_CMD_READ0, 0x00, page);
+
+			if (ops->mode == MTD_OOB_RAW)
+				ret = chip->ecc.read_page_raw(mtd, chip, bufpoi, page);
+			else if (!aligned && chip->ecc.mode == NAND_ECC_SOFT && !oob)
+				ret = chip->ecc.read_subpage(mtd, chip, col, bytes, bufpoi);
+			else
+				ret = chip->ecc.read_page(mtd, chip, bufpoi, page);
+			if (ret < 0)
+				break;
+
+			if (!aligned) {
+				chip->pagebuf = (chip->ecc.mode != NAND_ECC_SOFT && !oob) ? realpage : -1;
+				memcpy(buf, chip->buffers->databuf + col, bytes);
+			}
+
+			if (oob) {
+				size_t toread = min(oobreadlen, nand_oob_len(mtd, ops));
+
+				nand_copy_oob(chip, oob, ops, toread, 0);
+				oob += toread;
+				oobreadlen -= toread;
+			}
+		} else {
+			memcpy(buf, chip->buffers->databuf + col, bytes);
+		}
+		buf += bytes;
+
+		readlen -= bytes;
+		if (!readlen)
+			break;
+
+		col = 0;
+		realpage++;
+		page = realpage & chip->pagemask;
+		if (!page) {
+			chipnr++;
+			chip->select_chip(mtd, -1);
+			chip->select_chip(mtd, chipnr);
+		}
+	}
+
+	ops->retlen = ops->len - readlen;
+	if (oob)
+		ops->oobretlen = ops->ooblen - oobreadlen;
+
+	if (ret)
+		return ret;
+	if (mtd->ecc_stats.failed - stats.failed)
+		return -EBADMSG;
+
+	return mtd->ecc_stats.corrected - stats.corrected ? -EUCLEAN : 0;
+}
+
+static int nand_do_read_oob(struct mtd_info *mtd, loff_t from, struct mtd_oob_ops *ops)
+{
+	struct nand_chip *chip = mtd->priv;
+	int page = (int)(from >> chip->page_shift) & chip->pagemask;
+	size_t len = nand_oob_len(mtd, ops);
+	size_t readlen = ops->ooblen;
+	uint8_t *buf = ops->oobbuf;
+	size_t bytes;
+
+	chip->select_chip(mtd, (int)(from >> chip->chip_shift));
+
+	while (readlen) {
+		chip->ecc.read_oob(mtd, chip, page, 1);
+		bytes = min(len, readlen);
+		nand_copy_oob(chip, buf, ops, bytes, 0);
+		buf += bytes;
+		readlen -= bytes;
+		page++;
+	}
+
+	ops->oobretlen = ops->ooblen;
+
+	return 0;
+}
+
+static int nand_read(struct mtd_info *mtd, loff_t from, size_t len,
+		     size_t *retlen, uint8_t *buf)
+{
+	struct nand_chip *chip = mtd->priv;
+	struct mtd_oob_ops ops;
+	int ret;
+
+	if (from + len > mtd->size)
+		return -EINVAL;
+	if (!len)
+		return 0;
+
+	nand_get_device(chip, FL_READING);
+	memset(&ops, 0, sizeof(ops));
+	ops.len = len;
+	ops.datbuf = buf;
+	ret = nand_do_read_ops(mtd, from, &ops);
+	*retlen = ops.retlen;
+	nand_release_device(mtd);
+
+	return ret;
+}
+
+static int nand_read_oob(struct mtd_info *mtd, loff_t from, struct mtd_oob_ops *ops)
+{
+	struct nand_chip *chip = mtd->priv;
+	int ret;
+
+	ops->retlen = 0;
+	if (ops->datbuf && from + ops->len > mtd->size)
+		return -EINVAL;
+
+	nand_get_device(chip, FL_READING);
+	if (!ops->datbuf)
+		ret = nand_do_read_oob(mtd, from, ops);
+	else
+		ret = nand_do_read_ops(mtd, from, ops);
+	nand_release_device(mtd);
+
+	return ret;
+}
+
+#define NOTALIGNED(x)	((x & (chip->subpagesize - 1)) != 0)
+
+static int nand_do_write_ops(struct mtd_info *mtd, loff_t to, struct mtd_oob_ops *ops)
+{
+	struct nand_chip *chip = mtd->priv;
+	uint32_t writelen = ops->len;
+	uint8_t *oob = ops->oobbuf;
+	uint8_t *buf = ops->datbuf;
+	int chipnr, realpage, page, blockmask, column;
+	int ret;
+
+	ops->retlen = 0;
+	if (!writelen)
+		return 0;
+
+	if (NOTALIGNED(to) || NOTALIGNED(ops->len)) {
+		printk("nand_write: attempt to write not page aligned data\n");
+		return -EINVAL;
+	}
+
+	column = to & (mtd->writesize - 1);
+	if ((column || (writelen & (mtd->writesize - 1))) && oob)
+		return -EINVAL;
+
+	chipnr = (int)(to >> chip->chip_shift);
+	chip->select_chip(mtd, chipnr);
+
+	realpage = (int)(to >> chip->page_shift);
+	page = realpage & chip->pagemask;
+	blockmask = (1 << (chip->phys_erase_shift - chip->page_shift)) - 1;
+
+	if (to <= ((loff_t)chip->pagebuf << chip->page_shift) &&
+	    ((loff_t)chip->pagebuf << chip->page_shift) < (to + ops->len))
+		chip->pagebuf = -1;
+
+	if (!oob)
+		memset(chip->oob_poi, 0xff, mtd->oobsize);
+
+	while (1) {
+		int bytes = mtd->writesize;
+		int cached = writelen > bytes && page != blockmask;
+		uint8_t *wbuf = buf;
+
+		if (column || writelen < mtd->writesize) {
+			cached = 0;
+			bytes = min_t(int, bytes - column, (int)writelen);
+			chip->pagebuf = -1;
+			memset(chip->buffers->databuf, 0xff, mtd->writesize);
+			memcpy(&chip->buffers->databuf[column], buf, bytes);
+			wbuf = chip->buffers->databuf;
+		}
+
+		if (oob) {
+			memset(chip->oob_poi, 0xff, mtd->oobsize);
+			nand_copy_oob(chip, oob, ops, min(ops->ooblen, nand_oob_len(mtd, ops)), 1);
+			oob += min(ops->ooblen, nand_oob_len(mtd, ops));
+		}
+
+		ret = chip->write_page(mtd, chip, wbuf, page, cached, ops->mode == MTD_OOB_RAW);
+		if (ret)
+			break;
+
+		writelen -= bytes;
+		if (!writelen)
+			break;
+
+		column = 0;
+		buf += bytes;
+		realpage++;
+		page = realpage & chip->pagemask;
+		if (!page) {
+			chipnr++;
+			chip->select_chip(mtd, -1);
+			chip->select_chip(mtd, chipnr);
+		}
+	}
+
+	ops->retlen = ops->len - writelen;
+	if (oob)
+		ops->oobretlen = ops->ooblen;
+
+	return ret;
+}
+
+static int nand_do_write_oob(struct mtd_info *mtd, loff_t to, struct mtd_oob_ops *ops)
+{
+	struct nand_chip *chip = mtd->priv;
+	int page = (int)(to >> chip->page_shift);
+	int ret;
+
+	if (ops->ooblen > nand_oob_len(mtd, ops))
+		return -EINVAL;
+
+	chip->select_chip(mtd, (int)(to >> chip->chip_shift));
+	if (page == chip->pagebuf)
+		chip->pagebuf = -1;
+
+	memset(chip->oob_poi, 0xff, mtd->oobsize);
+	nand_copy_oob(chip, ops->oobbuf, ops, ops->ooblen, 1);
+	ret = chip->ecc.write_oob(mtd, chip, page & chip->pagemask);
+	memset(chip->oob_poi, 0xff, mtd->oobsize);
+
+	if (!ret)
+		ops->oobretlen = ops->ooblen;
+
+	return ret;
+}
+
+static int nand_write(struct mtd_info *mtd, loff_t to, size_t len,
+		      size_t *retlen, const uint8_t *buf)
+{
+	struct nand_chip *chip = mtd->priv;
+	struct mtd_oob_ops ops;
+	int ret;
+
+	if (to + len > mtd->size)
+		return -EINVAL;
+	if (!len)
+		return 0;
+
+	nand_get_device(chip, FL_WRITING);
+	memset(&ops, 0, sizeof(ops));
+	ops.len = len;
+	ops.datbuf = (uint8_t *)buf;
+	ret = nand_do_write_ops(mtd, to, &ops);
+	*retlen = ops.retlen;
+	nand_release_device(mtd);
+
+	return ret;
+}
+
+static int nand_write_oob(struct mtd_info *mtd, loff_t to, struct mtd_oob_ops *ops)
+{
+	struct nand_chip *chip = mtd->priv;
+	int ret;
+
+	ops->retlen = 0;
+	if (ops->datbuf && to + ops->len > mtd->size)
+		return -EINVAL;
+
+	nand_get_device(chip, FL_WRITING);
+	if (!ops->datbuf)
+		ret = nand_do_write_oob(mtd, to, ops);
+	else
+		ret = nand_do_write_ops(mtd, to, ops);
+	nand_release_device(mtd);
+
+	return ret;
+}
+
+/*
+ * 坏块
+ */
+static int nand_isbad_bbt(struct mtd_info *mtd, loff_t offs, int allowbbt)
+{
+	struct nand_chip *chip = mtd->priv;
+	int block = (int)(offs >> chip->bbt_erase_shift);
+	int res = (chip->bbt[block >> 2] >> ((block & 3) * 2)) & 3;
+
+	switch (res) {
+	case 0x00:
+		return 0;
+	case 0x02:
+		return allowbbt ? 0 : 1;
+	}
+
+	return 1;
+}
+
+static int nand_block_bad(struct mtd_info *mtd, loff_t ofs, int getchip)
+{
+	struct nand_chip *chip = mtd->priv;
+	int page = (int)(ofs >> chip->page_shift) & chip->pagemask;
+	int bad = 0;
+	int i;
+
+	if (getchip) {
+		nand_get_device(chip, FL_READING);
+		chip->select_chip(mtd, (int)(ofs >> chip->chip_shift));
+	}
+
+	for (i = 0; i < ((chip->options & NAND_BBT_SCAN2NDPAGE) ? 2 : 1); i++) {
+		chip->cmdfunc(mtd, NAND_CMD_READOOB, chip->badblockpos, page + i);
+		bad = chip->read_byte(mtd) != 0xff;
+		if (bad)
+			break;
+	}
+
+	if (getchip)
+		nand_release_device(mtd);
+
+	return bad;
+}
+
+static int nand_block_checkbad(struct mtd_info *mtd, loff_t ofs, int getchip, int allowbbt)
+{
+	struct nand_chip *chip = mtd->priv;
+
+	if (!chip->bbt)
+		return chip->block_bad(mtd, ofs, getchip);
+
+	return nand_isbad_bbt(mtd, ofs, allowbbt);
+}
+
+static int nand_update_bbt(struct mtd_info *mtd, loff_t offs);
+
+static int nand_default_block_markbad(struct mtd_info *mtd, loff_t ofs)
+{
+	struct nand_chip *chip = mtd->priv;
+	uint8_t buf[2] = { 0, 0 };
+	struct mtd_oob_ops ops;
+	int block = (int)(ofs >> chip->bbt_erase_shift);
+	int ret, i = 0;
+
+	if (chip->bbt)
+		chip->bbt[block >> 2] |= 0x01 << ((block & 0x03) << 1);
+
+	if (chip->options & NAND_USE_FLASH_BBT) {
+		ret = nand_update_bbt(mtd, ofs);
+	} else {
+		nand_get_device(chip, FL_WRITING);
+		do {
+			memset(&ops, 0, sizeof(ops));
+			ops.len = ops.ooblen = 2;
+			ops.oobbuf = buf;
+			ops.ooboffs = chip->badblockpos & ~0x01;
+			ret = nand_do_write_oob(mtd, ofs, &ops);
+			i++;
+			ofs += mtd->writesize;
+		} while (!ret && (chip->options & NAND_BBT_SCAN2NDPAGE) && i < 2);
+		nand_release_device(mtd);
+	}
+
+	if (!ret)
+		mtd->ecc_stats.badblocks++;
+
+	return ret;
+}
+
+static int nand_block_isbad(struct mtd_info *mtd, loff_t offs)
+{
+	if (offs > mtd->size)
+		return -EINVAL;
+
+	return nand_block_checkbad(mtd, offs, 1, 0);
+}
+
+static int nand_block_markbad(struct mtd_info *mtd, loff_t ofs)
+{
+	struct nand_chip *chip = mtd->priv;
+	int ret;
+
+	ret = nand_block_isbad(mtd, ofs);
+	if (ret) {
+		//已经是坏块了
+		if (ret > 0)
+			return 0;
+		return ret;
+	}
+
+	return chip->block_markbad(mtd, ofs);
+}
+
+static int nand_erase_nand(struct mtd_info *mtd, struct erase_info *instr, int allowbbt)
+{
+	struct nand_chip *chip = mtd->priv;
+	int pages_per_block = 1 << (chip->phys_erase_shift - chip->page_shift);
+	int page, chipnr, status, ret;
+	uint64_t len;
+
+	if ((instr->addr & ((1 << chip->phys_erase_shift) - 1)) ||
+	    (instr->len & ((1 << chip->phys_erase_shift) - 1)) ||
+	    instr->addr + instr->len > mtd->size)
+		return -EINVAL;
+
+	instr->fail_addr = MTD_FAIL_ADDR_UNKNOWN;
+
+	nand_get_device(chip, FL_ERASING);
+
+	page = (int)(instr->addr >> chip->page_shift);
+	chipnr = (int)(instr->addr >> chip->chip_shift);
+	chip->select_chip(mtd, chipnr);
+
+	len = instr->len;
+	instr->state = MTD_ERASING;
+
+	while (len) {
+		if (nand_block_checkbad(mtd, (loff_t)page << chip->page_shift, 0, allowbbt)) {
+			printk("nand_erase: attempt to erase a bad block at page 0x%08x\n", page);
+			instr->state = MTD_ERASE_FAILED;
+			goto erase_exit;
+		}
+
+		if (page <= chip->pagebuf && chip->pagebuf < page + pages_per_block)
+			chip->pagebuf = -1;
+
+		chip->erase_cmd(mtd, page & chip->pagemask);
+		status = chip->waitfunc(mtd, chip);
+		if (status & NAND_STATUS_FAIL) {
+			instr->state = MTD_ERASE_FAILED;
+			instr->fail_addr = (loff_t)page << chip->page_shift;
+			goto erase_exit;
+		}
+
+		len -= 1 << chip->phys_erase_shift;
+		page += pages_per_block;
+
+		if (len && !(page & chip->pagemask)) {
+			chipnr++;
+			chip->select_chip(mtd, -1);
+			chip->select_chip(mtd, chipnr);
+		}
+	}
+	instr->state = MTD_ERASE_DONE;
+
+erase_exit:
+	ret = instr->state == MTD_ERASE_DONE ? 0 : -EIO;
+	nand_release_device(mtd);
+
+	if (!ret && instr->callback)
+		instr->callback(instr);
+
+	return ret;
+}
+
+static int nand_erase(struct mtd_info *mtd, struct erase_info *instr)
+{
+	return nand_erase_nand(mtd, instr, 0);
+}
+
+/*
+ * flash坏块表(nand_bbt.c的PERCHIP + LASTBLOCK + VERSION + 2bit部分)
+ * flash上每块2bit: 11好，10用坏，00出厂坏块，坏块表所在的块按好块存
+ */
+static uint8_t scan_ff_pattern[] = { 0xff, 0xff };
+
+static struct nand_bbt_descr nand_stub_bbt_pattern = {
+	.offs		= 0,
+	.len		= 1,
+	.pattern	= scan_ff_pattern,
+};
+
+static int nand_bbt_blocks_per_chip(struct nand_chip *chip)
+{
+	return chip->chipsize >> chip->bbt_erase_shift;
+}
+
+//读整页数据+OOB，不做ECC
+static int scan_read_raw(struct mtd_info *mtd, uint8_t *buf, loff_t offs)
+{
+	struct mtd_oob_ops ops;
+
+	memset(&ops, 0, sizeof(ops));
+	ops.mode = MTD_OOB_RAW;
+	ops.len = mtd->writesize;
+	ops.ooblen = mtd->oobsize;
+	ops.datbuf = buf;
+	ops.oobbuf = buf + mtd->writesize;
+
+	return mtd->read_oob(mtd, offs, &ops);
+}
+
+static int search_bbt(struct mtd_info *mtd, uint8_t *buf, struct nand_bbt_descr *td)
+{
+	struct nand_chip *chip = mtd->priv;
+	int bpc = nand_bbt_blocks_per_chip(chip);
+	int i, j, block;
+
+	for (i = 0; i < chip->numchips; i++) {
+		td->version[i] = 0;
+		td->pages[i] = -1;
+
+		for (j = 0; j < td->maxblocks; j++) {
+			block = (i + 1) * bpc - 1 - j;
+			scan_read_raw(mtd, buf, (loff_t)block << chip->bbt_erase_shift);
+			if (!memcmp(buf + mtd->writesize + td->offs, td->pattern, td->len)) {
+				td->pages[i] = block << (chip->bbt_erase_shift - chip->page_shift);
+				if (td->options & NAND_BBT_VERSION)
+					td->version[i] = buf[mtd->writesize + td->veroffs];
+				break;
+			}
+		}
+
+		if (td->pages[i] == -1)
+			printk("Bad block table not found for chip %d\n", i);
+		else
+			printk("Bad block table found at page %d, version 0x%02X\n",
+			       td->pages[i], td->version[i]);
+	}
+
+	return 0;
+}
+
+static int read_abs_bbt(struct mtd_info *mtd, uint8_t *buf, struct nand_bbt_descr *td, int chipnr)
+{
+	struct nand_chip *chip = mtd->priv;
+	int bpc = nand_bbt_blocks_per_chip(chip);
+	size_t len = bpc >> 2;
+	size_t retlen;
+	int block = chipnr * bpc;
+	int ret;
+	int i, j;
+
+	ret = mtd->read(mtd, (loff_t)td->pages[chipnr] << chip->page_shift, len, &retlen, buf);
+	if (ret < 0 && ret != -EUCLEAN)
+		return ret;
+
+	for (i = 0; i < len; i++) {
+		for (j = 0; j < 8; j += 2, block++) {
+			uint8_t tmp = (buf[i] >> j) & 3;
+
+			if (tmp == 3)
+				continue;
+			chip->bbt[block >> 2] |= (tmp ? 0x01 : 0x03) << ((block & 3) * 2);
+			mtd->ecc_stats.badblocks++;
+		}
+	}
+
+	return 0;
+}
+
+static int create_bbt(struct mtd_info *mtd, uint8_t *buf, struct nand_bbt_descr *bd, int chipnr)
+{
+	struct nand_chip *chip = mtd->priv;
+	int bpc = nand_bbt_blocks_per_chip(chip);
+	int start = chipnr < 0 ? 0 : chipnr * bpc;
+	int end = chipnr < 0 ? chip->numchips * bpc : start + bpc;
+	int npages = (bd->options & NAND_BBT_SCAN2NDPAGE) ? 2 : 1;
+	struct mtd_oob_ops ops;
+	loff_t from;
+	int block, j, ret;
+
+	printk("Scanning device for bad blocks\n");
+
+	for (block = start; block < end; block++) {
+		from = (loff_t)block << chip->bbt_erase_shift;
+		for (j = 0; j < npages; j++) {
+			memset(&ops, 0, sizeof(ops));
+			ops.mode = MTD_OOB_PLACE;
+			ops.ooblen = mtd->oobsize;
+			ops.oobbuf = buf;
+			ret = mtd->read_oob(mtd, from + j * mtd->writesize, &ops);
+			if (ret)
+				return ret;
+			if (memcmp(buf + bd->offs, bd->pattern, bd->len)) {
+				chip->bbt[block >> 2] |= 0x03 << ((block & 3) * 2);
+				printk("Bad eraseblock %d at 0x%012llx\n", block, (unsigned long long)from);
+				mtd->ecc_stats.badblocks++;
+				break;
+			}
+		}
+	}
+
+	return 0;
+}
+
+static int write_bbt(struct mtd_info *mtd, uint8_t *buf, struct nand_bbt_descr *td,
+		     struct nand_bbt_descr *md, int chipnr)
+{
+	struct nand_chip *chip = mtd->priv;
+	int bpc = nand_bbt_blocks_per_chip(chip);
+	size_t len = ALIGN((size_t)(bpc >> 2), (size_t)mtd->writesize);
+	struct erase_info einfo;
+	struct mtd_oob_ops ops;
+	int page = -1;
+	int block, i, ret;
+	loff_t to;
+
+	if (td->pages[chipnr] != -1) {
+		page = td->pages[chipnr];
+	} else {
+		for (i = 0; i < td->maxblocks; i++) {
+			block = (chipnr + 1) * bpc - 1 - i;
+			switch ((chip->bbt[block >> 2] >> ((block & 3) * 2)) & 3) {
+			case 0x01:
+			case 0x03:
+				continue;
+			}
+			page = block << (chip->bbt_erase_shift - chip->page_shift);
+			if (!md || md->pages[chipnr] != page)
+				break;
+			page = -1;
+		}
+		if (page == -1) {
+			printk("No space left to write bad block table\n");
+			return -ENOSPC;
+		}
+	}
+
+	memset(buf, 0xff, len + mtd->oobsize);
+	memcpy(buf + len + td->offs, td->pattern, td->len);
+	buf[len + td->veroffs] = td->version[chipnr];
+
+	for (i = 0; i < bpc; i++) {
+		block = chipnr * bpc + i;
+		switch ((chip->bbt[block >> 2] >> ((block & 3) * 2)) & 3) {
+		case 0x01:
+			buf[i >> 2] &= ~(0x01 << ((i & 3) * 2));
+			break;
+		case 0x03:
+			buf[i >> 2] &= ~(0x03 << ((i & 3) * 2));
+			break;
+		}
+	}
+
+	to = (loff_t)page << chip->page_shift;
+	memset(&einfo, 0, sizeof(einfo));
+	einfo.mtd = mtd;
+	einfo.addr = to;
+	einfo.len = 1 << chip->bbt_erase_shift;
+	ret = nand_erase_nand(mtd, &einfo, 1);
+	if (ret < 0)
+		return ret;
+
+	memset(&ops, 0, sizeof(ops));
+	ops.mode = MTD_OOB_PLACE;
+	ops.len = len;
+	ops.ooblen = mtd->oobsize;
+	ops.datbuf = buf;
+	ops.oobbuf = buf + len;
+	ret = mtd->write_oob(mtd, to, &ops);
+	if (ret < 0)
+		return ret;
+
+	printk("Bad block table written to 0x%012llx, version 0x%02X\n",
+	       (unsigned long long)to, td->version[chipnr]);
+	td->pages[chipnr] = page;
+
+	return 0;
+}
+
+static void check_create(struct mtd_info *mtd, uint8_t *buf, struct nand_bbt_descr *bd)
+{
+	struct nand_chip *chip = mtd->priv;
+	struct nand_bbt_descr *td = chip->bbt_td, *md = chip->bbt_md, *rd;
+	int writeops;
+	int i;
+
+	for (i = 0; i < chip->numchips; i++) {
+		writeops = 0;
+		rd = NULL;
+
+		if (td->pages[i] == -1 && md->pages[i] == -1) {
+			create_bbt(mtd, buf, bd, i);
+			td->version[i] = 1;
+			md->version[i] = 1;
+			writeops = 0x03;
+		} else if (td->pages[i] == -1) {
+			rd = md;
+			td->version[i] = md->version[i];
+			writeops = 0x01;
+		} else if (md->pages[i] == -1) {
+			rd = td;
+			md->version[i] = td->version[i];
+			writeops = 0x02;
+		} else if (td->version[i] == md->version[i]) {
+			rd = td;
+		} else if ((int8_t)(td->version[i] - md->version[i]) > 0) {
+			rd = td;
+			md->version[i] = td->version[i];
+			writeops = 0x02;
+		} else {
+			rd = md;
+			td->version[i] = md->version[i];
+			writeops = 0x01;
+		}
+
+		if (rd)
+			read_abs_bbt(mtd, buf, rd, i);
+		if (writeops & 0x01)
+			write_bbt(mtd, buf, td, md, i);
+		if (writeops & 0x02)
+			write_bbt(mtd, buf, md, td, i);
+	}
+}
+
+//坏块表所在的maxblocks个块标成保留，只有坏块表自己能擦写
+static void mark_bbt_region(struct mtd_info *mtd, struct nand_bbt_descr *td)
+{
+	struct nand_chip *chip = mtd->priv;
+	int bpc = nand_bbt_blocks_per_chip(chip);
+	int i, j, block;
+
+	for (i = 0; i < chip->numchips; i++) {
+		block = (i + 1) * bpc - td->maxblocks;
+		for (j = 0; j < td->maxblocks; j++, block++)
+			chip->bbt[block >> 2] |= 0x02 << ((block & 3) * 2);
+	}
+}
+
+static int nand_scan_bbt(struct mtd_info *mtd, struct nand_bbt_descr *bd)
+{
+	struct nand_chip *chip = mtd->priv;
+	struct nand_bbt_descr *td = chip->bbt_td, *md = chip->bbt_md;
+	int len = mtd->size >> (chip->bbt_erase_shift + 2);
+	uint8_t *buf;
+	int ret = 0;
+
+	chip->bbt = kzalloc(len, GFP_KERNEL);
+	if (!chip->bbt)
+		return -ENOMEM;
+
+	buf = vmalloc(ALIGN(len, mtd->writesize) + mtd->oobsize + mtd->writesize);
+	if (!buf) {
+		kfree(chip->bbt);
+		chip->bbt = NULL;
+		return -ENOMEM;
+	}
+
+	if (!td) {
+		ret = create_bbt(mtd, buf, bd, -1);
+		goto out;
+	}
+
+	search_bbt(mtd, buf, td);
+	search_bbt(mtd, buf, md);
+	check_create(mtd, buf, bd);
+	mark_bbt_region(mtd, td);
+	mark_bbt_region(mtd, md);
+
+out:
+	vfree(buf);
+
+	return ret;
+}
+
+static int nand_update_bbt(struct mtd_info *mtd, loff_t offs)
+{
+	struct nand_chip *chip = mtd->priv;
+	struct nand_bbt_descr *td = chip->bbt_td, *md = chip->bbt_md;
+	int chipnr = (int)(offs >> chip->chip_shift);
+	uint8_t *buf;
+	int ret;
+
+	if (!chip->bbt || !td)
+		return -EINVAL;
+
+	buf = kmalloc((1 << chip->bbt_erase_shift) + mtd->oobsize, GFP_KERNEL);
+	if (!buf)
+		return -ENOMEM;
+
+	td->version[chipnr]++;
+	md->version[chipnr]++;
+
+	ret = write_bbt(mtd, buf, td, md, chipnr);
+	if (!ret)
+		ret = write_bbt(mtd, buf, md, td, chipnr);
+
+	kfree(buf);
+
+	return ret;
+}
+
+int nand_default_bbt(struct mtd_info *mtd)
+{
+	struct nand_chip *chip = mtd->priv;
+
+	if (!(chip->options & NAND_USE_FLASH_BBT)) {
+		chip->bbt_td = NULL;
+		chip->bbt_md = NULL;
+	}
+
+	if (!chip->badblock_pattern) {
+		nand_stub_bbt_pattern.options = chip->options & NAND_BBT_SCAN2NDPAGE;
+		nand_stub_bbt_pattern.offs = chip->badblockpos;
+		chip->badblock_pattern = &nand_stub_bbt_pattern;
+	}
+
+	return nand_scan_bbt(mtd, chip->badblock_pattern);
+}
+
+/*
+ * 识别
+ */
+static struct nand_ecclayout nand_oob_64 = {
+	.eccbytes	= 24,
+	.eccpos		= {
+		40, 41, 42, 43, 44, 45, 46, 47,
+		48, 49, 50, 51, 52, 53, 54, 55,
+		56, 57, 58, 59, 60, 61, 62, 63 },
+	.oobfree	= { { .offset = 2, .length = 38 } },
+};
+
+//驱动芯片表里的几片Samsung大页SLC，单位MiB
+static const struct {
+	u8 dev_id;
+	int size;
+} nand_stub_ids[] = {
+	{ 0xf1, 128 },
+	{ 0xda, 256 },
+	{ 0xdc, 512 },
+	{ 0xd3, 1024 },
+};
+
+static int nand_read_id(struct mtd_info *mtd, int chipnr, u8 *id, int len)
+{
+	struct nand_chip *chip = mtd->priv;
+	int i;
+
+	chip->select_chip(mtd, chipnr);
+	chip->cmdfunc(mtd, NAND_CMD_RESET, -1, -1);
+	chip->cmdfunc(mtd, NAND_CMD_READID, 0x00, -1);
+	for (i = 0; i < len; i++)
+		id[i] = chip->read_byte(mtd);
+	chip->select_chip(mtd, -1);
+
+	return 0;
+}
+
+int nand_scan_ident(struct mtd_info *mtd, int maxchips, struct nand_flash_dev *table)
+{
+	struct nand_chip *chip = mtd->priv;
+	u8 id[5], id2[2];
+	int size = 0;
+	int ext;
+	int i;
+
+	if (!chip->cmdfunc)
+		chip->cmdfunc = nand_command_lp;
+	if (!chip->waitfunc)
+		chip->waitfunc = nand_wait;
+	if (!chip->block_bad)
+		chip->block_bad = nand_block_bad;
+	if (!chip->block_markbad)
+		chip->block_markbad = nand_default_block_markbad;
+	if (!chip->erase_cmd)
+		chip->erase_cmd = single_erase_cmd;
+	if (!chip->scan_bbt)
+		chip->scan_bbt = nand_default_bbt;
+	if (!chip->controller)
+		chip->controller = &chip->hwcontrol;
+
+	nand_read_id(mtd, 0, id, sizeof(id));
+	for (i = 0; i < ARRAY_SIZE(nand_stub_ids); i++)
+		if (id[0] == NAND_MFR_SAMSUNG && id[1] == nand_stub_ids[i].dev_id)
+			size = nand_stub_ids[i].size;
+	if (!size) {
+		printk("No NAND device found (%02x:%02x)\n", id[0], id[1]);
+		return -ENODEV;
+	}
+
+	chip->chipsize = (uint64_t)size << 20;
+	chip->cellinfo = id[2];
+	ext = id[3];
+	mtd->writesize = 1024 << (ext & 0x3);
+	ext >>= 2;
+	mtd->oobsize = (8 << (ext & 0x01)) * (mtd->writesize >> 9);
+	ext >>= 2;
+	mtd->erasesize = (64 * 1024) << (ext & 0x03);
+
+	chip->page_shift = ffs(mtd->writesize) - 1;
+	chip->pagemask = (chip->chipsize >> chip->page_shift) - 1;
+	chip->bbt_erase_shift = chip->phys_erase_shift = ffs(mtd->erasesize) - 1;
+	chip->chip_shift = ffs((unsigned)(chip->chipsize >> 20)) + 20 - 1;
+	chip->badblockpos = NAND_LARGE_BADBLOCK_POS;
+	chip->options |= NAND_NO_AUTOINCR | NAND_NO_READRDY | NAND_CACHEPRG;
+	chip->onfi_version = 0;
+
+	for (i = 1; i < maxchips; i++) {
+		nand_read_id(mtd, i, id2, sizeof(id2));
+		if (id2[0] != id[0] || id2[1] != id[1])
+			break;
+	}
+	chip->numchips = i;
+	mtd->size = i * chip->chipsize;
+
+	printk("NAND device: Manufacturer ID: 0x%02x, Chip ID: 0x%02x (%d MiB x %d)\n",
+	       id[0], id[1], size, i);
+
+	return 0;
+}
+
+int nand_scan_tail(struct mtd_info *mtd)
+{
+	struct nand_chip *chip = mtd->priv;
+	int i;
+
+	chip->buffers = kmalloc(sizeof(*chip->buffers), GFP_KERNEL);
+	if (!chip->buffers)
+		return -ENOMEM;
+	chip->oob_poi = chip->buffers->databuf + mtd->writesize;
+
+	if (!chip->ecc.layout) {
+		if (mtd->oobsize != 64) {
+			printk("No oob scheme defined for oobsize %d\n", mtd->oobsize);
+			return -EINVAL;
+		}
+		chip->ecc.layout = &nand_oob_64;
+	}
+
+	chip->ecc.read_page_raw = nand_read_page_raw;
+	chip->ecc.write_page_raw = nand_write_page_raw;
+	chip->ecc.read_oob = nand_read_oob_std;
+	chip->ecc.write_oob = nand_write_oob_std;
+
+	switch (chip->ecc.mode) {
+	case NAND_ECC_HW:
+		chip->ecc.read_page = nand_read_page_hwecc;
+		chip->ecc.write_page = nand_write_page_hwecc;
+		break;
+
+	case NAND_ECC_SOFT:
+		chip->ecc.calculate = nand_calculate_ecc;
+		chip->ecc.correct = nand_correct_data;
+		chip->ecc.read_page = nand_read_page_swecc;
+		chip->ecc.read_subpage = nand_read_subpage;
+		chip->ecc.write_page = nand_write_page_swecc;
+		chip->ecc.size = 256;
+		chip->ecc.bytes = 3;
+		break;
+
+	default:
+		printk("Invalid NAND_ECC_MODE %d\n", chip->ecc.mode);
+		return -EINVAL;
+	}
+
+	chip->ecc.layout->oobavail = 0;
+	for (i = 0; chip->ecc.layout->oobfree[i].length && i < MTD_MAX_OOBFREE_ENTRIES; i++)
+		chip->ecc.layout->oobavail += chip->ecc.layout->oobfree[i].length;
+	mtd->oobavail = chip->ecc.layout->oobavail;
+
+	chip->ecc.steps = mtd->writesize / chip->ecc.size;
+	chip->ecc.total = chip->ecc.steps * chip->ecc.bytes;
+
+	if (!(chip->options & NAND_NO_SUBPAGE_WRITE) && !(chip->cellinfo & NAND_CI_CELLTYPE_MSK)) {
+		switch (chip->ecc.steps) {
+		case 2:
+			mtd->subpage_sft = 1;
+			break;
+		case 4:
+		case 8:
+		case 16:
+			mtd->subpage_sft = 2;
+			break;
+		}
+	}
+	chip->subpagesize = mtd->writesize >> mtd->subpage_sft;
+
+	chip->state = FL_READY;
+	chip->select_chip(mtd, -1);
+	chip->pagebuf = -1;
+
+	mtd->type = MTD_NANDFLASH;
+	mtd->flags = MTD_CAP_NANDFLASH;
+	mtd->erase = nand_erase;
+	mtd->read = nand_read;
+	mtd->write = nand_write;
+	mtd->read_oob = nand_read_oob;
+	mtd->write_oob = nand_write_oob;
+	mtd->block_isbad = nand_block_isbad;
+	mtd->block_markbad = nand_block_markbad;
+	mtd->writebufsize = mtd->writesize;
+	mtd->ecclayout = chip->ecc.layout;
+
+	return chip->scan_bbt(mtd);
+}
+
+void nand_release(struct mtd_info *mtd)
+{
+	struct nand_chip *chip = mtd->priv;
+
+	mtd_device_unregister(mtd);
+
+	kfree(chip->bbt);
+	chip->bbt = NULL;
+	kfree(chip->buffers);
+	chip->buffers = NULL;
+}
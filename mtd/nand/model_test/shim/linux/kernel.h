@@ -0,0 +1,331 @@
+/*
+ * 在PC上编译s5p_nand_core.c/s5p_nand_model.c/s5p_nand_bch.c用的替身头文件
+ * 只提供这几个文件用到的定义: 测试是单线程的，锁和等待队列都是空操作，
+ * 没有中断和内核线程(request_irq/kthread_run返回失败，驱动退回轮询、不启动scrub)
+ * linux/下的其他头文件都只是包含这个文件
+ */
+#ifndef __SHIM_LINUX_KERNEL_H
+#define __SHIM_LINUX_KERNEL_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef unsigned long long u64;
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef long long s64;
+typedef uint8_t __u8;
+typedef uint16_t __u16;
+typedef uint32_t __u32;
+typedef unsigned long long __u64;
+typedef int32_t __s32;
+typedef uint16_t __le16;
+typedef uint32_t __le32;
+typedef uint32_t __be32;
+typedef unsigned char u_char;
+typedef unsigned int gfp_t;
+
+#define __init
+#define __exit
+#define __user
+#define __iomem
+#define __force
+#define __packed		__attribute__((packed))
+
+#define likely(x)		__builtin_expect(!!(x), 1)
+#define unlikely(x)		__builtin_expect(!!(x), 0)
+
+#define KERN_ERR		""
+#define KERN_WARNING		""
+#define KERN_NOTICE		""
+#define KERN_INFO		""
+#define KERN_DEBUG		""
+#define printk			printf
+#define pr_debug(fmt, ...)	do { if (0) printf(fmt, ##__VA_ARGS__); } while (0)
+#define pr_info			printf
+
+#define WARN_ON(cond)		({ int __c = !!(cond); if (__c) fprintf(stderr, "WARN_ON(%s)\n", #cond); __c; })
+#define BUG()			abort()
+#define BUG_ON(cond)		do { if (cond) abort(); } while (0)
+
+#define ARRAY_SIZE(a)		(sizeof(a) / sizeof((a)[0]))
+#define ALIGN(x, a)		(((x) + (a) - 1) & ~((typeof(x))(a) - 1))
+#define IS_ALIGNED(x, a)	(((x) & ((typeof(x))(a) - 1)) == 0)
+#define DIV_ROUND_UP(n, d)	(((n) + (d) - 1) / (d))
+#define min(x, y)		((x) < (y) ? (x) : (y))
+#define max(x, y)		((x) > (y) ? (x) : (y))
+#define min_t(t, x, y)		min((t)(x), (t)(y))
+#define max_t(t, x, y)		max((t)(x), (t)(y))
+#define max3(x, y, z)		max(max(x, y), z)
+#define clamp(v, lo, hi)	min(max(v, lo), hi)
+#define container_of(p, t, m)	((t *)((char *)(p) - offsetof(t, m)))
+
+static inline int fls(int x)
+{
+	return x ? 32 - __builtin_clz(x) : 0;
+}
+
+#define hweight8(x)		__builtin_popcount((u8)(x))
+#define hweight32(x)		__builtin_popcount((u32)(x))
+
+//PC是小端
+#define le16_to_cpu(x)		((u16)(x))
+#define le32_to_cpu(x)		((u32)(x))
+#define cpu_to_le16(x)		((u16)(x))
+#define cpu_to_le32(x)		((u32)(x))
+#define be32_to_cpu(x)		__builtin_bswap32(x)
+#define cpu_to_be32(x)		__builtin_bswap32(x)
+#define be32_to_cpup(p)		__builtin_bswap32(*(const u32 *)(p))
+
+#ifndef ENOTSUPP
+#define ENOTSUPP		524
+#endif
+
+#define MAX_ERRNO		4095
+#define IS_ERR_VALUE(x)		((unsigned long)(x) >= (unsigned long)-MAX_ERRNO)
+
+static inline void *ERR_PTR(long error)
+{
+	return (void *)error;
+}
+
+static inline long PTR_ERR(const void *ptr)
+{
+	return (long)ptr;
+}
+
+static inline int IS_ERR(const void *ptr)
+{
+	return IS_ERR_VALUE(ptr);
+}
+
+static inline int IS_ERR_OR_NULL(const void *ptr)
+{
+	return !ptr || IS_ERR_VALUE(ptr);
+}
+
+//内存
+#define GFP_KERNEL		0
+#define GFP_DMA			0
+#define kmalloc(size, flags)	malloc(size)
+#define kzalloc(size, flags)	calloc(1, size)
+#define kcalloc(n, size, flags)	calloc(n, size)
+#define kfree(p)		free((void *)(p))
+#define vmalloc(size)		malloc(size)
+#define vzalloc(size)		calloc(1, size)
+#define vfree(p)		free((void *)(p))
+
+//延时: 模型的操作立即完成
+#define udelay(us)		do { } while (0)
+#define ndelay(ns)		do { } while (0)
+#define mdelay(ms)		do { } while (0)
+#define msleep(ms)		do { } while (0)
+#define usleep_range(a, b)	do { } while (0)
+#define cond_resched()		do { } while (0)
+
+//时间，jiffies按毫秒
+#define HZ			1000
+unsigned long host_jiffies(void);
+#define jiffies			host_jiffies()
+#define msecs_to_jiffies(ms)	((unsigned long)(ms))
+#define jiffies_to_msecs(j)	((unsigned int)(j))
+#define time_after(a, b)	((long)((b) - (a)) < 0)
+#define time_before(a, b)	time_after(b, a)
+
+typedef s64 ktime_t;
+ktime_t ktime_get(void);
+#define ktime_sub(a, b)		((a) - (b))
+#define ktime_to_ns(t)		(t)
+#define ktime_to_us(t)		((t) / 1000)
+#define ktime_us_delta(a, b)	ktime_to_us(ktime_sub(a, b))
+
+static inline u64 div_u64(u64 dividend, u32 divisor)
+{
+	return dividend / divisor;
+}
+
+static inline u64 div64_u64(u64 dividend, u64 divisor)
+{
+	return dividend / divisor;
+}
+
+#define do_div(n, base)		({ u32 __rem = (n) % (base); (n) /= (base); __rem; })
+
+//模块
+struct module;
+#define THIS_MODULE		((struct module *)0)
+#define module_param(name, type, perm)
+#define MODULE_PARM_DESC(name, desc)
+#define MODULE_AUTHOR(s)
+#define MODULE_DESCRIPTION(s)
+#define MODULE_LICENSE(s)
+#define EXPORT_SYMBOL(sym)
+#define EXPORT_SYMBOL_GPL(sym)
+#define module_init(fn)		int host_module_init(void) { return fn(); }
+#define module_exit(fn)		void host_module_exit(void) { fn(); }
+
+#define random32()		((u32)random())
+
+u32 crc32_le(u32 crc, const void *p, size_t len);
+#define crc32(seed, p, len)	crc32_le(seed, p, len)
+
+//锁: 单线程
+typedef struct { int dummy; } spinlock_t;
+#define DEFINE_SPINLOCK(x)		spinlock_t x
+#define spin_lock_init(l)		do { } while (0)
+#define spin_lock(l)			do { (void)(l); } while (0)
+#define spin_unlock(l)			do { (void)(l); } while (0)
+#define spin_lock_irqsave(l, f)		do { (void)(l); (f) = 0; } while (0)
+#define spin_unlock_irqrestore(l, f)	do { (void)(l); (void)(f); } while (0)
+
+struct mutex { int dummy; };
+#define DEFINE_MUTEX(x)			struct mutex x
+#define mutex_init(m)			do { } while (0)
+#define mutex_lock(m)			do { (void)(m); } while (0)
+#define mutex_unlock(m)			do { (void)(m); } while (0)
+
+//进程和等待队列
+struct task_struct { int dummy; };
+extern struct task_struct *host_current;
+#define current				host_current
+
+#define TASK_RUNNING			0
+#define TASK_INTERRUPTIBLE		1
+#define TASK_UNINTERRUPTIBLE		2
+#define set_current_state(s)		do { } while (0)
+#define schedule()			do { } while (0)
+#define set_user_nice(p, n)		do { } while (0)
+
+static inline long schedule_timeout_interruptible(long timeout)
+{
+	return 0;
+}
+
+typedef struct { int dummy; } wait_queue_head_t;
+typedef struct { int dummy; } wait_queue_t;
+#define DECLARE_WAIT_QUEUE_HEAD(x)	wait_queue_head_t x
+#define DECLARE_WAITQUEUE(x, tsk)	wait_queue_t x = { 0 }
+#define init_waitqueue_head(q)		do { } while (0)
+#define add_wait_queue(q, w)		do { (void)(q); (void)(w); } while (0)
+#define remove_wait_queue(q, w)		do { (void)(q); (void)(w); } while (0)
+#define wake_up(q)			do { (void)(q); } while (0)
+#define wait_event_freezable(q, cond)	({ (void)&(q); 0; })
+
+#define set_freezable()			do { } while (0)
+#define try_to_freeze()			do { } while (0)
+
+#define kthread_should_stop()		(0)
+
+static inline struct task_struct *kthread_run(int (*fn)(void *data), void *data, const char *name)
+{
+	return ERR_PTR(-ENOSYS);
+}
+
+static inline int kthread_stop(struct task_struct *t)
+{
+	return 0;
+}
+
+struct completion { int done; };
+#define DECLARE_COMPLETION(x)		struct completion x = { 0 }
+#define INIT_COMPLETION(x)		((x).done = 0)
+#define init_completion(x)		((x)->done = 0)
+#define complete(x)			((x)->done = 1)
+#define completion_done(x)		((x)->done)
+#define wait_for_completion_timeout(x, t)	((unsigned long)(x)->done)
+
+//中断: 模型没有
+typedef int irqreturn_t;
+#define IRQ_NONE			0
+#define IRQ_HANDLED			1
+static inline int request_irq(unsigned int irq, irqreturn_t (*handler)(int irq, void *dev_id),
+			      unsigned long flags, const char *name, void *dev)
+{
+	return -ENOSYS;
+}
+
+#define free_irq(irq, dev)		do { } while (0)
+
+//通知链
+struct notifier_block {
+	int (*notifier_call)(struct notifier_block *nb, unsigned long action, void *data);
+};
+#define NOTIFY_DONE			0
+#define NOTIFY_OK			1
+
+#define PM_HIBERNATION_PREPARE		1
+#define PM_POST_HIBERNATION		2
+#define PM_SUSPEND_PREPARE		3
+#define PM_POST_SUSPEND			4
+static inline int register_pm_notifier(struct notifier_block *nb)
+{
+	return 0;
+}
+
+static inline int unregister_pm_notifier(struct notifier_block *nb)
+{
+	return 0;
+}
+
+/*
+ * debugfs和seq_file
+ * 创建的文件记在一个链表里，测试程序用host_debugfs_show()按文件名调用它的show
+ */
+struct inode {
+	void *i_private;
+};
+
+struct file {
+	void *private_data;
+};
+
+struct seq_file {
+	FILE *out;
+	int (*show)(struct seq_file *m, void *v);
+	void *private;
+};
+
+struct file_operations {
+	struct module *owner;
+	int (*open)(struct inode *inode, struct file *file);
+	ssize_t (*read)(struct file *file, char __user *buf, size_t count, loff_t *ppos);
+	ssize_t (*write)(struct file *file, const char __user *buf, size_t count, loff_t *ppos);
+	loff_t (*llseek)(struct file *file, loff_t offset, int whence);
+	int (*release)(struct inode *inode, struct file *file);
+};
+
+struct debugfs_blob_wrapper {
+	void *data;
+	unsigned long size;
+};
+
+struct dentry;
+struct dentry *debugfs_create_dir(const char *name, struct dentry *parent);
+struct dentry *debugfs_create_file(const char *name, mode_t mode, struct dentry *parent,
+				   void *data, const struct file_operations *fops);
+struct dentry *debugfs_create_blob(const char *name, mode_t mode, struct dentry *parent,
+				   struct debugfs_blob_wrapper *blob);
+void debugfs_remove(struct dentry *dentry);
+void debugfs_remove_recursive(struct dentry *dentry);
+
+int single_open(struct file *file, int (*show)(struct seq_file *, void *), void *data);
+int single_release(struct inode *inode, struct file *file);
+ssize_t seq_read(struct file *file, char __user *buf, size_t count, loff_t *ppos);
+loff_t seq_lseek(struct file *file, loff_t offset, int whence);
+//测试程序用: 按文件名打开debugfs文件，把show的输出写到out
+int host_debugfs_show(const char *name, FILE *out);
+#define seq_printf(m, ...)		fprintf((m)->out, __VA_ARGS__)
+#define seq_puts(m, s)			fputs(s, (m)->out)
+
+#endif
@@ -0,0 +1,110 @@
+/*
+ * 3.0内核mtd.h的子集，字段和回调的签名与3.0相同
+ */
+#ifndef __SHIM_MTD_MTD_H
+#define __SHIM_MTD_MTD_H
+
+#include <linux/kernel.h>
+
+#define MTD_NANDFLASH		4
+#define MTD_WRITEABLE		0x400
+#define MTD_CAP_NANDFLASH	(MTD_WRITEABLE)
+
+#define MTD_ERASE_PENDING	0x01
+#define MTD_ERASING		0x02
+#define MTD_ERASE_SUSPEND	0x04
+#define MTD_ERASE_DONE		0x08
+#define MTD_ERASE_FAILED	0x10
+
+#define MTD_FAIL_ADDR_UNKNOWN	-1LL
+
+struct mtd_info;
+
+struct erase_info {
+	struct mtd_info *mtd;
+	uint64_t addr;
+	uint64_t len;
+	uint64_t fail_addr;
+	u_long time;
+	u_long retries;
+	unsigned dev;
+	unsigned cell;
+	void (*callback)(struct erase_info *self);
+	u_long priv;
+	u_char state;
+	struct erase_info *next;
+};
+
+typedef enum {
+	MTD_OOB_PLACE,
+	MTD_OOB_AUTO,
+	MTD_OOB_RAW,
+} mtd_oob_mode_t;
+
+struct mtd_oob_ops {
+	mtd_oob_mode_t mode;
+	size_t len;
+	size_t retlen;
+	size_t ooblen;
+	size_t oobretlen;
+	uint32_t ooboffs;
+	uint8_t *datbuf;
+	uint8_t *oobbuf;
+};
+
+#define MTD_MAX_OOBFREE_ENTRIES	8
+
+struct nand_oobfree {
+	__u32 offset;
+	__u32 length;
+};
+
+struct nand_ecclayout {
+	__u32 eccbytes;
+	__u32 eccpos[64];
+	__u32 oobavail;
+	struct nand_oobfree oobfree[MTD_MAX_OOBFREE_ENTRIES];
+};
+
+struct mtd_ecc_stats {
+	__u32 corrected;
+	__u32 failed;
+	__u32 badblocks;
+	__u32 bbtblocks;
+};
+
+struct mtd_info {
+	u_char type;
+	uint32_t flags;
+	uint64_t size;
+	uint32_t erasesize;
+	uint32_t writesize;
+	uint32_t writebufsize;
+	uint32_t oobsize;
+	uint32_t oobavail;
+
+	const char *name;
+	int index;
+
+	struct nand_ecclayout *ecclayout;
+
+	int (*erase)(struct mtd_info *mtd, struct erase_info *instr);
+	int (*read)(struct mtd_info *mtd, loff_t from, size_t len, size_t *retlen, u_char *buf);
+	int (*write)(struct mtd_info *mtd, loff_t to, size_t len, size_t *retlen, const u_char *buf);
+	int (*read_oob)(struct mtd_info *mtd, loff_t from, struct mtd_oob_ops *ops);
+	int (*write_oob)(struct mtd_info *mtd, loff_t to, struct mtd_oob_ops *ops);
+	void (*sync)(struct mtd_info *mtd);
+	int (*suspend)(struct mtd_info *mtd);
+	void (*resume)(struct mtd_info *mtd);
+	int (*block_isbad)(struct mtd_info *mtd, loff_t ofs);
+	int (*block_markbad)(struct mtd_info *mtd, loff_t ofs);
+
+	struct mtd_ecc_stats ecc_stats;
+	int subpage_sft;
+
+	void *priv;
+	struct module *owner;
+	int usecount;
+};
+
+#endif
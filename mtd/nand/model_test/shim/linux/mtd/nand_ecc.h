@@ -0,0 +1,12 @@
+/*
+ * 3.0内核nand_ecc.h的子集，软件汉明码在nand_stub.c里
+ */
+#ifndef __SHIM_MTD_NAND_ECC_H
+#define __SHIM_MTD_NAND_ECC_H
+
+#include <linux/mtd/nand.h>
+
+int nand_calculate_ecc(struct mtd_info *mtd, const u_char *dat, u_char *ecc_code);
+int nand_correct_data(struct mtd_info *mtd, u_char *dat, u_char *read_ecc, u_char *calc_ecc);
+
+#endif
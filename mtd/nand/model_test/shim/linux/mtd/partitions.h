@@ -0,0 +1,27 @@
+/*
+ * 3.0内核partitions.h的子集
+ */
+#ifndef __SHIM_MTD_PARTITIONS_H
+#define __SHIM_MTD_PARTITIONS_H
+
+#include <linux/mtd/mtd.h>
+
+struct mtd_partition {
+	char *name;
+	uint64_t size;
+	uint64_t offset;
+	uint32_t mask_flags;
+	struct nand_ecclayout *ecclayout;
+};
+
+#define MTDPART_OFS_NXTBLK	(-2)
+#define MTDPART_OFS_APPEND	(-1)
+#define MTDPART_SIZ_FULL	(0)
+
+int parse_mtd_partitions(struct mtd_info *master, const char **types,
+			 struct mtd_partition **pparts, unsigned long origin);
+int mtd_device_register(struct mtd_info *master, const struct mtd_partition *parts,
+			int nr_parts);
+int mtd_device_unregister(struct mtd_info *master);
+
+#endif
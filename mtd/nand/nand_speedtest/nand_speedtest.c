@@ -0,0 +1,435 @@
+/*
+ * nand_speedtest: MTD分区读写/擦除/OOB速度测试，类似内核的mtd_speedtest，
+ * 但在用户态运行，开发板上和PC上的nandsim都可以用，方便对比驱动修改前后的性能。
+ *
+ * 用法: nand_speedtest [-w] [-b blocks] [-n count] [-s size,size,...] /dev/mtdX
+ *   -w  进行写和擦除测试(会破坏分区上的数据!)，不加只做读测试
+ *   -b  参与测试的好块数，默认64，0表示整个分区
+ *   -n  随机读的次数，默认1000
+ *   -s  传输大小列表，必须是页大小的整数倍，默认: 1页,4页,1块
+ *
+ * 每项测试输出: 操作次数、吞吐量(KiB/s)、单次操作延时的p50/p90/p99/max(us)
+ */
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <errno.h>
+#include <mtd/mtd-user.h>
+
+#define MAX_SIZES	8
+
+struct latency {
+	double *us;
+	int n;
+	int cap;
+};
+
+static int fd;
+static struct mtd_info_user mi;
+static int *blocks;		//参与测试的好块
+static int nr_blocks;
+static unsigned char *buf;
+static unsigned char *oobbuf;
+static int has_ecc_stats;
+static struct mtd_ecc_stats ecc_stats;
+
+static double now_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0;
+}
+
+static void lat_add(struct latency *l, double us)
+{
+	if (l->n == l->cap) {
+		l->cap = l->cap ? l->cap * 2 : 1024;
+		l->us = realloc(l->us, l->cap * sizeof(double));
+		if (!l->us) {
+			fprintf(stderr, "out of memory\n");
+			exit(1);
+		}
+	}
+
+	l->us[l->n++] = us;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static double percentile(struct latency *l, int p)
+{
+	int i = (l->n * p + 99) / 100 - 1;
+
+	if (i < 0)
+		i = 0;
+
+	return l->us[i];
+}
+
+static void report(const char *name, int size, struct latency *l,
+		   unsigned long long bytes, double total_us)
+{
+	char label[64];
+
+	if (size)
+		snprintf(label, sizeof(label), "%s %dK", name, size / 1024);
+	else
+		snprintf(label, sizeof(label), "%s", name);
+
+	if (!l->n) {
+		printf("%-24s no operations\n", label);
+		return;
+	}
+
+	qsort(l->us, l->n, sizeof(double), cmp_double);
+
+	printf("%-24s %7d %10.0f %9.0f %9.0f %9.0f %9.0f\n", label, l->n,
+	       bytes / 1024.0 / (total_us / 1000000.0),
+	       percentile(l, 50), percentile(l, 90), percentile(l, 99), l->us[l->n - 1]);
+
+	free(l->us);
+	memset(l, 0, sizeof(*l));
+}
+
+static void die(const char *what)
+{
+	perror(what);
+	exit(1);
+}
+
+static void scan_blocks(int limit)
+{
+	int total = mi.size / mi.erasesize;
+	loff_t ofs;
+	int i;
+
+	blocks = malloc(total * sizeof(int));
+	if (!blocks)
+		die("malloc");
+
+	for (i = 0; i < total; i++) {
+		ofs = (loff_t)i * mi.erasesize;
+		if (ioctl(fd, MEMGETBADBLOCK, &ofs) > 0)
+			continue;
+
+		blocks[nr_blocks++] = i;
+		if (limit && nr_blocks == limit)
+			break;
+	}
+}
+
+//偏移用64位，Makefile里定义了_FILE_OFFSET_BITS=64，ARM上2GiB以上的分区pread/pwrite也不会溢出
+static loff_t block_ofs(int i)
+{
+	return (loff_t)blocks[i] * mi.erasesize;
+}
+
+/*
+ * mtdchar读到纠正过(-EUCLEAN)甚至不可纠错(-EBADMSG)的页时照样返回完整的数据，
+ * 返回值只说明传输了多少字节，纠错情况要看ECCGETSTATS统计的变化
+ */
+static void ecc_begin(void)
+{
+	has_ecc_stats = (ioctl(fd, ECCGETSTATS, &ecc_stats) == 0);
+}
+
+static void ecc_end(const char *name)
+{
+	struct mtd_ecc_stats st;
+
+	if (!has_ecc_stats || ioctl(fd, ECCGETSTATS, &st) < 0)
+		return;
+
+	if (st.failed != ecc_stats.failed) {
+		fprintf(stderr, "%s: %u uncorrectable ECC errors\n", name, st.failed - ecc_stats.failed);
+		exit(1);
+	}
+
+	if (st.corrected != ecc_stats.corrected)
+		printf("%-24s %u bitflips corrected\n", "", st.corrected - ecc_stats.corrected);
+}
+
+static void read_at(int size, loff_t ofs)
+{
+	errno = 0;
+	if (pread(fd, buf, size, ofs) != size)
+		die("read");
+}
+
+static void write_at(int size, loff_t ofs)
+{
+	errno = 0;
+	if (pwrite(fd, buf, size, ofs) != size)
+		die("write");
+}
+
+static void erase_block(int i)
+{
+	struct erase_info_user ei;
+
+	ei.start = block_ofs(i);
+	ei.length = mi.erasesize;
+	if (ioctl(fd, MEMERASE, &ei) < 0)
+		die("MEMERASE");
+}
+
+static void test_erase(void)
+{
+	struct latency l = { 0 };
+	double start, t;
+	int i;
+
+	start = now_us();
+	for (i = 0; i < nr_blocks; i++) {
+		t = now_us();
+		erase_block(i);
+		lat_add(&l, now_us() - t);
+	}
+
+	report("erase", 0, &l, (unsigned long long)nr_blocks * mi.erasesize, now_us() - start);
+}
+
+static void test_seq(int write, int size)
+{
+	struct latency l = { 0 };
+	unsigned long long bytes = 0;
+	double start, t;
+	loff_t ofs;
+	int i;
+
+	ecc_begin();
+	start = now_us();
+	for (i = 0; i < nr_blocks; i++) {
+		for (ofs = 0; ofs < mi.erasesize; ofs += size) {
+			t = now_us();
+			if (write)
+				write_at(size, block_ofs(i) + ofs);
+			else
+				read_at(size, block_ofs(i) + ofs);
+			lat_add(&l, now_us() - t);
+			bytes += size;
+		}
+	}
+
+	report(write ? "seq write" : "seq read", size, &l, bytes, now_us() - start);
+	if (!write)
+		ecc_end("seq read");
+}
+
+static void test_rand_read(int size, int count)
+{
+	struct latency l = { 0 };
+	int per_block = mi.erasesize / size;
+	double start, t;
+	loff_t ofs;
+	int i;
+
+	ecc_begin();
+	start = now_us();
+	for (i = 0; i < count; i++) {
+		ofs = block_ofs(rand() % nr_blocks) + (loff_t)(rand() % per_block) * size;
+
+		t = now_us();
+		read_at(size, ofs);
+		lat_add(&l, now_us() - t);
+	}
+
+	report("rand read", size, &l, (unsigned long long)count * size, now_us() - start);
+	ecc_end("rand read");
+}
+
+//随机选块整块读，和随机选块擦除后整块写
+static void test_rand_block(int write)
+{
+	struct latency l = { 0 };
+	double start, t;
+	int i, b;
+
+	ecc_begin();
+	start = now_us();
+	for (i = 0; i < nr_blocks; i++) {
+		b = rand() % nr_blocks;
+
+		t = now_us();
+		if (write) {
+			erase_block(b);
+			write_at(mi.erasesize, block_ofs(b));
+		} else {
+			read_at(mi.erasesize, block_ofs(b));
+		}
+		lat_add(&l, now_us() - t);
+	}
+
+	report(write ? "rand block erase+write" : "rand block read", 0, &l,
+	       (unsigned long long)nr_blocks * mi.erasesize, now_us() - start);
+	if (!write)
+		ecc_end("rand block read");
+}
+
+//OOB: 每块第一页，写的是OOB空闲区的8个字节(8~15)
+static void test_oob(int write)
+{
+	struct latency l = { 0 };
+	struct mtd_oob_buf oob;
+	double start, t;
+	int pages = mi.erasesize / mi.writesize;
+	int i, p;
+
+	start = now_us();
+	for (i = 0; i < nr_blocks; i++) {
+		for (p = 0; p < pages; p++) {
+			oob.ptr = oobbuf;
+			if (write) {
+				oob.start = block_ofs(i) + (loff_t)p * mi.writesize + 8;
+				oob.length = 8;
+			} else {
+				oob.start = block_ofs(i) + (loff_t)p * mi.writesize;
+				oob.length = mi.oobsize;
+			}
+
+			t = now_us();
+			if (ioctl(fd, write ? MEMWRITEOOB : MEMREADOOB, &oob) < 0)
+				die(write ? "MEMWRITEOOB" : "MEMREADOOB");
+			lat_add(&l, now_us() - t);
+		}
+	}
+
+	report(write ? "oob write" : "oob read", 0, &l,
+	       (unsigned long long)nr_blocks * pages * (write ? 8 : mi.oobsize), now_us() - start);
+}
+
+static int parse_sizes(char *arg, int *sizes)
+{
+	char *tok;
+	int n = 0;
+
+	for (tok = strtok(arg, ","); tok && n < MAX_SIZES; tok = strtok(NULL, ","))
+		sizes[n++] = strtol(tok, NULL, 0);
+
+	return n;
+}
+
+static void printusage(char *name)
+{
+	fprintf(stderr, "Usage: %s [-w] [-b blocks] [-n count] [-s size,...] /dev/mtdX\n", name);
+	fprintf(stderr, "  -w  run write/erase tests (destroys data on the partition)\n");
+	fprintf(stderr, "  -b  number of good blocks to use, 0 = whole partition (default 64)\n");
+	fprintf(stderr, "  -n  number of random reads (default 1000)\n");
+	fprintf(stderr, "  -s  transfer sizes, multiples of the page size (default page,4*page,block)\n");
+}
+
+int main(int argc, char **argv)
+{
+	int sizes[MAX_SIZES];
+	int nr_sizes = 0;
+	int write = 0;
+	int limit = 64;
+	int count = 1000;
+	int opt;
+	int i;
+
+	while ((opt = getopt(argc, argv, "wb:n:s:")) != -1) {
+		switch (opt) {
+		case 'w':
+			write = 1;
+			break;
+		case 'b':
+			limit = atoi(optarg);
+			break;
+		case 'n':
+			count = atoi(optarg);
+			break;
+		case 's':
+			nr_sizes = parse_sizes(optarg, sizes);
+			break;
+		default:
+			printusage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (optind != argc - 1) {
+		printusage(argv[0]);
+		return 1;
+	}
+
+	fd = open(argv[optind], write ? O_RDWR : O_RDONLY);
+	if (fd < 0)
+		die(argv[optind]);
+
+	if (ioctl(fd, MEMGETINFO, &mi) < 0)
+		die("MEMGETINFO");
+
+	if (!nr_sizes) {
+		sizes[nr_sizes++] = mi.writesize;
+		sizes[nr_sizes++] = mi.writesize * 4;
+		sizes[nr_sizes++] = mi.erasesize;
+	}
+
+	for (i = 0; i < nr_sizes; i++) {
+		if (sizes[i] <= 0 || sizes[i] % mi.writesize || mi.erasesize % sizes[i]) {
+			fprintf(stderr, "size %d must be a multiple of the page size (%u) "
+				"and divide the block size (%u)\n", sizes[i], mi.writesize, mi.erasesize);
+			return 1;
+		}
+	}
+
+	scan_blocks(limit);
+	if (!nr_blocks) {
+		fprintf(stderr, "no good blocks\n");
+		return 1;
+	}
+
+	buf = malloc(mi.erasesize);
+	oobbuf = malloc(mi.oobsize);
+	if (!buf || !oobbuf)
+		die("malloc");
+
+	srand(time(NULL));
+	for (i = 0; i < mi.erasesize; i++)
+		buf[i] = rand();
+	memset(oobbuf, 0xa5, mi.oobsize);
+
+	printf("%s: %u MiB, block %u KiB, page %u, oob %u, testing %d good blocks%s\n\n",
+	       argv[optind], (unsigned)(mi.size >> 20), mi.erasesize >> 10, mi.writesize,
+	       mi.oobsize, nr_blocks, write ? "" : " (read only)");
+	printf("%-24s %7s %10s %9s %9s %9s %9s\n", "test", "ops", "KiB/s",
+	       "p50(us)", "p90(us)", "p99(us)", "max(us)");
+
+	if (write) {
+		test_erase();
+		test_oob(1);
+	}
+	test_oob(0);
+
+	for (i = 0; i < nr_sizes; i++) {
+		if (write) {
+			test_erase();
+			test_seq(1, sizes[i]);
+		}
+		test_seq(0, sizes[i]);
+		test_rand_read(sizes[i], count);
+	}
+
+	test_rand_block(0);
+	if (write)
+		test_rand_block(1);
+
+	close(fd);
+
+	return 0;
+}
@@ -0,0 +1,66 @@
+/*
+ * s5p_nand内部共用的定义: 控制器寄存器和寄存器访问后端
+ * 驱动不直接访问寄存器，而是通过s5p_nand_io指向的后端:
+ *   hw:    ioremap的真实NFCON寄存器(只有s5pv210上有)
+ *   model: s5p_nand_model.c里的软件模型，寄存器和内存中的nandflash，可以在任何平台上运行
+ */
+#ifndef __S5P_NAND_H
+#define __S5P_NAND_H
+
+#include <linux/types.h>
+#include <linux/stddef.h>
+
+#define S5P_NAND_BASE		0xB0E00000
+
+#define S5P_NFCONT_NCE0		(1 << 1)
+#define S5P_NFCONT_RNB_INT	(1 << 9)	//EnbRnBINT
+#define S5P_NFCONT_RNB_MODE	(1 << 8)	//RnB_TransMode, 0 = 上升沿
+#define S5P_NFSTAT_RNB_READY	(1 << 0)
+#define S5P_NFSTAT_RNB_TRANS	(1 << 4)	//写1清除
+
+//没有时钟框架时(模型)按HCLK_PSYS的典型值计算时序
+#define S5P_NAND_MODEL_HCLK	133000000
+
+struct s5p_nand_regs {
+	u32 nfconf;
+	u32 nfcont;
+	u32 nfcmmd;
+	u32 nfaddr;
+	u32 nfdata;
+	u32 nfmeccd0;
+	u32 nfmeccd1;
+	u32 nfseccd;
+	u32 nfsblk;
+	u32 nfeblk;
+	u32 nfstat;
+	u32 nfeccerr0;
+	u32 nfeccerr1;
+	u32 nfmecc0;
+	u32 nfmecc1;
+	u32 nfsecc;
+	u32 nfmlcbitpt;
+};
+
+#define S5P_NAND_REG(r)		offsetof(struct s5p_nand_regs, r)
+
+struct s5p_nand_reg_ops {
+	const char *name;
+	int irq;			//R/nB中断，0表示只能轮询
+	int  (*init)(void);
+	void (*exit)(void);
+	u32  (*reg_read)(unsigned int reg);
+	void (*reg_write)(u32 val, unsigned int reg);
+	//nfdata的字节访问和按字的连续访问
+	u8   (*data_readb)(void);
+	void (*data_writeb)(u8 val);
+	void (*data_reads)(void *buf, int words);
+	void (*data_writes)(const void *buf, int words);
+};
+
+extern const struct s5p_nand_reg_ops s5p_nand_model_ops;
+
+//在debugfs的s5p_nand目录下创建model文件: 读出操作统计和模拟的总线时间，写入任意内容清零
+struct dentry;
+void s5p_nand_model_debugfs(struct dentry *dir);
+
+#endif
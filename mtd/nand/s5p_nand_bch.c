@@ -0,0 +1,304 @@
+/*
+ * s5p_nand的BCH ECC
+ *
+ * 码字: c(x) = d(x) * x^r + p(x)，d(x)是512字节数据(第0字节的bit7是最高次)，
+ *       r = 13 * t，p(x) = d(x) * x^r mod g(x)，g(x)是alpha^1..alpha^2t最小多项式的乘积
+ * 编码: 校验位寄存器左对齐放在4个u32里，每次处理一个32bit的字，查4张256项的表，
+ *       比逐bit的LFSR快一个数量级，和内核lib/bch的做法相同
+ * 解码: 读出的ECC和重新计算的ECC异或就是错误多项式对g(x)的余式，
+ *       用它(不超过104bit)算伴随式，Berlekamp-Massey求错误位置多项式，
+ *       Chien搜索在对数域里做，每个位置每一项只要一次加法和一次查表
+ *       只有一个错误时直接由系数求根，不用搜索
+ * 2.6/3.0的ARM内核不能在内核态使用NEON，这里全部是查表的整数运算
+ */
+#ifdef __KERNEL__
+#include <linux/kernel.h>
+#include <linux/string.h>
+#else
+#include <string.h>
+#endif
+
+#include "s5p_nand_bch.h"
+
+static inline u16 gf_mul(struct s5p_bch *bch, u16 a, u16 b)
+{
+	return (a && b) ? bch->a_pow[bch->a_log[a] + bch->a_log[b]] : 0;
+}
+
+static inline u16 gf_div(struct s5p_bch *bch, u16 a, u16 b)
+{
+	return a ? bch->a_pow[bch->a_log[a] + S5P_BCH_N - bch->a_log[b]] : 0;
+}
+
+//寄存器左移一位，移入bit，最高位反馈到生成多项式
+static void lfsr_step(struct s5p_bch *bch, u32 *reg, int bit)
+{
+	int fb = (reg[0] >> 31) ^ bit;
+	int i;
+
+	for (i = 0; i < S5P_BCH_ECC_WORDS - 1; i++)
+		reg[i] = (reg[i] << 1) | (reg[i + 1] >> 31);
+	reg[i] <<= 1;
+
+	if (fb)
+		for (i = 0; i < S5P_BCH_ECC_WORDS; i++)
+			reg[i] ^= bch->genpoly[i];
+}
+
+static void build_gf_tables(struct s5p_bch *bch)
+{
+	u32 x = 1;
+	int i;
+
+	for (i = 0; i < S5P_BCH_N; i++) {
+		bch->a_pow[i] = x;
+		bch->a_pow[i + S5P_BCH_N] = x;
+		bch->a_log[x] = i;
+		x <<= 1;
+		if (x & (1 << S5P_BCH_M))
+			x ^= S5P_BCH_PRIM_POLY;
+	}
+	bch->a_log[0] = 0;
+}
+
+//g(x) = 各个奇数j的最小多项式之积，最小多项式 = 分圆陪集{j*2^k}上(x + alpha^c)之积
+static void build_genpoly(struct s5p_bch *bch)
+{
+	u8 g[S5P_BCH_M * S5P_BCH_MAX_T + 1];
+	u16 m[S5P_BCH_M + 1];
+	int deg = 0;
+	int j, c, k, i, mdeg, dup;
+
+	memset(g, 0, sizeof(g));
+	g[0] = 1;
+
+	for (j = 1; j < 2 * bch->t; j += 2) {
+		//前面的奇数已经包含了这个陪集
+		dup = 0;
+		for (k = 1; k < j; k += 2) {
+			c = k;
+			do {
+				if (c == j)
+					dup = 1;
+				c = (c * 2) % S5P_BCH_N;
+			} while (c != k);
+		}
+		if (dup)
+			continue;
+
+		memset(m, 0, sizeof(m));
+		m[0] = 1;
+		mdeg = 0;
+		c = j;
+		do {
+			//m(x) *= (x + alpha^c)
+			for (i = mdeg + 1; i > 0; i--)
+				m[i] = m[i - 1] ^ gf_mul(bch, m[i], bch->a_pow[c]);
+			m[0] = gf_mul(bch, m[0], bch->a_pow[c]);
+			mdeg++;
+			c = (c * 2) % S5P_BCH_N;
+		} while (c != j);
+
+		//系数都在GF(2)里，按二进制多项式乘进g(x)
+		for (i = deg; i >= 0; i--) {
+			if (!g[i])
+				continue;
+			g[i] = 0;
+			for (k = 0; k <= mdeg; k++)
+				g[i + k] ^= m[k];
+		}
+		deg += mdeg;
+	}
+
+	//x^(r-1)放在genpoly[0]的bit31
+	memset(bch->genpoly, 0, sizeof(bch->genpoly));
+	for (i = 0; i < deg; i++)
+		if (g[deg - 1 - i])
+			bch->genpoly[i / 32] |= 0x80000000 >> (i % 32);
+}
+
+static void build_mod_tab(struct s5p_bch *bch)
+{
+	u32 reg[S5P_BCH_ECC_WORDS];
+	int k, b, i;
+
+	for (k = 0; k < 4; k++) {
+		for (b = 0; b < 256; b++) {
+			memset(reg, 0, sizeof(reg));
+			for (i = 7; i >= 0; i--)
+				lfsr_step(bch, reg, (b >> i) & 1);
+			for (i = 0; i < 8 * k; i++)
+				lfsr_step(bch, reg, 0);
+			memcpy(bch->mod_tab[k][b], reg, sizeof(reg));
+		}
+	}
+}
+
+int s5p_bch_init(struct s5p_bch *bch, int t)
+{
+	u8 ff[S5P_BCH_DATA_BYTES];
+	int i;
+
+	if (t < S5P_BCH_MIN_T || t > S5P_BCH_MAX_T)
+		return -1;
+
+	bch->t = t;
+	bch->ecc_bits = S5P_BCH_M * t;
+	bch->ecc_bytes = (bch->ecc_bits + 7) / 8;
+
+	build_gf_tables(bch);
+	build_genpoly(bch);
+	build_mod_tab(bch);
+
+	//擦除页的ECC取反作为掩码，写入和读出时都异或它
+	memset(bch->ecc_mask, 0, sizeof(bch->ecc_mask));
+	memset(ff, 0xff, sizeof(ff));
+	s5p_bch_encode(bch, ff, bch->ecc_mask);
+	for (i = 0; i < bch->ecc_bytes; i++)
+		bch->ecc_mask[i] = ~bch->ecc_mask[i];
+
+	return 0;
+}
+
+void s5p_bch_encode(struct s5p_bch *bch, const u8 *data, u8 *ecc)
+{
+	u32 r0 = 0, r1 = 0, r2 = 0, r3 = 0;
+	const u32 *p0, *p1, *p2, *p3;
+	u32 w;
+	int i;
+
+	for (i = 0; i < S5P_BCH_DATA_BYTES; i += 4) {
+		w = ((u32)data[i] << 24 | (u32)data[i + 1] << 16 |
+		     (u32)data[i + 2] << 8 | data[i + 3]) ^ r0;
+
+		p0 = bch->mod_tab[3][w >> 24];
+		p1 = bch->mod_tab[2][(w >> 16) & 0xff];
+		p2 = bch->mod_tab[1][(w >> 8) & 0xff];
+		p3 = bch->mod_tab[0][w & 0xff];
+
+		r0 = r1 ^ p0[0] ^ p1[0] ^ p2[0] ^ p3[0];
+		r1 = r2 ^ p0[1] ^ p1[1] ^ p2[1] ^ p3[1];
+		r2 = r3 ^ p0[2] ^ p1[2] ^ p2[2] ^ p3[2];
+		r3 = p0[3] ^ p1[3] ^ p2[3] ^ p3[3];
+	}
+
+	for (i = 0; i < bch->ecc_bytes; i++) {
+		w = (i < 4) ? r0 : (i < 8) ? r1 : (i < 12) ? r2 : r3;
+		ecc[i] = (w >> (24 - 8 * (i % 4))) ^ bch->ecc_mask[i];
+	}
+}
+
+int s5p_bch_correct(struct s5p_bch *bch, u8 *data,
+		    const u8 *read_ecc, const u8 *calc_ecc)
+{
+	int t = bch->t;
+	int r = bch->ecc_bits;
+	int nbits = S5P_BCH_DATA_BYTES * 8 + r;
+	u8 diff[S5P_BCH_MAX_ECC_BYTES];
+	u16 syn[2 * S5P_BCH_MAX_T + 1];
+	u16 C[2 * S5P_BCH_MAX_T + 1], B[2 * S5P_BCH_MAX_T + 1], T[2 * S5P_BCH_MAX_T + 1];
+	int lg[S5P_BCH_MAX_T], step[S5P_BCH_MAX_T];
+	int pos[S5P_BCH_MAX_T];
+	int L, m, n, i, j, k, found, nterms;
+	u16 b, d, coef, acc;
+	int nonzero = 0;
+
+	for (i = 0; i < bch->ecc_bytes; i++) {
+		diff[i] = read_ecc[i] ^ calc_ecc[i];
+		nonzero |= diff[i];
+	}
+	if (!nonzero)
+		return 0;
+
+	//最后一个字节没用到的低位
+	diff[bch->ecc_bytes - 1] &= 0xff << (bch->ecc_bytes * 8 - r);
+
+	//余式第i位是x^(r-1-i)的系数，次数小于104，j*deg不会超过N
+	memset(syn, 0, sizeof(syn));
+	for (i = 0; i < r; i++) {
+		if (!(diff[i / 8] & (0x80 >> (i % 8))))
+			continue;
+		for (j = 1; j < 2 * t; j += 2)
+			syn[j] ^= bch->a_pow[j * (r - 1 - i)];
+	}
+	for (j = 2; j <= 2 * t; j += 2)
+		syn[j] = gf_mul(bch, syn[j / 2], syn[j / 2]);
+
+	//Berlekamp-Massey
+	memset(C, 0, sizeof(C));
+	memset(B, 0, sizeof(B));
+	C[0] = B[0] = 1;
+	L = 0;
+	m = 1;
+	b = 1;
+	for (n = 0; n < 2 * t; n++) {
+		d = syn[n + 1];
+		for (i = 1; i <= L; i++)
+			d ^= gf_mul(bch, C[i], syn[n + 1 - i]);
+		if (!d) {
+			m++;
+			continue;
+		}
+
+		coef = gf_div(bch, d, b);
+		memcpy(T, C, sizeof(T));
+		for (i = 0; i + m <= 2 * t; i++)
+			C[i + m] ^= gf_mul(bch, coef, B[i]);
+
+		if (2 * L <= n) {
+			L = n + 1 - L;
+			memcpy(B, T, sizeof(B));
+			b = d;
+			m = 1;
+		} else {
+			m++;
+		}
+	}
+
+	if (L > t || C[L] == 0)
+		return -1;
+	for (i = L + 1; i <= 2 * t; i++)
+		if (C[i])
+			return -1;
+
+	//Chien搜索: sigma(alpha^-i) = 0 表示x^i处有错
+	found = 0;
+	if (L == 1) {
+		pos[found++] = bch->a_log[C[1]];
+		if (pos[0] >= nbits)
+			return -1;
+	} else {
+		//只保留非0的项，lg[]是当前位置各项的对数，step[]是每移一个位置要减的量
+		for (k = 1, nterms = 0; k <= L; k++) {
+			if (!C[k])
+				continue;
+			lg[nterms] = bch->a_log[C[k]];
+			step[nterms++] = k;
+		}
+
+		for (i = 0; i < nbits && found < L; i++) {
+			acc = 1;
+			for (k = 0; k < nterms; k++) {
+				acc ^= bch->a_pow[lg[k]];
+				lg[k] -= step[k];
+				if (lg[k] < 0)
+					lg[k] += S5P_BCH_N;
+			}
+			if (!acc)
+				pos[found++] = i;
+		}
+
+		if (found != L)
+			return -1;
+	}
+
+	//x^0..x^(r-1)是校验位，不用改数据
+	for (i = 0; i < found; i++) {
+		if (pos[i] < r)
+			continue;
+		k = pos[i] - r;
+		data[S5P_BCH_DATA_BYTES - 1 - k / 8] ^= 1 << (k % 8);
+	}
+
+	return found;
+}
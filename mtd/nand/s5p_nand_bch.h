@@ -0,0 +1,54 @@
+/*
+ * s5p_nand的BCH ECC，GF(2^13)，每512字节纠正t个bit
+ * 只依赖基本类型，内核模块和PC上的bch_test用的是同一份代码
+ */
+#ifndef __S5P_NAND_BCH_H
+#define __S5P_NAND_BCH_H
+
+#ifdef __KERNEL__
+#include <linux/types.h>
+#else
+#include <stdint.h>
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+#endif
+
+#define S5P_BCH_DATA_BYTES	512		//每个ECC步的数据
+#define S5P_BCH_M		13
+#define S5P_BCH_N		((1 << S5P_BCH_M) - 1)
+#define S5P_BCH_PRIM_POLY	0x201b		//x^13 + x^4 + x^3 + x + 1
+#define S5P_BCH_MIN_T		4		//按字编码要求校验位不少于32bit
+#define S5P_BCH_MAX_T		8
+#define S5P_BCH_MAX_ECC_BYTES	((S5P_BCH_M * S5P_BCH_MAX_T + 7) / 8)
+#define S5P_BCH_ECC_WORDS	4		//校验位寄存器，左对齐的128bit
+
+struct s5p_bch {
+	int t;
+	int ecc_bits;
+	int ecc_bytes;
+
+	u16 a_pow[2 * S5P_BCH_N];		//alpha^i，长度两倍省掉取模
+	u16 a_log[S5P_BCH_N + 1];
+	u32 genpoly[S5P_BCH_ECC_WORDS];		//生成多项式去掉最高次项，左对齐
+	u32 mod_tab[4][256][S5P_BCH_ECC_WORDS];	//按字编码: 第k个字节b对应 b*x^(8k+ecc_bits) mod g
+	u8 ecc_mask[S5P_BCH_MAX_ECC_BYTES];	//擦除页(全0xff)的ECC也是全0xff
+};
+
+/*
+ * bch由调用者分配(约70KB，内核里用vmalloc)
+ * t超出[S5P_BCH_MIN_T, S5P_BCH_MAX_T]返回-1
+ */
+int s5p_bch_init(struct s5p_bch *bch, int t);
+
+//对S5P_BCH_DATA_BYTES字节的data计算ECC，输出bch->ecc_bytes个字节
+void s5p_bch_encode(struct s5p_bch *bch, const u8 *data, u8 *ecc);
+
+/*
+ * read_ecc是从OOB读出的ECC，calc_ecc是对读出的数据s5p_bch_encode的结果
+ * 返回纠正的bit数(包括ECC字节中的错误)，不可纠正返回-1，data就地修正
+ */
+int s5p_bch_correct(struct s5p_bch *bch, u8 *data,
+		    const u8 *read_ecc, const u8 *calc_ecc);
+
+#endif
@@ -0,0 +1,2751 @@
+#include <linux/slab.h>
+#include <linux/init.h>
+#include <linux/module.h>
+#include <linux/delay.h>
+#include <linux/clk.h>
+#include <linux/cpufreq.h>
+#include <linux/err.h>
+#include <linux/mm.h>
+#include <linux/completion.h>
+#include <linux/interrupt.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/vmalloc.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/mutex.h>
+#include <linux/crc32.h>
+#include <linux/kthread.h>
+#include <linux/freezer.h>
+#include <linux/suspend.h>
+#include <linux/spinlock.h>
+#include <linux/wait.h>
+
+#include <linux/mtd/mtd.h>
+#include <linux/mtd/nand.h>
+#include <linux/mtd/nand_ecc.h>
+#include <linux/mtd/partitions.h>
+
+#ifdef CONFIG_ARCH_S5PV210
+#include <plat/regs-nand.h>
+#include <plat/nand.h>
+
+#include <asm/io.h>
+#include <asm/sizes.h>
+#include <mach/hardware.h>
+#include <mach/gpio.h>
+#include <mach/irqs.h>
+#else
+#include <asm/io.h>
+
+#define SZ_1K			0x00000400
+#define SZ_1M			0x00100000
+#endif
+
+#include "s5p_nand.h"
+#include "s5p_nand_bch.h"
+
+ 
+/* Nand flash definition values */
+#define S5P_NAND_TYPE_UNKNOWN	0x0
+#define S5P_NAND_TYPE_SLC	0x1
+#define S5P_NAND_TYPE_MLC	0x2
+
+static int nand_type = S5P_NAND_TYPE_SLC;
+static struct mtd_info	*s5p_mtd = NULL;
+static struct nand_chip *s5p_nand = NULL;
+
+/*
+ * 寄存器访问后端
+ * regs=hw(s5pv210上的默认值)访问真实的控制器，regs=model使用s5p_nand_model.c里的软件模型，
+ * 模型只在make MODEL=y时编进驱动(定义S5P_NAND_MODEL)，PC上由model_test链接
+ */
+#if !defined(CONFIG_ARCH_S5PV210) && !defined(S5P_NAND_MODEL)
+#error "s5p_nand needs CONFIG_ARCH_S5PV210 or the register model (make MODEL=y)"
+#endif
+
+#ifdef CONFIG_ARCH_S5PV210
+static char *regs = "hw";
+#else
+static char *regs = "model";
+#endif
+module_param(regs, charp, 0444);
+MODULE_PARM_DESC(regs, "Register backend: hw or model");
+
+static const struct s5p_nand_reg_ops *s5p_nand_io;
+
+#define s5p_nand_readl(r)	s5p_nand_io->reg_read(S5P_NAND_REG(r))
+#define s5p_nand_writel(v, r)	s5p_nand_io->reg_write(v, S5P_NAND_REG(r))
+
+#ifdef CONFIG_ARCH_S5PV210
+static void __iomem *s5p_nand_base;
+
+static int s5p_nand_hw_init(void)
+{
+	s5p_nand_base = ioremap(S5P_NAND_BASE, sizeof(struct s5p_nand_regs));
+	if (!s5p_nand_base)
+		return -EINVAL;
+
+	return 0;
+}
+
+static void s5p_nand_hw_exit(void)
+{
+	iounmap(s5p_nand_base);
+}
+
+static u32 s5p_nand_hw_readl(unsigned int reg)
+{
+	return readl(s5p_nand_base + reg);
+}
+
+static void s5p_nand_hw_writel(u32 val, unsigned int reg)
+{
+	writel(val, s5p_nand_base + reg);
+}
+
+static u8 s5p_nand_hw_readb(void)
+{
+	return readb(s5p_nand_base + S5P_NAND_REG(nfdata));
+}
+
+static void s5p_nand_hw_writeb(u8 val)
+{
+	writeb(val, s5p_nand_base + S5P_NAND_REG(nfdata));
+}
+
+static void s5p_nand_hw_reads(void *buf, int words)
+{
+	readsl(s5p_nand_base + S5P_NAND_REG(nfdata), buf, words);
+}
+
+static void s5p_nand_hw_writes(const void *buf, int words)
+{
+	writesl(s5p_nand_base + S5P_NAND_REG(nfdata), buf, words);
+}
+
+static const struct s5p_nand_reg_ops s5p_nand_hw_ops = {
+	.name		= "hw",
+	.irq		= IRQ_NFC,
+	.init		= s5p_nand_hw_init,
+	.exit		= s5p_nand_hw_exit,
+	.reg_read	= s5p_nand_hw_readl,
+	.reg_write	= s5p_nand_hw_writel,
+	.data_readb	= s5p_nand_hw_readb,
+	.data_writeb	= s5p_nand_hw_writeb,
+	.data_reads	= s5p_nand_hw_reads,
+	.data_writes	= s5p_nand_hw_writes,
+};
+#endif
+
+static const struct s5p_nand_reg_ops *s5p_nand_reg_backends[] = {
+#ifdef CONFIG_ARCH_S5PV210
+	&s5p_nand_hw_ops,
+#endif
+#ifdef S5P_NAND_MODEL
+	&s5p_nand_model_ops,
+#endif
+};
+
+static int s5p_nand_io_init(void)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(s5p_nand_reg_backends); i++) {
+		if (!strcmp(regs, s5p_nand_reg_backends[i]->name))
+			s5p_nand_io = s5p_nand_reg_backends[i];
+	}
+
+	if (!s5p_nand_io) {
+		printk("s5p_nand: unknown register backend \"%s\"\n", regs);
+		return -EINVAL;
+	}
+
+	if (s5p_nand_io != s5p_nand_reg_backends[0])
+		printk("s5p_nand: using %s register backend\n", s5p_nand_io->name);
+
+	return s5p_nand_io->init();
+}
+
+static void s5p_nand_io_exit(void)
+{
+	s5p_nand_io->exit();
+}
+
+struct mtd_partition s5p_partition_info[] = {
+	{
+		.name		= "bootloader",
+		.offset		= (0*SZ_1K),          /* for bootloader */
+		.size		= (1*SZ_1M),
+		.mask_flags	= MTD_CAP_NANDFLASH,
+	},
+	{
+		.name		= "params",
+		.offset		= MTDPART_OFS_APPEND,
+		.size		= (128*SZ_1K),
+	},
+	{
+		.name		= "kernel",
+		.offset		= MTDPART_OFS_APPEND,
+		.size		= (5*SZ_1M),
+	},
+	{
+		.name		= "rootfs",
+		.offset		= MTDPART_OFS_APPEND,
+		.size		= (256*SZ_1M),
+	},
+	{
+		.name		= "system",
+		.offset		= MTDPART_OFS_APPEND,
+		.size		= MTDPART_SIZ_FULL,
+	}
+
+};
+
+/*
+ * 分区
+ * 优先使用内核命令行中的mtdparts=s5p-nand:...，没有按擦除块对齐的分区按擦除块向上取整
+ * 没有命令行时使用上面的静态分区表，bootloader按表里的偏移找kernel，不能挪动，
+ * 和实际擦除块(交错模式下加倍)对不齐时不注册
+ */
+#define S5P_NAND_MTD_ID		"s5p-nand"
+
+static const char *s5p_nand_part_probes[] = { "cmdlinepart", NULL };
+//命令行解析出来的分区表，分区名指向其中，卸载时才能释放
+static struct mtd_partition *s5p_nand_parts;
+//实际注册的分区表
+static struct mtd_partition *s5p_nand_part_table;
+static int s5p_nand_nr_parts;
+
+//返回没有对齐的分区个数，fix时向上取整
+static int s5p_nand_align_partitions(struct mtd_info *mtd,
+				     struct mtd_partition *parts, int nr, int fix)
+{
+	uint64_t mask = mtd->erasesize - 1;
+	int bad = 0;
+	int i;
+
+	for (i = 0; i < nr; i++) {
+		if (parts[i].offset != MTDPART_OFS_APPEND &&
+		    parts[i].offset != MTDPART_OFS_NXTBLK && (parts[i].offset & mask)) {
+			printk("s5p_nand: partition \"%s\" offset 0x%llx not aligned to %u KiB erase blocks\n",
+			       parts[i].name, (unsigned long long)parts[i].offset, mtd->erasesize >> 10);
+			if (fix)
+				parts[i].offset = ALIGN(parts[i].offset, (uint64_t)mtd->erasesize);
+			bad++;
+		}
+
+		if (parts[i].size != MTDPART_SIZ_FULL && (parts[i].size & mask)) {
+			printk("s5p_nand: partition \"%s\" size 0x%llx not aligned to %u KiB erase blocks\n",
+			       parts[i].name, (unsigned long long)parts[i].size, mtd->erasesize >> 10);
+			if (fix)
+				parts[i].size = ALIGN(parts[i].size, (uint64_t)mtd->erasesize);
+			bad++;
+		}
+	}
+
+	return bad;
+}
+
+static int s5p_nand_add_partitions(struct mtd_info *mtd)
+{
+	int nr;
+
+	nr = parse_mtd_partitions(mtd, s5p_nand_part_probes, &s5p_nand_parts, 0);
+	if (nr > 0) {
+		printk("s5p_nand: %d partitions from mtdparts=\n", nr);
+		if (s5p_nand_align_partitions(mtd, s5p_nand_parts, nr, 1))
+			printk("s5p_nand: mtdparts= rounded up to erase block boundaries\n");
+		s5p_nand_part_table = s5p_nand_parts;
+		s5p_nand_nr_parts = nr;
+
+		return mtd_device_register(mtd, s5p_nand_parts, nr);
+	}
+
+	//挪动静态分区会让bootloader找不到kernel，宁可不注册
+	if (s5p_nand_align_partitions(mtd, s5p_partition_info, ARRAY_SIZE(s5p_partition_info), 0)) {
+		printk("s5p_nand: static partition table does not fit %u KiB erase blocks, "
+		       "pass mtdparts= or load with interleave=0\n", mtd->erasesize >> 10);
+		return -EINVAL;
+	}
+	s5p_nand_part_table = s5p_partition_info;
+	s5p_nand_nr_parts = ARRAY_SIZE(s5p_partition_info);
+
+	return mtd_device_register(mtd, s5p_partition_info, ARRAY_SIZE(s5p_partition_info));
+}
+
+/*
+ * 编程(~200us)和擦除(~2ms)期间用R/nB上升沿中断+completion等待，线程可以睡眠
+ * 读页(tR ~25us)仍由nand_base轮询dev_ready
+ * 按操作类型记录平均忙时间，短于rnb_poll_us的直接轮询，省掉中断和调度的开销
+ */
+static int rnb_irq = 1;
+module_param(rnb_irq, int, 0444);
+MODULE_PARM_DESC(rnb_irq, "Sleep on the R/nB interrupt while programming/erasing");
+
+static int rnb_poll_us = 50;
+module_param(rnb_poll_us, int, 0644);
+MODULE_PARM_DESC(rnb_poll_us, "Busy periods shorter than this are polled");
+
+enum {
+	S5P_NAND_BUSY_PROG,
+	S5P_NAND_BUSY_CACHE,
+	S5P_NAND_BUSY_ERASE,
+	S5P_NAND_BUSY_NR,
+};
+
+static DECLARE_COMPLETION(s5p_nand_rnb_done);
+static int s5p_nand_rnb_armed;
+static unsigned int s5p_nand_busy_avg[S5P_NAND_BUSY_NR];
+
+static struct {
+	unsigned long sleeps;
+	unsigned long polls;
+	unsigned long timeouts;
+	unsigned long long sleep_us;
+} s5p_nand_rnb_stat;
+
+static irqreturn_t s5p_nand_rnb_interrupt(int irq, void *dev_id)
+{
+	if (!(s5p_nand_readl(nfstat) & S5P_NFSTAT_RNB_TRANS))
+		return IRQ_NONE;
+
+	s5p_nand_writel(S5P_NFSTAT_RNB_TRANS, nfstat);
+	complete(&s5p_nand_rnb_done);
+
+	return IRQ_HANDLED;
+}
+
+//在发编程/擦除确认命令之前清掉上次的边沿，避免漏掉或误用中断
+static void s5p_nand_rnb_arm(int command)
+{
+	s5p_nand_writel(S5P_NFSTAT_RNB_TRANS, nfstat);
+	INIT_COMPLETION(s5p_nand_rnb_done);
+	s5p_nand_rnb_armed = command;
+}
+
+static int s5p_nand_rnb_seen(void)
+{
+	return completion_done(&s5p_nand_rnb_done) ||
+		(s5p_nand_readl(nfstat) & S5P_NFSTAT_RNB_TRANS);
+}
+
+static int s5p_nand_waitfunc(struct mtd_info *mtd, struct nand_chip *chip)
+{
+	int type = (chip->state == FL_ERASING) ? S5P_NAND_BUSY_ERASE : S5P_NAND_BUSY_PROG;
+	unsigned long timeo = msecs_to_jiffies(type == S5P_NAND_BUSY_ERASE ? 400 : 20);
+	ktime_t start = ktime_get();
+	unsigned int avg;
+	unsigned int us;
+	int i;
+
+	//cache program只等数据搬进cache寄存器，忙时间和整页编程差别很大，单独统计
+	if (s5p_nand_rnb_armed == NAND_CMD_CACHEDPROG)
+		type = S5P_NAND_BUSY_CACHE;
+	avg = s5p_nand_busy_avg[type];
+
+	if (!s5p_nand_rnb_armed) {
+		//不是由编程/擦除命令进来的，按nand_wait的方式轮询
+		unsigned long end = jiffies + timeo;
+
+		ndelay(100);
+		while (time_before(jiffies, end) && !chip->dev_ready(mtd))
+			cond_resched();
+		goto status;
+	}
+	s5p_nand_rnb_armed = 0;
+
+	//平均忙时间较短时先轮询，超出预期再睡眠
+	if (avg < rnb_poll_us) {
+		for (i = 0; i < 2 * rnb_poll_us; i++) {
+			if (s5p_nand_rnb_seen()) {
+				s5p_nand_rnb_stat.polls++;
+				goto done;
+			}
+			udelay(1);
+		}
+	}
+
+	if (wait_for_completion_timeout(&s5p_nand_rnb_done, timeo)) {
+		s5p_nand_rnb_stat.sleeps++;
+		s5p_nand_rnb_stat.sleep_us += ktime_us_delta(ktime_get(), start);
+	} else if (!chip->dev_ready(mtd)) {
+		s5p_nand_rnb_stat.timeouts++;
+		printk("s5p_nand: R/nB timeout\n");
+	}
+
+done:
+	us = ktime_us_delta(ktime_get(), start);
+	s5p_nand_busy_avg[type] = avg ? (avg * 7 + us) / 8 : us;
+
+status:
+	chip->cmdfunc(mtd, NAND_CMD_STATUS, -1, -1);
+
+	return chip->read_byte(mtd);
+}
+
+static int s5p_nand_rnb_init(void)
+{
+	int err;
+
+	//寄存器模型没有中断
+	if (!s5p_nand_io->irq)
+		rnb_irq = 0;
+	if (!rnb_irq)
+		return 0;
+
+	s5p_nand_writel(S5P_NFSTAT_RNB_TRANS, nfstat);
+	err = request_irq(s5p_nand_io->irq, s5p_nand_rnb_interrupt, 0, "s5p-nand", NULL);
+	if (err) {
+		//申请不到中断就继续用nand_base的轮询
+		printk("s5p_nand: failed to request IRQ %d, polling R/nB\n", s5p_nand_io->irq);
+		rnb_irq = 0;
+		return 0;
+	}
+
+	s5p_nand_writel(s5p_nand_readl(nfcont) & ~S5P_NFCONT_RNB_MODE, nfcont);
+	s5p_nand_writel(s5p_nand_readl(nfcont) | S5P_NFCONT_RNB_INT, nfcont);
+	s5p_nand->waitfunc = s5p_nand_waitfunc;
+
+	return 0;
+}
+
+static void s5p_nand_rnb_exit(void)
+{
+	if (!rnb_irq)
+		return;
+
+	s5p_nand_writel(s5p_nand_readl(nfcont) & ~S5P_NFCONT_RNB_INT, nfcont);
+	free_irq(s5p_nand_io->irq, NULL);
+
+	printk("s5p_nand: R/nB %lu sleeps (%llu us), %lu polls, %lu timeouts\n",
+		s5p_nand_rnb_stat.sleeps, s5p_nand_rnb_stat.sleep_us,
+		s5p_nand_rnb_stat.polls, s5p_nand_rnb_stat.timeouts);
+}
+
+/*
+ * 片选
+ * nfcont中nCE0~nCE3分别为bit1、bit2、bit22、bit23
+ */
+#define S5P_NAND_MAX_CHIPS	4
+
+static const unsigned long s5p_nand_ce_bits[S5P_NAND_MAX_CHIPS] = {
+	1 << 1, 1 << 2, 1 << 22, 1 << 23,
+};
+
+#define S5P_NFCONT_CE_MASK	((1 << 1) | (1 << 2) | (1 << 22) | (1 << 23))
+
+static int nr_chips = 1;
+module_param(nr_chips, int, 0444);
+MODULE_PARM_DESC(nr_chips, "Number of chip selects to probe (1-4)");
+
+static int interleave = 1;
+module_param(interleave, int, 0444);
+MODULE_PARM_DESC(interleave, "Interleave two identical chips page by page");
+
+//当前选中的物理芯片
+static int s5p_nand_cur_chip;
+//交错的芯片数，1表示不交错
+static int s5p_nand_ways = 1;
+//交错模式下已经发出编程/擦除命令、还没有读取结果的芯片
+static unsigned long s5p_nand_busy_chips;
+
+static void s5p_nand_ce(int chipnr)
+{
+	u32 val = s5p_nand_readl(nfcont) | S5P_NFCONT_CE_MASK;
+
+	if (chipnr >= 0)
+		val &= ~s5p_nand_ce_bits[chipnr];
+
+	s5p_nand_writel(val, nfcont);
+}
+
+static void s5p_nand_cache_read_end(struct mtd_info *mtd);
+
+static void s5p_nand_select_chip(struct mtd_info *mtd, int chipnr)
+{
+	//交错模式下nand_base只看到一个芯片，物理片选由命令函数按页地址决定
+	if (chipnr >= 0 && s5p_nand_ways == 1) {
+		//换芯片前在原来的芯片上用3Fh结束cache read
+		if (chipnr != s5p_nand_cur_chip)
+			s5p_nand_cache_read_end(mtd);
+		s5p_nand_cur_chip = chipnr;
+	}
+
+	s5p_nand_ce(chipnr < 0 ? -1 : s5p_nand_cur_chip);
+}
+
+static void s5p_nand_hwcontrol(struct mtd_info *mtd, int dat, unsigned int ctrl)
+{
+	if (ctrl & NAND_CTRL_CHANGE) {
+		if (ctrl & NAND_NCE) {
+			if (dat != NAND_CMD_NONE) {
+				//select
+				s5p_nand_ce(s5p_nand_cur_chip);
+			}
+		} else {
+			//deselect
+			s5p_nand_ce(-1);
+		}
+	}
+
+	if (dat != NAND_CMD_NONE) {
+		if (ctrl & NAND_CLE) {
+			if (dat == NAND_CMD_PAGEPROG || dat == NAND_CMD_ERASE2 ||
+			    dat == NAND_CMD_CACHEDPROG) {
+				if (rnb_irq)
+					s5p_nand_rnb_arm(dat);
+				//只有交错模式会延后读取状态，不交错时nand_base马上就等结果
+				if (s5p_nand_ways > 1)
+					s5p_nand_busy_chips |= 1 << s5p_nand_cur_chip;
+			}
+			s5p_nand_writel(dat, nfcmmd);
+		}
+		else if (ctrl & NAND_ALE)
+			s5p_nand_writel(dat, nfaddr);
+	}
+}	
+
+
+static void (*s5p_nand_cmdfunc_orig)(struct mtd_info *mtd, unsigned command,
+				     int column, int page_addr);
+
+/*
+ * 两片相同的芯片交错访问
+ * 虚拟页v在芯片(v % 2)的第(v / 2)页，虚拟块由两个芯片上相同编号的块组成(擦除块大小加倍)
+ * 写: 发出编程命令后不等待，在另一片芯片编程期间传输下一页的数据，
+ *     只有访问一个还在忙的芯片、或者写操作的最后一页才等待
+ * 擦除: 两个芯片同时擦除
+ * 提前返回的页如果编程失败，由这次写操作的后续页返回-EIO
+ */
+static int s5p_nand_ilv_shift;
+static int s5p_nand_ilv_failed;
+
+static int s5p_nand_ilv_wait_chip(struct mtd_info *mtd, int chipnr)
+{
+	struct nand_chip *chip = mtd->priv;
+	unsigned long timeo = jiffies + msecs_to_jiffies(400);
+	int status;
+
+	s5p_nand_cur_chip = chipnr;
+	s5p_nand_ce(chipnr);
+	s5p_nand_cmdfunc_orig(mtd, NAND_CMD_STATUS, -1, -1);
+
+	for (;;) {
+		status = chip->read_byte(mtd);
+		if ((status & NAND_STATUS_READY) || time_after(jiffies, timeo))
+			break;
+		usleep_range(20, 50);
+	}
+
+	s5p_nand_busy_chips &= ~(1 << chipnr);
+	if (status & NAND_STATUS_FAIL)
+		s5p_nand_ilv_failed = 1;
+
+	return status;
+}
+
+//等所有忙的芯片结束，返回合并后的状态
+static int s5p_nand_ilv_wait_all(struct mtd_info *mtd)
+{
+	int status = NAND_STATUS_READY | NAND_STATUS_WP;
+	int cur = s5p_nand_cur_chip;
+	int i;
+
+	for (i = 0; i < s5p_nand_ways; i++) {
+		if (s5p_nand_busy_chips & (1 << i)) {
+			int st = s5p_nand_ilv_wait_chip(mtd, i);
+
+			status &= st | ~(NAND_STATUS_READY | NAND_STATUS_WP);
+			status |= st & NAND_STATUS_FAIL;
+		}
+	}
+
+	s5p_nand_cur_chip = cur;
+	s5p_nand_ce(cur);
+
+	if (s5p_nand_ilv_failed)
+		status |= NAND_STATUS_FAIL;
+	s5p_nand_ilv_failed = 0;
+
+	return status;
+}
+
+static int s5p_nand_ilv_waitfunc(struct mtd_info *mtd, struct nand_chip *chip)
+{
+	return s5p_nand_ilv_wait_all(mtd);
+}
+
+static void s5p_nand_ilv_cmdfunc(struct mtd_info *mtd, unsigned command,
+				 int column, int page_addr)
+{
+	int chipnr;
+	int i;
+
+	switch (command) {
+	case NAND_CMD_RESET:
+		//不能复位正在编程的芯片
+		s5p_nand_ilv_wait_all(mtd);
+		for (i = 0; i < s5p_nand_ways; i++) {
+			s5p_nand_cur_chip = i;
+			s5p_nand_ce(i);
+			s5p_nand_cmdfunc_orig(mtd, command, column, page_addr);
+		}
+		return;
+
+	case NAND_CMD_READID:
+		s5p_nand_cur_chip = 0;
+		s5p_nand_ce(0);
+		break;
+	}
+
+	if (page_addr != -1) {
+		chipnr = page_addr & (s5p_nand_ways - 1);
+		page_addr >>= s5p_nand_ilv_shift;
+
+		if (s5p_nand_busy_chips & (1 << chipnr))
+			s5p_nand_ilv_wait_chip(mtd, chipnr);
+
+		s5p_nand_cur_chip = chipnr;
+		s5p_nand_ce(chipnr);
+	}
+
+	s5p_nand_cmdfunc_orig(mtd, command, column, page_addr);
+}
+
+static void s5p_nand_ilv_erase_cmd(struct mtd_info *mtd, int page)
+{
+	struct nand_chip *chip = mtd->priv;
+	int i;
+
+	//page是虚拟块的第一页，page + i落在第i个芯片的同一个块上
+	for (i = 0; i < s5p_nand_ways; i++) {
+		chip->cmdfunc(mtd, NAND_CMD_ERASE1, -1, page + i);
+		chip->cmdfunc(mtd, NAND_CMD_ERASE2, -1, -1);
+	}
+}
+
+static int s5p_nand_write_subpage(struct mtd_info *mtd, struct nand_chip *chip,
+				  const uint8_t *buf);
+
+static int s5p_nand_ilv_write_page(struct mtd_info *mtd, struct nand_chip *chip,
+				   const uint8_t *buf, int page, int cached, int raw)
+{
+	int status;
+
+	chip->cmdfunc(mtd, NAND_CMD_SEQIN, 0x00, page);
+
+	if (unlikely(raw))
+		chip->ecc.write_page_raw(mtd, chip, buf);
+	else if (!s5p_nand_write_subpage(mtd, chip, buf))
+		chip->ecc.write_page(mtd, chip, buf);
+
+	chip->cmdfunc(mtd, NAND_CMD_PAGEPROG, -1, -1);
+
+	if (cached) {
+		if (!s5p_nand_ilv_failed)
+			return 0;
+		status = NAND_STATUS_FAIL;
+		s5p_nand_ilv_failed = 0;
+	} else {
+		status = s5p_nand_ilv_wait_all(mtd);
+	}
+
+	return (status & NAND_STATUS_FAIL) ? -EIO : 0;
+}
+
+//nand_scan_ident之后把前两片芯片合成一个芯片交给nand_base
+static void s5p_nand_ilv_setup(struct mtd_info *mtd)
+{
+	struct nand_chip *chip = mtd->priv;
+
+	if (!interleave || chip->numchips < 2)
+		return;
+
+	if (chip->numchips > 2)
+		printk("s5p_nand: %d chips found, interleaving the first two\n", chip->numchips);
+
+	s5p_nand_ways = 2;
+	s5p_nand_ilv_shift = 1;
+
+	chip->numchips = 1;
+	chip->chipsize <<= s5p_nand_ilv_shift;
+	chip->chip_shift += s5p_nand_ilv_shift;
+	chip->phys_erase_shift += s5p_nand_ilv_shift;
+	chip->bbt_erase_shift = chip->phys_erase_shift;
+	chip->pagemask = (chip->chipsize >> chip->page_shift) - 1;
+	mtd->erasesize <<= s5p_nand_ilv_shift;
+	mtd->size = chip->chipsize;
+
+	//两个芯片各自的第一页正好是虚拟块的第0、1页
+	chip->options |= NAND_BBT_SCAN2NDPAGE;
+
+	//R/nB可能是两片芯片线与，交错模式改为轮询每片芯片的状态
+	chip->erase_cmd = s5p_nand_ilv_erase_cmd;
+	chip->waitfunc = s5p_nand_ilv_waitfunc;
+
+	printk("s5p_nand: 2-way interleave, erase block %u KiB\n", mtd->erasesize >> 10);
+}
+
+/*
+ * flash健康统计，debugfs下的s5p_nand目录:
+ * health:  二进制，s5p_nand_health头 + 每个擦除块一个s5p_nand_blkstat(小端u32)
+ * summary: 文本汇总，纠错最多的块、出现不可纠错的块、擦除次数分布以及R/nB统计
+ */
+#define S5P_NAND_HEALTH_MAGIC	0x484e3553	/* "S5NH" */
+#define S5P_NAND_HEALTH_VERSION	1
+#define S5P_NAND_HEALTH_TOP	10
+
+struct s5p_nand_blkstat {
+	u32 erase;
+	u32 read;
+	u32 corrected;		//纠正的bit数
+	u32 failed;		//不可纠错的次数
+};
+
+struct s5p_nand_health {
+	u32 magic;
+	u16 version;
+	u16 entry_size;
+	u32 nr_blocks;
+	u32 block_size;
+	struct s5p_nand_blkstat blk[0];
+};
+
+static struct s5p_nand_health *s5p_nand_health;
+static struct debugfs_blob_wrapper s5p_nand_health_blob;
+static struct dentry *s5p_nand_debugfs;
+
+//最近一次READ0的页(芯片内)，read_subpage没有页参数
+static int s5p_nand_cur_page = -1;
+
+static int (*s5p_nand_read_page_orig)(struct mtd_info *mtd, struct nand_chip *chip,
+				      uint8_t *buf, int page);
+static int (*s5p_nand_read_subpage_orig)(struct mtd_info *mtd, struct nand_chip *chip,
+					 uint32_t offs, uint32_t len, uint8_t *buf);
+static void (*s5p_nand_erase_cmd_orig)(struct mtd_info *mtd, int page);
+
+//nand_base传下来的是芯片内的页号，加上芯片号得到全局块号，超出范围返回-1
+static int s5p_nand_block_of(struct mtd_info *mtd, int page)
+{
+	struct nand_chip *chip = mtd->priv;
+	unsigned int block;
+
+	if (page < 0)
+		return -1;
+
+	block = page >> (chip->phys_erase_shift - chip->page_shift);
+	if (s5p_nand_ways == 1)
+		block += s5p_nand_cur_chip << (chip->chip_shift - chip->phys_erase_shift);
+
+	if (block >= (mtd->size >> chip->phys_erase_shift))
+		return -1;
+
+	return block;
+}
+
+static struct s5p_nand_blkstat *s5p_nand_blkstat_of(struct mtd_info *mtd, int page)
+{
+	int block = s5p_nand_block_of(mtd, page);
+
+	if (!s5p_nand_health || block < 0)
+		return NULL;
+
+	return &s5p_nand_health->blk[block];
+}
+
+static void s5p_nand_account_read(struct mtd_info *mtd, int page,
+				  unsigned int corrected, unsigned int failed)
+{
+	struct s5p_nand_blkstat *st = s5p_nand_blkstat_of(mtd, page);
+
+	if (!st)
+		return;
+
+	st->read++;
+	st->corrected += corrected;
+	st->failed += failed;
+}
+
+static int s5p_nand_read_page_stat(struct mtd_info *mtd, struct nand_chip *chip,
+				   uint8_t *buf, int page)
+{
+	struct mtd_ecc_stats stats = mtd->ecc_stats;
+	int ret;
+
+	ret = s5p_nand_read_page_orig(mtd, chip, buf, page);
+	s5p_nand_account_read(mtd, page, mtd->ecc_stats.corrected - stats.corrected,
+			      mtd->ecc_stats.failed - stats.failed);
+
+	return ret;
+}
+
+static int s5p_nand_read_subpage_stat(struct mtd_info *mtd, struct nand_chip *chip,
+				      uint32_t offs, uint32_t len, uint8_t *buf)
+{
+	struct mtd_ecc_stats stats = mtd->ecc_stats;
+	int ret;
+
+	ret = s5p_nand_read_subpage_orig(mtd, chip, offs, len, buf);
+	s5p_nand_account_read(mtd, s5p_nand_cur_page,
+			      mtd->ecc_stats.corrected - stats.corrected,
+			      mtd->ecc_stats.failed - stats.failed);
+
+	return ret;
+}
+
+static void s5p_nand_erase_cmd_stat(struct mtd_info *mtd, int page)
+{
+	struct s5p_nand_blkstat *st = s5p_nand_blkstat_of(mtd, page);
+
+	if (st)
+		st->erase++;
+
+	s5p_nand_erase_cmd_orig(mtd, page);
+}
+
+static int s5p_nand_summary_show(struct seq_file *m, void *v)
+{
+	struct s5p_nand_health *h = s5p_nand_health;
+	unsigned int top[S5P_NAND_HEALTH_TOP];
+	unsigned long long reads = 0, erases = 0, corrected = 0, failed = 0;
+	unsigned int max_erase = 0, min_erase = ~0U;
+	int ntop = 0;
+	int i, j;
+
+	for (i = 0; i < h->nr_blocks; i++) {
+		struct s5p_nand_blkstat *st = &h->blk[i];
+
+		reads += st->read;
+		erases += st->erase;
+		corrected += st->corrected;
+		failed += st->failed;
+		max_erase = max(max_erase, st->erase);
+		min_erase = min(min_erase, st->erase);
+
+		if (!st->corrected)
+			continue;
+
+		//按纠错bit数插入排序，保留前S5P_NAND_HEALTH_TOP个
+		for (j = ntop; j > 0 && h->blk[top[j - 1]].corrected < st->corrected; j--) {
+			if (j < S5P_NAND_HEALTH_TOP)
+				top[j] = top[j - 1];
+		}
+		if (j < S5P_NAND_HEALTH_TOP) {
+			top[j] = i;
+			if (ntop < S5P_NAND_HEALTH_TOP)
+				ntop++;
+		}
+	}
+
+	seq_printf(m, "blocks:          %u x %u KiB\n", h->nr_blocks, h->block_size >> 10);
+	seq_printf(m, "reads:           %llu\n", reads);
+	seq_printf(m, "erases:          %llu (min %u, max %u, avg %llu)\n", erases,
+		   h->nr_blocks ? min_erase : 0, max_erase,
+		   h->nr_blocks ? div_u64(erases, h->nr_blocks) : 0);
+	seq_printf(m, "bitflips:        %llu corrected, %llu uncorrectable\n", corrected, failed);
+
+	seq_printf(m, "\nmost corrected blocks:\n");
+	for (i = 0; i < ntop; i++) {
+		struct s5p_nand_blkstat *st = &h->blk[top[i]];
+
+		seq_printf(m, "  block %5u: %u bitflips / %u reads, %u erases\n",
+			   top[i], st->corrected, st->read, st->erase);
+	}
+
+	seq_printf(m, "\nuncorrectable blocks:\n");
+	for (i = 0; i < h->nr_blocks; i++) {
+		if (h->blk[i].failed)
+			seq_printf(m, "  block %5u: %u times\n", i, h->blk[i].failed);
+	}
+
+	seq_printf(m, "\nr/nb:            %lu sleeps (%llu us), %lu polls, %lu timeouts\n",
+		   s5p_nand_rnb_stat.sleeps, s5p_nand_rnb_stat.sleep_us,
+		   s5p_nand_rnb_stat.polls, s5p_nand_rnb_stat.timeouts);
+
+	return 0;
+}
+
+static int s5p_nand_summary_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, s5p_nand_summary_show, NULL);
+}
+
+static const struct file_operations s5p_nand_summary_fops = {
+	.owner		= THIS_MODULE,
+	.open		= s5p_nand_summary_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+//统计只是辅助功能，失败了也不影响驱动加载
+static void s5p_nand_health_init(struct mtd_info *mtd)
+{
+	struct nand_chip *chip = mtd->priv;
+	unsigned int nr_blocks = mtd->size >> chip->phys_erase_shift;
+	unsigned long size = sizeof(*s5p_nand_health) + nr_blocks * sizeof(struct s5p_nand_blkstat);
+
+	s5p_nand_health = vzalloc(size);
+	if (!s5p_nand_health)
+		return;
+
+	s5p_nand_health->magic = S5P_NAND_HEALTH_MAGIC;
+	s5p_nand_health->version = S5P_NAND_HEALTH_VERSION;
+	s5p_nand_health->entry_size = sizeof(struct s5p_nand_blkstat);
+	s5p_nand_health->nr_blocks = nr_blocks;
+	s5p_nand_health->block_size = mtd->erasesize;
+
+	s5p_nand_read_page_orig = chip->ecc.read_page;
+	s5p_nand_read_subpage_orig = chip->ecc.read_subpage;
+	s5p_nand_erase_cmd_orig = chip->erase_cmd;
+	chip->ecc.read_page = s5p_nand_read_page_stat;
+	if (chip->ecc.read_subpage)
+		chip->ecc.read_subpage = s5p_nand_read_subpage_stat;
+	chip->erase_cmd = s5p_nand_erase_cmd_stat;
+
+	s5p_nand_debugfs = debugfs_create_dir("s5p_nand", NULL);
+	if (IS_ERR_OR_NULL(s5p_nand_debugfs)) {
+		s5p_nand_debugfs = NULL;
+		return;
+	}
+
+	s5p_nand_health_blob.data = s5p_nand_health;
+	s5p_nand_health_blob.size = size;
+	debugfs_create_blob("health", S_IRUSR, s5p_nand_debugfs, &s5p_nand_health_blob);
+	debugfs_create_file("summary", S_IRUSR, s5p_nand_debugfs, NULL, &s5p_nand_summary_fops);
+#ifdef S5P_NAND_MODEL
+	if (s5p_nand_io == &s5p_nand_model_ops)
+		s5p_nand_model_debugfs(s5p_nand_debugfs);
+#endif
+}
+
+static void s5p_nand_health_exit(void)
+{
+	debugfs_remove_recursive(s5p_nand_debugfs);
+	s5p_nand_debugfs = NULL;
+	vfree(s5p_nand_health);
+	s5p_nand_health = NULL;
+}
+
+/*
+ * BCH ECC
+ * MLC芯片软件汉明码(每256字节纠1bit)不够用，改用s5p_nand_bch.c里查表实现的BCH，
+ * 每512字节纠bch_t个bit，通过NAND_ECC_HW的calculate/correct接口接入nand_base
+ * ECC字节放在OOB末尾，前16个字节留给坏块标记和坏块表的pattern/版本号，
+ * OOB放不下时自动减小t，连最小的t都放不下就还用汉明码
+ */
+static int ecc_bch = -1;
+module_param(ecc_bch, int, 0444);
+MODULE_PARM_DESC(ecc_bch, "Use BCH ECC: -1 = MLC only, 0 = never, 1 = always");
+
+static int bch_t = 8;
+module_param(bch_t, int, 0444);
+MODULE_PARM_DESC(bch_t, "BCH correctable bits per 512 bytes (4-8, lowered to fit the OOB)");
+
+#define S5P_NAND_BCH_OOB_RESERVED	16
+
+static struct s5p_bch *s5p_nand_bch;
+static struct nand_ecclayout s5p_nand_bch_layout;
+
+static void s5p_nand_bch_hwctl(struct mtd_info *mtd, int mode)
+{
+}
+
+static int s5p_nand_bch_calculate(struct mtd_info *mtd, const uint8_t *dat, uint8_t *ecc_code)
+{
+	s5p_bch_encode(s5p_nand_bch, dat, ecc_code);
+
+	return 0;
+}
+
+static int s5p_nand_bch_correct(struct mtd_info *mtd, uint8_t *dat,
+				uint8_t *read_ecc, uint8_t *calc_ecc)
+{
+	int ret;
+
+	ret = s5p_bch_correct(s5p_nand_bch, dat, read_ecc, calc_ecc);
+	if (ret < 0)
+		return -EBADMSG;
+
+	return ret;
+}
+
+//nand_scan_ident之后、nand_scan_tail之前调用
+static int s5p_nand_bch_setup(struct mtd_info *mtd)
+{
+	struct nand_chip *chip = mtd->priv;
+	int mlc = (nand_type == S5P_NAND_TYPE_MLC) || (chip->cellinfo & NAND_CI_CELLTYPE_MSK);
+	int steps = mtd->writesize / S5P_BCH_DATA_BYTES;
+	int avail = min_t(int, mtd->oobsize - S5P_NAND_BCH_OOB_RESERVED,
+			  ARRAY_SIZE(s5p_nand_bch_layout.eccpos));
+	int t, bytes, total;
+	int i;
+
+	if (!ecc_bch || (ecc_bch < 0 && !mlc) || !steps)
+		return 0;
+
+	for (t = clamp(bch_t, S5P_BCH_MIN_T, S5P_BCH_MAX_T); t >= S5P_BCH_MIN_T; t--) {
+		bytes = DIV_ROUND_UP(S5P_BCH_M * t, 8);
+		if (steps * bytes <= avail)
+			break;
+	}
+	if (t < S5P_BCH_MIN_T) {
+		printk("s5p_nand: oob %u too small for BCH, using Hamming ECC\n", mtd->oobsize);
+		return 0;
+	}
+
+	s5p_nand_bch = vmalloc(sizeof(*s5p_nand_bch));
+	if (!s5p_nand_bch)
+		return -ENOMEM;
+	s5p_bch_init(s5p_nand_bch, t);
+
+	total = steps * bytes;
+	s5p_nand_bch_layout.eccbytes = total;
+	for (i = 0; i < total; i++)
+		s5p_nand_bch_layout.eccpos[i] = mtd->oobsize - total + i;
+	s5p_nand_bch_layout.oobfree[0].offset = 2;
+	s5p_nand_bch_layout.oobfree[0].length = mtd->oobsize - total - 2;
+
+	chip->ecc.mode = NAND_ECC_HW;
+	chip->ecc.size = S5P_BCH_DATA_BYTES;
+	chip->ecc.bytes = bytes;
+	chip->ecc.layout = &s5p_nand_bch_layout;
+	chip->ecc.hwctl = s5p_nand_bch_hwctl;
+	chip->ecc.calculate = s5p_nand_bch_calculate;
+	chip->ecc.correct = s5p_nand_bch_correct;
+
+	printk("s5p_nand: BCH ECC, %d bits per %d bytes, %d ecc bytes\n",
+	       t, S5P_BCH_DATA_BYTES, total);
+
+	return 0;
+}
+
+static void s5p_nand_bch_exit(void)
+{
+	vfree(s5p_nand_bch);
+	s5p_nand_bch = NULL;
+}
+
+/*
+ * 子页写
+ * 软件ECC每256字节一个步，2K页8步，nand_base按每个512字节子页可以单独编程来设置subpagesize，
+ * UBI的EC/VID头和UBIFS的小节点只写一个子页
+ * 条件: SLC，并且芯片允许的部分编程次数(NOP)不少于每页的子页数，否则关闭子页写
+ * ECC字节按步顺序连续放在OOB的40~63，每个子页的ECC是其中连续的6个字节，
+ * 写一个子页时只编程它自己的数据和ECC，不碰其他子页的ECC
+ *
+ * nand_do_write_ops把子页以外的部分填成0xff后整页交给write_page，
+ * 芯片手册: The bytes other than those to be programmed do not need to be loaded.
+ * 所以只用85h把非0xff的子页和对应的ECC字节送进数据寄存器，其余不传输
+ */
+static struct nand_ecclayout s5p_nand_oob_64 = {
+	.eccbytes	= 24,
+	.eccpos		= {
+		40, 41, 42, 43, 44, 45, 46, 47,
+		48, 49, 50, 51, 52, 53, 54, 55,
+		56, 57, 58, 59, 60, 61, 62, 63 },
+	.oobfree	= { { .offset = 2, .length = 38 } },
+};
+
+//芯片每页允许的编程次数，0表示不知道
+static int s5p_nand_nop;
+//ECC字节连续，可以只传输部分子页
+static int s5p_nand_subpage_xfer;
+
+static int s5p_nand_is_ff(const uint8_t *buf, int len)
+{
+	const u32 *p = (const u32 *)buf;
+	int i;
+
+	for (i = 0; i < len / 4; i++)
+		if (p[i] != 0xffffffff)
+			return 0;
+
+	return 1;
+}
+
+//SEQIN之后调用，只传输了部分子页返回1，否则返回0由调用者整页传输
+static int s5p_nand_write_subpage(struct mtd_info *mtd, struct nand_chip *chip,
+				  const uint8_t *buf)
+{
+	int sub = chip->subpagesize;
+	int nsub = mtd->writesize / sub;
+	int eccsize = chip->ecc.size;
+	int eccbytes = chip->ecc.bytes;
+	uint8_t *ecc_calc = chip->buffers->ecccalc;
+	int first, end, step, nsteps;
+	int i;
+
+	if (!s5p_nand_subpage_xfer || !mtd->subpage_sft)
+		return 0;
+
+	//OOB里有用户数据(比如yaffs的标签)时按整页写
+	if (!s5p_nand_is_ff(chip->oob_poi, mtd->oobsize))
+		return 0;
+
+	for (first = 0; first < nsub; first++)
+		if (!s5p_nand_is_ff(buf + first * sub, sub))
+			break;
+	if (first == nsub)
+		return 0;
+
+	for (end = nsub; end > first; end--)
+		if (!s5p_nand_is_ff(buf + (end - 1) * sub, sub))
+			break;
+	if (first == 0 && end == nsub)
+		return 0;
+
+	step = first * sub / eccsize;
+	nsteps = (end - first) * sub / eccsize;
+	for (i = 0; i < nsteps; i++)
+		chip->ecc.calculate(mtd, buf + (step + i) * eccsize, ecc_calc + i * eccbytes);
+
+	chip->cmdfunc(mtd, NAND_CMD_RNDIN, first * sub, -1);
+	chip->write_buf(mtd, buf + first * sub, (end - first) * sub);
+	chip->cmdfunc(mtd, NAND_CMD_RNDIN, mtd->writesize + chip->ecc.layout->eccpos[step * eccbytes], -1);
+	chip->write_buf(mtd, ecc_calc, nsteps * eccbytes);
+
+	return 1;
+}
+
+//nand_scan_tail之前调用，nand_scan_tail根据ECC步数和NAND_NO_SUBPAGE_WRITE计算subpagesize
+static void s5p_nand_subpage_setup(struct mtd_info *mtd)
+{
+	struct nand_chip *chip = mtd->priv;
+
+	if (mtd->oobsize == 64 && chip->ecc.mode == NAND_ECC_SOFT) {
+		chip->ecc.layout = &s5p_nand_oob_64;
+		s5p_nand_subpage_xfer = (mtd->writesize >= 2048);
+	}
+
+	//BCH的ECC字节也是按步连续放的
+	if (s5p_nand_bch)
+		s5p_nand_subpage_xfer = (mtd->writesize >= 2048);
+
+	if (nand_type == S5P_NAND_TYPE_MLC || (chip->cellinfo & NAND_CI_CELLTYPE_MSK)) {
+		chip->options |= NAND_NO_SUBPAGE_WRITE;
+		printk("s5p_nand: MLC, subpage writes disabled\n");
+	} else if (s5p_nand_nop && s5p_nand_nop < mtd->writesize / 512) {
+		chip->options |= NAND_NO_SUBPAGE_WRITE;
+		printk("s5p_nand: NOP %d, subpage writes disabled\n", s5p_nand_nop);
+	}
+}
+
+/*
+ * 在nand_base之外独占芯片(调频改NFCONF、scrub擦除写回)，不能插在一次操作中间
+ * nand_get_device是static的，这里照它的做法在controller->wq上等chip->state回到FL_READY，
+ * 芯片被nand_suspend挂起(FL_PM_SUSPENDED)时一直等到resume
+ */
+static void s5p_nand_get_device(struct mtd_info *mtd)
+{
+	struct nand_chip *chip = mtd->priv;
+	spinlock_t *lock = &chip->controller->lock;
+	wait_queue_head_t *wq = &chip->controller->wq;
+	DECLARE_WAITQUEUE(wait, current);
+
+	for (;;) {
+		spin_lock(lock);
+		if (!chip->controller->active)
+			chip->controller->active = chip;
+		if (chip->controller->active == chip && chip->state == FL_READY) {
+			chip->state = FL_SYNCING;
+			spin_unlock(lock);
+			return;
+		}
+		set_current_state(TASK_UNINTERRUPTIBLE);
+		add_wait_queue(wq, &wait);
+		spin_unlock(lock);
+		schedule();
+		remove_wait_queue(wq, &wait);
+	}
+}
+
+static void s5p_nand_release_device(struct mtd_info *mtd)
+{
+	struct nand_chip *chip = mtd->priv;
+
+	spin_lock(&chip->controller->lock);
+	chip->controller->active = NULL;
+	chip->state = FL_READY;
+	wake_up(&chip->controller->wq);
+	spin_unlock(&chip->controller->lock);
+}
+
+/*
+ * 读干扰刷新(scrub)
+ * kernel、rootfs这样只读不写的分区，反复读会让同一块里其他页的bit慢慢翻转(read disturb)，
+ * 最后超过ECC能力，变成不可纠错
+ * 每块记录上次擦除以来的读次数和单页最多纠正的bit数，超过scrub_flips(或读次数超过scrub_reads)
+ * 的块交给低优先级的内核线程，线程等flash空闲scrub_idle_ms之后把整块读出、擦除、原样写回
+ * 读出阶段期间有其他I/O就放弃，下次空闲再来；擦除和写回期间用s5p_nand_get_device独占芯片，
+ * 读出之后这个块被别人写过或擦过也放弃
+ * UBI的块不处理，UBI读到纠错的数据时自己会搬移(scrub)；有不可纠错页的块也不处理，免得把错误数据写成"正确"的
+ * 只处理scrub_parts列出的分区，默认不刷新: 擦除到写回完成之间掉电会丢掉这一块，
+ * 只能对掉电后可以重新烧写的分区打开
+ * 系统休眠前通过PM通知等当前的块做完，休眠期间不再开始新的块
+ */
+static char *scrub_parts = "";
+module_param(scrub_parts, charp, 0444);
+MODULE_PARM_DESC(scrub_parts, "Comma separated partitions to scrub (e.g. kernel,rootfs), empty to disable");
+
+static int scrub_flips;
+module_param(scrub_flips, int, 0644);
+MODULE_PARM_DESC(scrub_flips, "Refresh a block once a page read needs this many corrections (0 = auto)");
+
+static uint scrub_reads;
+module_param(scrub_reads, uint, 0644);
+MODULE_PARM_DESC(scrub_reads, "Also refresh blocks read this many times since the last erase (0 = off)");
+
+static int scrub_idle_ms = 1000;
+module_param(scrub_idle_ms, int, 0644);
+MODULE_PARM_DESC(scrub_idle_ms, "Flash idle time before scrubbing a block");
+
+#define S5P_NAND_SCRUB_ON	(1 << 0)	//在scrub_parts里
+#define S5P_NAND_SCRUB_PENDING	(1 << 1)
+#define S5P_NAND_SCRUB_SKIP	(1 << 2)	//UBI或者有不可纠错的页，擦除后清除
+
+#define UBI_EC_HDR_MAGIC	0x55424923	/* "UBI#" */
+
+struct s5p_nand_scrub_blk {
+	u32 reads;		//上次擦除后的读页次数
+	u8 flips;		//上次擦除后单页最多纠正的bit数
+	u8 flags;
+};
+
+static struct s5p_nand_scrub_blk *s5p_nand_scrub;
+static unsigned int s5p_nand_scrub_nr;
+static DEFINE_SPINLOCK(s5p_nand_scrub_lock);
+static DECLARE_WAIT_QUEUE_HEAD(s5p_nand_scrub_wait);
+static struct task_struct *s5p_nand_scrub_task;
+static int s5p_nand_scrub_nr_pending;
+static int s5p_nand_scrub_thresh;
+//线程以外最后一次访问flash的时间
+static unsigned long s5p_nand_scrub_last_io;
+//正在读出的块，读出以后它被别人写过或擦过就置s5p_nand_scrub_raced
+static int s5p_nand_scrub_cur = -1;
+static int s5p_nand_scrub_raced;
+static u8 *s5p_nand_scrub_buf;
+//线程处理一个块期间持有，PM通知拿到它就说明没有进行中的块
+static DEFINE_MUTEX(s5p_nand_scrub_pm_lock);
+static int s5p_nand_scrub_pm;
+static struct dentry *s5p_nand_scrub_debugfs;
+
+static struct {
+	unsigned long refreshed;
+	unsigned long aborted;
+	unsigned long skipped;
+	unsigned long failed;
+} s5p_nand_scrub_stat;
+
+static int (*s5p_nand_scrub_read_page_orig)(struct mtd_info *mtd, struct nand_chip *chip,
+					    uint8_t *buf, int page);
+static int (*s5p_nand_scrub_read_subpage_orig)(struct mtd_info *mtd, struct nand_chip *chip,
+					       uint32_t offs, uint32_t len, uint8_t *buf);
+
+static void s5p_nand_scrub_note(struct mtd_info *mtd, int page,
+				unsigned int corrected, unsigned int failed)
+{
+	int block = s5p_nand_block_of(mtd, page);
+	struct s5p_nand_scrub_blk *b;
+
+	//线程自己的读不算，读完马上就擦除了
+	if (!s5p_nand_scrub || block < 0 || current == s5p_nand_scrub_task)
+		return;
+
+	b = &s5p_nand_scrub[block];
+
+	spin_lock(&s5p_nand_scrub_lock);
+
+	b->reads++;
+	if (corrected > b->flips)
+		b->flips = min(corrected, 255U);
+	if (failed)
+		b->flags |= S5P_NAND_SCRUB_SKIP;
+
+	if ((b->flags & (S5P_NAND_SCRUB_ON | S5P_NAND_SCRUB_PENDING | S5P_NAND_SCRUB_SKIP)) == S5P_NAND_SCRUB_ON &&
+	    (b->flips >= s5p_nand_scrub_thresh || (scrub_reads && b->reads >= scrub_reads))) {
+		b->flags |= S5P_NAND_SCRUB_PENDING;
+		s5p_nand_scrub_nr_pending++;
+		wake_up(&s5p_nand_scrub_wait);
+	}
+
+	spin_unlock(&s5p_nand_scrub_lock);
+}
+
+static int s5p_nand_scrub_read_page(struct mtd_info *mtd, struct nand_chip *chip,
+				    uint8_t *buf, int page)
+{
+	struct mtd_ecc_stats stats = mtd->ecc_stats;
+	int ret;
+
+	ret = s5p_nand_scrub_read_page_orig(mtd, chip, buf, page);
+	s5p_nand_scrub_note(mtd, page, mtd->ecc_stats.corrected - stats.corrected,
+			    mtd->ecc_stats.failed - stats.failed);
+
+	return ret;
+}
+
+static int s5p_nand_scrub_read_subpage(struct mtd_info *mtd, struct nand_chip *chip,
+				       uint32_t offs, uint32_t len, uint8_t *buf)
+{
+	struct mtd_ecc_stats stats = mtd->ecc_stats;
+	int ret;
+
+	ret = s5p_nand_scrub_read_subpage_orig(mtd, chip, offs, len, buf);
+	s5p_nand_scrub_note(mtd, s5p_nand_cur_page,
+			    mtd->ecc_stats.corrected - stats.corrected,
+			    mtd->ecc_stats.failed - stats.failed);
+
+	return ret;
+}
+
+//cmdfunc里调用: 记录空闲时间，擦除清零计数，发现正在读出的块被修改
+static void s5p_nand_scrub_cmd(struct mtd_info *mtd, unsigned command, int page_addr)
+{
+	struct s5p_nand_scrub_blk *b;
+	int block;
+
+	if (!s5p_nand_scrub)
+		return;
+
+	if (current != s5p_nand_scrub_task)
+		s5p_nand_scrub_last_io = jiffies;
+
+	if (command != NAND_CMD_SEQIN && command != NAND_CMD_ERASE1)
+		return;
+
+	block = s5p_nand_block_of(mtd, page_addr);
+	if (block < 0)
+		return;
+
+	if (block == s5p_nand_scrub_cur && current != s5p_nand_scrub_task)
+		s5p_nand_scrub_raced = 1;
+
+	if (command == NAND_CMD_ERASE1) {
+		b = &s5p_nand_scrub[block];
+
+		spin_lock(&s5p_nand_scrub_lock);
+		if (b->flags & S5P_NAND_SCRUB_PENDING)
+			s5p_nand_scrub_nr_pending--;
+		b->flags &= ~(S5P_NAND_SCRUB_PENDING | S5P_NAND_SCRUB_SKIP);
+		b->reads = 0;
+		b->flips = 0;
+		spin_unlock(&s5p_nand_scrub_lock);
+	}
+}
+
+static void s5p_nand_scrub_set_flags(int block, u8 flags)
+{
+	struct s5p_nand_scrub_blk *b = &s5p_nand_scrub[block];
+
+	spin_lock(&s5p_nand_scrub_lock);
+	if ((flags & S5P_NAND_SCRUB_PENDING) && !(b->flags & S5P_NAND_SCRUB_PENDING))
+		s5p_nand_scrub_nr_pending++;
+	b->flags |= flags;
+	spin_unlock(&s5p_nand_scrub_lock);
+}
+
+//取出读得最多的待刷新块
+static int s5p_nand_scrub_pick(void)
+{
+	struct s5p_nand_scrub_blk *b;
+	int block = -1;
+	int i;
+
+	spin_lock(&s5p_nand_scrub_lock);
+
+	for (i = 0; i < s5p_nand_scrub_nr; i++) {
+		b = &s5p_nand_scrub[i];
+		if (!(b->flags & S5P_NAND_SCRUB_PENDING))
+			continue;
+		if (b->flags & S5P_NAND_SCRUB_SKIP) {
+			b->flags &= ~S5P_NAND_SCRUB_PENDING;
+			s5p_nand_scrub_nr_pending--;
+			continue;
+		}
+		if (block < 0 || b->reads > s5p_nand_scrub[block].reads)
+			block = i;
+	}
+
+	if (block >= 0) {
+		s5p_nand_scrub[block].flags &= ~S5P_NAND_SCRUB_PENDING;
+		s5p_nand_scrub_nr_pending--;
+	} else {
+		s5p_nand_scrub_nr_pending = 0;
+	}
+
+	spin_unlock(&s5p_nand_scrub_lock);
+
+	return block;
+}
+
+//独占芯片后擦除并写回，失败返回-EIO(数据已经丢了)
+static int s5p_nand_scrub_rewrite(struct mtd_info *mtd, loff_t ofs, u8 *buf)
+{
+	struct nand_chip *chip = mtd->priv;
+	int ppb = mtd->erasesize / mtd->writesize;
+	int page = (int)(ofs >> chip->page_shift) & chip->pagemask;
+	u8 *oob = buf + mtd->erasesize;
+	nand_state_t state = chip->state;
+	int status;
+	int ret = 0;
+	int i;
+
+	chip->select_chip(mtd, (int)(ofs >> chip->chip_shift));
+	chip->pagebuf = -1;
+
+	//芯片由s5p_nand_get_device占着(FL_SYNCING)，waitfunc按chip->state区分擦除和编程的超时、忙时间统计
+	chip->state = FL_ERASING;
+	chip->erase_cmd(mtd, page);
+	status = chip->waitfunc(mtd, chip);
+	if (status & NAND_STATUS_FAIL) {
+		ret = -EIO;
+		goto out;
+	}
+
+	chip->state = FL_WRITING;
+	for (i = 0; i < ppb; i++) {
+		u8 *data = buf + i * mtd->writesize;
+
+		//空页不能写，写了ECC就不是0xff了，以后没法再编程
+		if (s5p_nand_is_ff(data, mtd->writesize) &&
+		    s5p_nand_is_ff(oob + i * mtd->oobsize, mtd->oobsize))
+			continue;
+
+		memcpy(chip->oob_poi, oob + i * mtd->oobsize, mtd->oobsize);
+		ret = chip->write_page(mtd, chip, data, page + i, 0, 0);
+		if (ret)
+			break;
+	}
+
+out:
+	chip->select_chip(mtd, -1);
+	chip->state = state;
+
+	return ret;
+}
+
+static int s5p_nand_scrub_block(struct mtd_info *mtd, int block)
+{
+	int ppb = mtd->erasesize / mtd->writesize;
+	loff_t ofs = (loff_t)block * mtd->erasesize;
+	unsigned long last_io = s5p_nand_scrub_last_io;
+	u8 *buf = s5p_nand_scrub_buf;
+	struct mtd_oob_ops ops;
+	int ret;
+	int i;
+
+	if (mtd->block_isbad(mtd, ofs))
+		return -EPERM;
+
+	s5p_nand_scrub_raced = 0;
+	s5p_nand_scrub_cur = block;
+
+	//数据和整个OOB(文件系统可能在OOB里放了标签)都要原样写回
+	for (i = 0; i < ppb; i++) {
+		memset(&ops, 0, sizeof(ops));
+		ops.mode = MTD_OOB_PLACE;
+		ops.len = mtd->writesize;
+		ops.ooblen = mtd->oobsize;
+		ops.datbuf = buf + i * mtd->writesize;
+		ops.oobbuf = buf + mtd->erasesize + i * mtd->oobsize;
+
+		ret = mtd->read_oob(mtd, ofs + i * mtd->writesize, &ops);
+		if (ret == -EUCLEAN)
+			ret = 0;
+		if (ret) {
+			s5p_nand_scrub_set_flags(block, S5P_NAND_SCRUB_SKIP);
+			goto out;
+		}
+
+		if (i == 0 && be32_to_cpup((__be32 *)buf) == UBI_EC_HDR_MAGIC) {
+			s5p_nand_scrub_set_flags(block, S5P_NAND_SCRUB_SKIP);
+			ret = -EPERM;
+			goto out;
+		}
+
+		if (s5p_nand_scrub_last_io != last_io || s5p_nand_scrub_raced) {
+			ret = -EAGAIN;
+			goto out;
+		}
+	}
+
+	//其他访问都在nand_get_device里等待，休眠挂起的芯片要等resume之后才拿得到
+	s5p_nand_get_device(mtd);
+	if (s5p_nand_scrub_raced) {
+		s5p_nand_release_device(mtd);
+		ret = -EAGAIN;
+		goto out;
+	}
+
+	ret = s5p_nand_scrub_rewrite(mtd, ofs, buf);
+	s5p_nand_release_device(mtd);
+
+	if (ret) {
+		printk("s5p_nand: scrub failed to rewrite block %d, data lost, marking bad\n", block);
+		mtd->block_markbad(mtd, ofs);
+	}
+
+out:
+	s5p_nand_scrub_cur = -1;
+
+	return ret;
+}
+
+static int s5p_nand_scrub_thread(void *data)
+{
+	struct mtd_info *mtd = data;
+	long idle;
+	int block;
+	int ret;
+
+	set_user_nice(current, 19);
+	set_freezable();
+
+	while (!kthread_should_stop()) {
+		wait_event_freezable(s5p_nand_scrub_wait,
+				     (s5p_nand_scrub_nr_pending && !s5p_nand_scrub_pm) ||
+				     kthread_should_stop());
+		if (kthread_should_stop())
+			break;
+
+		//flash空闲了scrub_idle_ms才开始
+		idle = (long)(s5p_nand_scrub_last_io + msecs_to_jiffies(scrub_idle_ms) - jiffies);
+		if (idle > 0) {
+			schedule_timeout_interruptible(idle);
+			try_to_freeze();
+			continue;
+		}
+
+		//PM通知先于冻结进程，挂起的过程中不开始新的块
+		mutex_lock(&s5p_nand_scrub_pm_lock);
+		if (s5p_nand_scrub_pm) {
+			mutex_unlock(&s5p_nand_scrub_pm_lock);
+			continue;
+		}
+
+		block = s5p_nand_scrub_pick();
+		if (block < 0) {
+			mutex_unlock(&s5p_nand_scrub_pm_lock);
+			continue;
+		}
+
+		ret = s5p_nand_scrub_block(mtd, block);
+		mutex_unlock(&s5p_nand_scrub_pm_lock);
+
+		if (!ret) {
+			s5p_nand_scrub_stat.refreshed++;
+		} else if (ret == -EAGAIN) {
+			s5p_nand_scrub_stat.aborted++;
+			//被其他I/O打断的下次空闲再来，块被修改过的等以后的读重新发现
+			if (!s5p_nand_scrub_raced)
+				s5p_nand_scrub_set_flags(block, S5P_NAND_SCRUB_PENDING);
+		} else if (ret == -EIO) {
+			s5p_nand_scrub_stat.failed++;
+		} else {
+			s5p_nand_scrub_stat.skipped++;
+		}
+	}
+
+	return 0;
+}
+
+static int s5p_nand_scrub_pm_notify(struct notifier_block *nb,
+				    unsigned long val, void *data)
+{
+	switch (val) {
+	case PM_HIBERNATION_PREPARE:
+	case PM_SUSPEND_PREPARE:
+		//等进行中的块擦除写回完，之后nand_suspend才不会和scrub抢芯片
+		mutex_lock(&s5p_nand_scrub_pm_lock);
+		s5p_nand_scrub_pm = 1;
+		mutex_unlock(&s5p_nand_scrub_pm_lock);
+		break;
+
+	case PM_POST_HIBERNATION:
+	case PM_POST_SUSPEND:
+		s5p_nand_scrub_pm = 0;
+		wake_up(&s5p_nand_scrub_wait);
+		break;
+	}
+
+	return NOTIFY_DONE;
+}
+
+static struct notifier_block s5p_nand_scrub_pm_nb = {
+	.notifier_call = s5p_nand_scrub_pm_notify,
+};
+
+static int s5p_nand_scrub_show(struct seq_file *m, void *v)
+{
+	struct s5p_nand_scrub_blk *b;
+	int i;
+
+	seq_printf(m, "threshold:       %d bitflips / page", s5p_nand_scrub_thresh);
+	if (scrub_reads)
+		seq_printf(m, ", %u reads", scrub_reads);
+	seq_printf(m, "\nrefreshed:       %lu\n", s5p_nand_scrub_stat.refreshed);
+	seq_printf(m, "aborted:         %lu\n", s5p_nand_scrub_stat.aborted);
+	seq_printf(m, "skipped:         %lu\n", s5p_nand_scrub_stat.skipped);
+	seq_printf(m, "failed:          %lu\n", s5p_nand_scrub_stat.failed);
+
+	seq_printf(m, "\nblocks with bitflips since erase:\n");
+	for (i = 0; i < s5p_nand_scrub_nr; i++) {
+		b = &s5p_nand_scrub[i];
+		if (!b->flips || !(b->flags & S5P_NAND_SCRUB_ON))
+			continue;
+		seq_printf(m, "  block %5d: %u bitflips, %u reads%s%s\n", i, b->flips, b->reads,
+			   (b->flags & S5P_NAND_SCRUB_PENDING) ? ", pending" : "",
+			   (b->flags & S5P_NAND_SCRUB_SKIP) ? ", skipped" : "");
+	}
+
+	return 0;
+}
+
+static int s5p_nand_scrub_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, s5p_nand_scrub_show, NULL);
+}
+
+static const struct file_operations s5p_nand_scrub_fops = {
+	.owner		= THIS_MODULE,
+	.open		= s5p_nand_scrub_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+//分区表里的名字是否在scrub_parts里
+static int s5p_nand_scrub_wanted(const char *name)
+{
+	const char *p = scrub_parts;
+	int len = strlen(name);
+
+	while (p && *p) {
+		if (!strncmp(p, name, len) && (p[len] == ',' || p[len] == '\0'))
+			return 1;
+		p = strchr(p, ',');
+		if (p)
+			p++;
+	}
+
+	return 0;
+}
+
+//按mtdpart的规则算出分区的实际位置，标记完整落在分区里的块
+static int s5p_nand_scrub_mark_parts(struct mtd_info *mtd)
+{
+	uint64_t cur = 0, ofs, size;
+	unsigned int b;
+	int nr = 0;
+	int i;
+
+	for (i = 0; i < s5p_nand_nr_parts; i++) {
+		struct mtd_partition *part = &s5p_nand_part_table[i];
+
+		ofs = part->offset;
+		if (ofs == MTDPART_OFS_APPEND)
+			ofs = cur;
+		else if (ofs == MTDPART_OFS_NXTBLK)
+			ofs = ALIGN(cur, (uint64_t)mtd->erasesize);
+		size = (part->size == MTDPART_SIZ_FULL) ? mtd->size - ofs : part->size;
+		cur = ofs + size;
+
+		if (!s5p_nand_scrub_wanted(part->name))
+			continue;
+
+		for (b = div_u64(ofs + mtd->erasesize - 1, mtd->erasesize);
+		     b < s5p_nand_scrub_nr && (uint64_t)(b + 1) * mtd->erasesize <= ofs + size; b++)
+			s5p_nand_scrub[b].flags |= S5P_NAND_SCRUB_ON;
+
+		printk("s5p_nand: scrubbing \"%s\"\n", part->name);
+		nr++;
+	}
+
+	return nr;
+}
+
+//nand_scan_tail之后调用，挂到读页函数上开始统计
+static void s5p_nand_scrub_init(struct mtd_info *mtd)
+{
+	struct nand_chip *chip = mtd->priv;
+
+	if (!scrub_parts || !*scrub_parts)
+		return;
+
+	s5p_nand_scrub_nr = mtd->size >> chip->phys_erase_shift;
+	s5p_nand_scrub = vzalloc(s5p_nand_scrub_nr * sizeof(*s5p_nand_scrub));
+	if (!s5p_nand_scrub)
+		return;
+
+	//汉明码每256字节只能纠1bit，出现一个就刷新；BCH到一半纠错能力时刷新
+	s5p_nand_scrub_thresh = scrub_flips;
+	if (s5p_nand_scrub_thresh <= 0)
+		s5p_nand_scrub_thresh = s5p_nand_bch ? max(2, s5p_nand_bch->t / 2) : 1;
+
+	s5p_nand_scrub_read_page_orig = chip->ecc.read_page;
+	s5p_nand_scrub_read_subpage_orig = chip->ecc.read_subpage;
+	chip->ecc.read_page = s5p_nand_scrub_read_page;
+	if (chip->ecc.read_subpage)
+		chip->ecc.read_subpage = s5p_nand_scrub_read_subpage;
+}
+
+//分区注册之后调用，启动线程；线程起不来也不影响驱动
+static void s5p_nand_scrub_start(struct mtd_info *mtd)
+{
+	if (!s5p_nand_scrub || !s5p_nand_scrub_mark_parts(mtd))
+		return;
+
+	s5p_nand_scrub_buf = vmalloc(mtd->erasesize + (mtd->erasesize / mtd->writesize) * mtd->oobsize);
+	if (!s5p_nand_scrub_buf)
+		return;
+
+	register_pm_notifier(&s5p_nand_scrub_pm_nb);
+
+	s5p_nand_scrub_task = kthread_run(s5p_nand_scrub_thread, mtd, "s5p_nand_scrub");
+	if (IS_ERR(s5p_nand_scrub_task)) {
+		printk("s5p_nand: failed to start scrub thread\n");
+		unregister_pm_notifier(&s5p_nand_scrub_pm_nb);
+		s5p_nand_scrub_task = NULL;
+		return;
+	}
+
+	if (s5p_nand_debugfs)
+		s5p_nand_scrub_debugfs = debugfs_create_file("scrub", S_IRUSR, s5p_nand_debugfs,
+							     NULL, &s5p_nand_scrub_fops);
+}
+
+static void s5p_nand_scrub_exit(void)
+{
+	debugfs_remove(s5p_nand_scrub_debugfs);
+	s5p_nand_scrub_debugfs = NULL;
+
+	if (s5p_nand_scrub_task) {
+		kthread_stop(s5p_nand_scrub_task);
+		s5p_nand_scrub_task = NULL;
+		unregister_pm_notifier(&s5p_nand_scrub_pm_nb);
+		printk("s5p_nand: scrub %lu refreshed, %lu aborted, %lu skipped, %lu failed\n",
+		       s5p_nand_scrub_stat.refreshed, s5p_nand_scrub_stat.aborted,
+		       s5p_nand_scrub_stat.skipped, s5p_nand_scrub_stat.failed);
+	}
+
+	vfree(s5p_nand_scrub_buf);
+	s5p_nand_scrub_buf = NULL;
+	vfree(s5p_nand_scrub);
+	s5p_nand_scrub = NULL;
+}
+
+/*
+ * cache program / cache read
+ * 连续写: 非最后一页用15h代替10h，芯片把数据搬进cache寄存器后就绪，
+ *         下一页的数据传输和本页的编程(tPROG)重叠
+ * 连续读: 发现顺序读之后用31h，下一页在阵列中加载(tR)的同时输出本页数据，
+ *         块内最后一页或者有其他命令插入时用3Fh结束
+ */
+#define S5P_NAND_CMD_READCACHESEQ	0x31
+#define S5P_NAND_CMD_READCACHEEND	0x3f
+
+static int cache_program = 1;
+module_param(cache_program, int, 0644);
+MODULE_PARM_DESC(cache_program, "Use cache program (15h) for sequential writes");
+
+static int cache_read = 1;
+module_param(cache_read, int, 0644);
+MODULE_PARM_DESC(cache_read, "Use cache read (31h/3Fh) for sequential reads");
+
+//芯片是否支持cache read，识别芯片时确定
+static int s5p_nand_has_cache_read;
+//按片选分别记录，页地址是芯片内的页号
+static int s5p_nand_last_read[S5P_NAND_MAX_CHIPS] = { [0 ... S5P_NAND_MAX_CHIPS - 1] = -1 };
+//cache read进行中时为阵列正在加载的页，否则为-1
+static int s5p_nand_cache_next[S5P_NAND_MAX_CHIPS] = { [0 ... S5P_NAND_MAX_CHIPS - 1] = -1 };
+//上一页是否用15h编程，决定最后一页要不要检查上一页的编程结果
+static int s5p_nand_cache_prog;
+
+static void s5p_nand_cache_cmd(struct mtd_info *mtd, unsigned command)
+{
+	struct nand_chip *chip = mtd->priv;
+
+	chip->cmd_ctrl(mtd, command, NAND_NCE | NAND_CLE | NAND_CTRL_CHANGE);
+	chip->cmd_ctrl(mtd, NAND_CMD_NONE, NAND_NCE | NAND_CTRL_CHANGE);
+
+	//tWB
+	ndelay(100);
+	nand_wait_ready(mtd);
+}
+
+static void s5p_nand_cache_read_end(struct mtd_info *mtd)
+{
+	if (s5p_nand_cache_next[s5p_nand_cur_chip] < 0)
+		return;
+
+	s5p_nand_cache_next[s5p_nand_cur_chip] = -1;
+	s5p_nand_cache_cmd(mtd, S5P_NAND_CMD_READCACHEEND);
+}
+
+static void s5p_nand_cmdfunc(struct mtd_info *mtd, unsigned command,
+			     int column, int page_addr)
+{
+	struct nand_chip *chip = mtd->priv;
+	int last = (1 << (chip->phys_erase_shift - chip->page_shift)) - 1;
+	int sequential;
+
+	if (command == NAND_CMD_READ0)
+		s5p_nand_cur_page = page_addr;
+
+	s5p_nand_scrub_cmd(mtd, command, page_addr);
+
+	if (s5p_nand_ways > 1) {
+		s5p_nand_ilv_cmdfunc(mtd, command, column, page_addr);
+		return;
+	}
+
+	if (command == NAND_CMD_READ0 && cache_read && s5p_nand_has_cache_read) {
+		int *next = &s5p_nand_cache_next[s5p_nand_cur_chip];
+
+		sequential = (page_addr == s5p_nand_last_read[s5p_nand_cur_chip] + 1);
+		s5p_nand_last_read[s5p_nand_cur_chip] = page_addr;
+
+		if (page_addr == *next && column == 0) {
+			if ((page_addr & last) == last) {
+				*next = -1;
+				s5p_nand_cache_cmd(mtd, S5P_NAND_CMD_READCACHEEND);
+			} else {
+				*next = page_addr + 1;
+				s5p_nand_cache_cmd(mtd, S5P_NAND_CMD_READCACHESEQ);
+			}
+			return;
+		}
+
+		s5p_nand_cache_read_end(mtd);
+		s5p_nand_cmdfunc_orig(mtd, command, column, page_addr);
+
+		//第二次顺序读开始流水: 本页从数据寄存器搬到cache寄存器，同时预读下一页
+		if (sequential && column == 0 && (page_addr & last) != last) {
+			*next = page_addr + 1;
+			s5p_nand_cache_cmd(mtd, S5P_NAND_CMD_READCACHESEQ);
+		}
+		return;
+	}
+
+	//页内随机读在cache寄存器上进行，不打断流水
+	if (command != NAND_CMD_RNDOUT)
+		s5p_nand_cache_read_end(mtd);
+
+	s5p_nand_cmdfunc_orig(mtd, command, column, page_addr);
+}
+
+static int s5p_nand_write_page(struct mtd_info *mtd, struct nand_chip *chip,
+			       const uint8_t *buf, int page, int cached, int raw)
+{
+	int status;
+	int fail;
+
+	if (s5p_nand_ways > 1)
+		return s5p_nand_ilv_write_page(mtd, chip, buf, page, cached, raw);
+
+	chip->cmdfunc(mtd, NAND_CMD_SEQIN, 0x00, page);
+
+	if (unlikely(raw))
+		chip->ecc.write_page_raw(mtd, chip, buf);
+	else if (!s5p_nand_write_subpage(mtd, chip, buf))
+		chip->ecc.write_page(mtd, chip, buf);
+
+	if (cached && cache_program && (chip->options & NAND_CACHEPRG)) {
+		chip->cmdfunc(mtd, NAND_CMD_CACHEDPROG, -1, -1);
+		status = chip->waitfunc(mtd, chip);
+
+		//15h之后I/O1是上一页的编程结果
+		fail = s5p_nand_cache_prog ? (status & NAND_STATUS_FAIL_N1) : 0;
+		s5p_nand_cache_prog = 1;
+	} else {
+		chip->cmdfunc(mtd, NAND_CMD_PAGEPROG, -1, -1);
+		status = chip->waitfunc(mtd, chip);
+
+		fail = status & NAND_STATUS_FAIL;
+		if (s5p_nand_cache_prog)
+			fail |= status & NAND_STATUS_FAIL_N1;
+		s5p_nand_cache_prog = 0;
+
+		if (fail && chip->errstat)
+			fail = chip->errstat(mtd, chip, FL_WRITING, status, page) & NAND_STATUS_FAIL;
+	}
+
+	if (fail) {
+		s5p_nand_cache_prog = 0;
+		return -EIO;
+	}
+
+	return 0;
+}
+
+//nfdata支持32位访问，页数据按字读写，MMIO次数只有按字节的1/4
+//buf不对齐的头部和不足一个字的尾部按字节处理
+static void s5p_nand_read_buf(struct mtd_info *mtd, uint8_t *buf, int len)
+{
+	for (; len > 0 && ((unsigned long)buf & 3); len--)
+		*buf++ = s5p_nand_io->data_readb();
+
+	s5p_nand_io->data_reads(buf, len >> 2);
+	buf += len & ~3;
+
+	for (len &= 3; len > 0; len--)
+		*buf++ = s5p_nand_io->data_readb();
+}
+
+static void s5p_nand_write_buf(struct mtd_info *mtd, const uint8_t *buf, int len)
+{
+	for (; len > 0 && ((unsigned long)buf & 3); len--)
+		s5p_nand_io->data_writeb(*buf++);
+
+	s5p_nand_io->data_writes(buf, len >> 2);
+	buf += len & ~3;
+
+	for (len &= 3; len > 0; len--)
+		s5p_nand_io->data_writeb(*buf++);
+}
+
+//nand_base默认的read_byte/verify_buf直接读IO_ADDR_R，也要经过寄存器后端
+static uint8_t s5p_nand_read_byte(struct mtd_info *mtd)
+{
+	return s5p_nand_io->data_readb();
+}
+
+static int s5p_nand_verify_buf(struct mtd_info *mtd, const uint8_t *buf, int len)
+{
+	int i;
+
+	for (i = 0; i < len; i++)
+		if (buf[i] != s5p_nand_io->data_readb())
+			return -EFAULT;
+
+	return 0;
+}
+
+static int s5p_nand_device_ready(struct mtd_info *mtd)
+{
+	return (s5p_nand_readl(nfstat) & (1 << 0));
+}
+
+/*
+ * 坏块表
+ * use_flash_bbt=1: 坏块表存放在flash最后4个块里，主表+镜像表，带版本号，
+ *                  只有第一次加载(或两张表都坏了)才扫描全部块的OOB
+ * use_flash_bbt=0: 每次加载扫描OOB坏块标记，只在内存中建表
+ * 内存中的表每块2bit，block_isbad直接查表
+ */
+static int use_flash_bbt = 1;
+module_param(use_flash_bbt, int, 0444);
+MODULE_PARM_DESC(use_flash_bbt, "Keep the bad block table on flash");
+
+static uint8_t s5p_nand_bbt_pattern[] = { 'B', 'b', 't', '0' };
+static uint8_t s5p_nand_mirror_pattern[] = { '1', 't', 'b', 'B' };
+
+//pattern和版本号放在OOB的空闲区(软件ECC的ECC字节在40~63)
+static struct nand_bbt_descr s5p_nand_bbt_main_descr = {
+	.options	= NAND_BBT_LASTBLOCK | NAND_BBT_CREATE | NAND_BBT_WRITE
+			| NAND_BBT_2BIT | NAND_BBT_VERSION | NAND_BBT_PERCHIP,
+	.offs		= 8,
+	.len		= 4,
+	.veroffs	= 12,
+	.maxblocks	= 4,
+	.pattern	= s5p_nand_bbt_pattern,
+};
+
+static struct nand_bbt_descr s5p_nand_bbt_mirror_descr = {
+	.options	= NAND_BBT_LASTBLOCK | NAND_BBT_CREATE | NAND_BBT_WRITE
+			| NAND_BBT_2BIT | NAND_BBT_VERSION | NAND_BBT_PERCHIP,
+	.offs		= 8,
+	.len		= 4,
+	.veroffs	= 12,
+	.maxblocks	= 4,
+	.pattern	= s5p_nand_mirror_pattern,
+};
+
+/*
+ * 加载缓存
+ * 不用flash坏块表时每次加载都要读所有块的OOB建表，块多的时候占了启动时间的大头
+ * attach_cache=1时把识别出的几何参数和内存中的坏块表追加写到attach_cache_ofs处的一个擦除块，
+ * 带crc32校验，下次加载时ID、几何参数、交错方式都一致就直接使用，跳过扫描
+ * 块写满后擦除重来，写到一半掉电的记录crc不对，退回上一条
+ * 只在use_flash_bbt=0时生效: flash坏块表本身只读最后几个块，缓存省不下时间
+ * (model_test里读缓存反而比读flash坏块表多2页)
+ * attach_cache_ofs没有默认值，必须指定一个驱动专用的块(例如单独划一个分区)，
+ * 这个块归驱动所有，不能和bootloader的环境变量等共用
+ */
+#define S5P_NAND_ATTACH_MAGIC		0x414e3553	/* "S5NA" */
+#define S5P_NAND_ATTACH_VERSION		2
+
+static int attach_cache = 0;
+module_param(attach_cache, int, 0444);
+MODULE_PARM_DESC(attach_cache, "Cache the bad block table on flash: 0 off, 1 on, 2 rebuild");
+
+static uint attach_cache_ofs = 0;
+module_param(attach_cache_ofs, uint, 0444);
+MODULE_PARM_DESC(attach_cache_ofs, "Offset of the erase block reserved for the cache (required)");
+
+struct s5p_nand_attach_rec {
+	u32 magic;
+	u16 version;
+	u16 hdr_len;
+	u32 len;		//头+坏块表的字节数
+	u32 crc;		//计算时crc字段为0
+	u8 id[8];
+	u32 numchips;
+	u32 ways;
+	u32 writesize;
+	u32 oobsize;
+	u32 erasesize;
+	u64 size;
+	u8 bbt[0];
+};
+
+static DEFINE_MUTEX(s5p_nand_attach_lock);
+static int s5p_nand_attach_ok;
+//块内下一条记录的页号，-1表示要先擦除
+static int s5p_nand_attach_next = -1;
+static u8 s5p_nand_attach_id[8];
+
+static int (*s5p_nand_block_markbad_orig)(struct mtd_info *mtd, loff_t ofs);
+
+static int s5p_nand_attach_bbt_len(struct mtd_info *mtd)
+{
+	struct nand_chip *chip = mtd->priv;
+
+	return mtd->size >> (chip->bbt_erase_shift + 2);
+}
+
+static int s5p_nand_attach_pages(struct mtd_info *mtd)
+{
+	int len = sizeof(struct s5p_nand_attach_rec) + s5p_nand_attach_bbt_len(mtd);
+
+	return DIV_ROUND_UP(len, mtd->writesize);
+}
+
+static u32 s5p_nand_attach_crc(struct s5p_nand_attach_rec *rec)
+{
+	u32 saved = rec->crc;
+	u32 crc;
+
+	rec->crc = 0;
+	crc = crc32(0, rec, rec->len);
+	rec->crc = saved;
+
+	return crc;
+}
+
+static int s5p_nand_attach_read(struct mtd_info *mtd, int page, int npages, u8 *buf)
+{
+	size_t retlen;
+	int ret;
+
+	ret = mtd->read(mtd, attach_cache_ofs + (loff_t)page * mtd->writesize,
+			npages * mtd->writesize, &retlen, buf);
+	if (ret == -EUCLEAN)
+		ret = 0;
+
+	return ret;
+}
+
+/*
+ * 找块里最后一条完整的记录，读到buf里，返回0
+ * 顺便确定下一条记录的位置: 第一个擦除状态的页之后都是空的
+ */
+static int s5p_nand_attach_find(struct mtd_info *mtd, u8 *buf)
+{
+	struct s5p_nand_attach_rec *rec = (struct s5p_nand_attach_rec *)buf;
+	int ppb = mtd->erasesize / mtd->writesize;
+	int npages = s5p_nand_attach_pages(mtd);
+	int *starts;
+	int nr = 0;
+	int page = 0;
+	int ret = -ENOENT;
+
+	starts = kmalloc(ppb * sizeof(int), GFP_KERNEL);
+	if (!starts)
+		return -ENOMEM;
+
+	s5p_nand_attach_next = -1;
+	while (page < ppb) {
+		if (s5p_nand_attach_read(mtd, page, 1, buf)) {
+			page++;
+			continue;
+		}
+
+		if (rec->magic == 0xffffffff) {
+			s5p_nand_attach_next = page;
+			break;
+		}
+
+		if (rec->magic == S5P_NAND_ATTACH_MAGIC && rec->len > 0 &&
+		    rec->len <= npages * mtd->writesize) {
+			starts[nr++] = page;
+			page += DIV_ROUND_UP(rec->len, mtd->writesize);
+		} else {
+			page++;
+		}
+	}
+
+	//从后往前找crc正确的记录
+	while (nr--) {
+		if (starts[nr] + npages > ppb)
+			continue;
+		if (s5p_nand_attach_read(mtd, starts[nr], npages, buf))
+			continue;
+		if (rec->crc == s5p_nand_attach_crc(rec)) {
+			ret = 0;
+			break;
+		}
+	}
+
+	kfree(starts);
+
+	return ret;
+}
+
+static int s5p_nand_attach_match(struct mtd_info *mtd, struct s5p_nand_attach_rec *rec)
+{
+	struct nand_chip *chip = mtd->priv;
+
+	return rec->version == S5P_NAND_ATTACH_VERSION &&
+	       rec->hdr_len == sizeof(*rec) &&
+	       rec->len == sizeof(*rec) + s5p_nand_attach_bbt_len(mtd) &&
+	       !memcmp(rec->id, s5p_nand_attach_id, sizeof(rec->id)) &&
+	       rec->numchips == chip->numchips &&
+	       rec->ways == s5p_nand_ways &&
+	       rec->writesize == mtd->writesize &&
+	       rec->oobsize == mtd->oobsize &&
+	       rec->erasesize == mtd->erasesize &&
+	       rec->size == mtd->size;
+}
+
+//缓存的块必须指定、对齐、不是坏块，否则整个功能关闭
+static int s5p_nand_attach_setup(struct mtd_info *mtd)
+{
+	struct nand_chip *chip = mtd->priv;
+	int i;
+
+	if (use_flash_bbt) {
+		printk("s5p_nand: attach cache is only used with use_flash_bbt=0, ignored\n");
+		return -EINVAL;
+	}
+
+	if (!attach_cache_ofs) {
+		printk("s5p_nand: attach_cache needs attach_cache_ofs\n");
+		return -EINVAL;
+	}
+
+	if ((attach_cache_ofs & (mtd->erasesize - 1)) || attach_cache_ofs >= mtd->size) {
+		printk("s5p_nand: attach cache offset 0x%x not a block in the chip\n", attach_cache_ofs);
+		return -EINVAL;
+	}
+
+	if (mtd->block_isbad(mtd, attach_cache_ofs)) {
+		printk("s5p_nand: attach cache block 0x%x is bad\n", attach_cache_ofs);
+		return -EIO;
+	}
+
+	memset(s5p_nand_attach_id, 0, sizeof(s5p_nand_attach_id));
+	chip->select_chip(mtd, 0);
+	chip->cmdfunc(mtd, NAND_CMD_READID, 0x00, -1);
+	for (i = 0; i < 5; i++)
+		s5p_nand_attach_id[i] = chip->read_byte(mtd);
+	chip->select_chip(mtd, -1);
+
+	s5p_nand_attach_ok = 1;
+
+	return 0;
+}
+
+//从缓存恢复坏块表，成功返回0，nand_base不再扫描
+static int s5p_nand_attach_load(struct mtd_info *mtd)
+{
+	struct nand_chip *chip = mtd->priv;
+	struct s5p_nand_attach_rec *rec;
+	int bbt_len = s5p_nand_attach_bbt_len(mtd);
+	int ret;
+
+	s5p_nand_attach_ok = 0;
+	if (!attach_cache || s5p_nand_attach_setup(mtd))
+		return -ENODEV;
+
+	//attach_cache=2: 不用旧记录，扫描后擦除块重写
+	if (attach_cache == 2)
+		return -ENOENT;
+
+	rec = kmalloc(s5p_nand_attach_pages(mtd) * mtd->writesize, GFP_KERNEL);
+	if (!rec)
+		return -ENOMEM;
+
+	ret = s5p_nand_attach_find(mtd, (u8 *)rec);
+	if (ret)
+		goto out;
+
+	if (!s5p_nand_attach_match(mtd, rec)) {
+		printk("s5p_nand: attach cache does not match the chip, rescanning\n");
+		ret = -ESTALE;
+		goto out;
+	}
+
+	chip->bbt = kmalloc(bbt_len, GFP_KERNEL);
+	if (!chip->bbt) {
+		ret = -ENOMEM;
+		goto out;
+	}
+	memcpy(chip->bbt, rec->bbt, bbt_len);
+
+	printk("s5p_nand: bad block table from attach cache\n");
+
+out:
+	kfree(rec);
+
+	return ret;
+}
+
+//把当前的坏块表追加到缓存块，块满了先擦除
+static void s5p_nand_attach_save(struct mtd_info *mtd)
+{
+	struct nand_chip *chip = mtd->priv;
+	struct s5p_nand_attach_rec *rec;
+	int ppb = mtd->erasesize / mtd->writesize;
+	int npages = s5p_nand_attach_pages(mtd);
+	struct erase_info ei;
+	size_t retlen;
+	int ret;
+
+	if (!s5p_nand_attach_ok || !chip->bbt)
+		return;
+
+	rec = kmalloc(npages * mtd->writesize, GFP_KERNEL);
+	if (!rec)
+		return;
+
+	memset(rec, 0xff, npages * mtd->writesize);
+	memset(rec, 0, sizeof(*rec));
+	rec->magic = S5P_NAND_ATTACH_MAGIC;
+	rec->version = S5P_NAND_ATTACH_VERSION;
+	rec->hdr_len = sizeof(*rec);
+	rec->len = sizeof(*rec) + s5p_nand_attach_bbt_len(mtd);
+	memcpy(rec->id, s5p_nand_attach_id, sizeof(rec->id));
+	rec->numchips = chip->numchips;
+	rec->ways = s5p_nand_ways;
+	rec->writesize = mtd->writesize;
+	rec->oobsize = mtd->oobsize;
+	rec->erasesize = mtd->erasesize;
+	rec->size = mtd->size;
+	memcpy(rec->bbt, chip->bbt, s5p_nand_attach_bbt_len(mtd));
+	rec->crc = s5p_nand_attach_crc(rec);
+
+	mutex_lock(&s5p_nand_attach_lock);
+
+	if (s5p_nand_attach_next < 0 || s5p_nand_attach_next + npages > ppb) {
+		memset(&ei, 0, sizeof(ei));
+		ei.mtd = mtd;
+		ei.addr = attach_cache_ofs;
+		ei.len = mtd->erasesize;
+		ret = mtd->erase(mtd, &ei);
+		if (ret) {
+			printk("s5p_nand: failed to erase attach cache block: %d\n", ret);
+			s5p_nand_attach_ok = 0;
+			goto out;
+		}
+		s5p_nand_attach_next = 0;
+	}
+
+	ret = mtd->write(mtd, attach_cache_ofs + (loff_t)s5p_nand_attach_next * mtd->writesize,
+			 npages * mtd->writesize, &retlen, (u8 *)rec);
+	if (ret) {
+		printk("s5p_nand: failed to write attach cache: %d\n", ret);
+		s5p_nand_attach_next = -1;
+	} else {
+		s5p_nand_attach_next += npages;
+	}
+
+out:
+	mutex_unlock(&s5p_nand_attach_lock);
+	kfree(rec);
+}
+
+//运行中标记了坏块，缓存也跟着更新
+static int s5p_nand_attach_markbad(struct mtd_info *mtd, loff_t ofs)
+{
+	int ret;
+
+	ret = s5p_nand_block_markbad_orig(mtd, ofs);
+	s5p_nand_attach_save(mtd);
+
+	return ret;
+}
+
+static int s5p_nand_scan_bbt(struct mtd_info *mtd)
+{
+	struct nand_chip *chip = mtd->priv;
+	int ret;
+
+	if (use_flash_bbt) {
+		chip->options |= NAND_USE_FLASH_BBT;
+		chip->bbt_td = &s5p_nand_bbt_main_descr;
+		chip->bbt_md = &s5p_nand_bbt_mirror_descr;
+	}
+
+	if (!s5p_nand_attach_load(mtd))
+		return 0;
+
+	ret = nand_default_bbt(mtd);
+	if (!ret)
+		s5p_nand_attach_save(mtd);
+
+	return ret;
+}
+
+/*
+ * 时序
+ * nandflash控制器时钟为HCLK_PSYS，NFCONF中TACLS/TWRPH0/TWRPH1以HCLK为单位:
+ * Duration = HCLK x TACLS         >= max(tCLS, tALS) - tWP
+ * Duration = HCLK x (TWRPH0 + 1)  >= max(tWP, tREA + PCB延时)
+ * Duration = HCLK x (TWRPH1 + 1)  >= max(tCLH, tALH, tWH)
+ * s5pv210手册Note: You should add additional cycles about 10ns for page read
+ * because of additional signal delay on PCB pattern.
+ * 识别芯片之前按ONFI mode 0设置，识别之后按芯片的ONFI时序模式或下面的表重新计算
+ */
+#define S5P_NAND_PCB_DELAY	10
+
+#define S5P_NFCONF_TIMING_MASK	((7 << 12) | (7 << 8) | (7 << 4))
+
+//单位ns
+struct s5p_nand_timing {
+	unsigned char tCLS;
+	unsigned char tCLH;
+	unsigned char tALS;
+	unsigned char tALH;
+	unsigned char tWP;
+	unsigned char tWH;
+	unsigned char tREA;
+};
+
+static const struct s5p_nand_timing s5p_nand_onfi_timings[] = {
+	{ 50, 20, 50, 20, 50, 30, 40 },		/* mode 0 */
+	{ 25, 10, 25, 10, 25, 15, 30 },		/* mode 1 */
+	{ 15, 10, 15, 10, 17, 15, 25 },		/* mode 2 */
+	{ 10,  5, 10,  5, 15, 10, 20 },		/* mode 3 */
+	{ 10,  5, 10,  5, 12, 10, 20 },		/* mode 4 */
+	{ 10,  5, 10,  5, 10,  7, 16 },		/* mode 5 */
+};
+
+struct s5p_nand_chip_info {
+	const char *name;
+	u8 maf_id;
+	u8 dev_id;
+	struct s5p_nand_timing timing;
+	int cache_read;		//支持31h/3Fh
+	int nop;		//每页允许的部分编程次数
+};
+
+//不支持ONFI的芯片，时序取自datasheet
+static const struct s5p_nand_chip_info s5p_nand_chip_table[] = {
+	{ "K9F1G08U0B", NAND_MFR_SAMSUNG, 0xf1, { 12, 5, 12, 5, 12, 10, 20 }, 0, 4 },
+	{ "K9F2G08U0B", NAND_MFR_SAMSUNG, 0xda, { 12, 5, 12, 5, 12, 10, 20 }, 0, 4 },
+	{ "K9F4G08U0B", NAND_MFR_SAMSUNG, 0xdc, { 12, 5, 12, 5, 12, 10, 20 }, 1, 4 },
+	{ "K9K8G08U0B", NAND_MFR_SAMSUNG, 0xd3, { 12, 5, 12, 5, 12, 10, 20 }, 1, 4 },
+};
+
+static unsigned long s5p_nand_clk_rate;
+static const struct s5p_nand_timing *s5p_nand_timing = &s5p_nand_onfi_timings[0];
+
+#ifdef CONFIG_ARCH_S5PV210
+static struct clk *s5p_nand_clk;
+
+static int s5p_nand_clk_get(void)
+{
+	struct clk *clk;
+
+	clk = clk_get(NULL, "nand");
+	if (IS_ERR(clk))
+		return -ENOENT;
+
+	clk_enable(clk);
+	s5p_nand_clk = clk;
+
+	return 0;
+}
+
+static void s5p_nand_clk_put(void)
+{
+	clk_disable(s5p_nand_clk);
+	clk_put(s5p_nand_clk);
+}
+
+static unsigned long s5p_nand_hclk(void)
+{
+	return clk_get_rate(s5p_nand_clk);
+}
+#else
+static int s5p_nand_clk_get(void)
+{
+	return 0;
+}
+
+static void s5p_nand_clk_put(void)
+{
+}
+
+static unsigned long s5p_nand_hclk(void)
+{
+	return S5P_NAND_MODEL_HCLK;
+}
+#endif
+
+static int s5p_nand_cycles(unsigned int ns, unsigned long rate)
+{
+	return DIV_ROUND_UP(ns * (rate / 1000), 1000000);
+}
+
+static int s5p_nand_clamp(const char *name, int val)
+{
+	if (val < 0)
+		return 0;
+
+	if (val > 7) {
+		printk("s5p_nand: %s needs %d cycles, limited to 7\n", name, val);
+		return 7;
+	}
+
+	return val;
+}
+
+static void s5p_nand_set_timing(unsigned long rate)
+{
+	const struct s5p_nand_timing *t = s5p_nand_timing;
+	int tacls, twrph0, twrph1;
+	unsigned long nfconf;
+
+	tacls  = s5p_nand_cycles(max(t->tCLS, t->tALS), rate) - s5p_nand_cycles(t->tWP, rate);
+	twrph0 = s5p_nand_cycles(max(t->tWP, (unsigned char)(t->tREA + S5P_NAND_PCB_DELAY)), rate) - 1;
+	twrph1 = s5p_nand_cycles(max3(t->tCLH, t->tALH, t->tWH), rate) - 1;
+
+	tacls  = s5p_nand_clamp("TACLS", tacls);
+	twrph0 = s5p_nand_clamp("TWRPH0", twrph0);
+	twrph1 = s5p_nand_clamp("TWRPH1", twrph1);
+
+	nfconf = s5p_nand_readl(nfconf) & ~S5P_NFCONF_TIMING_MASK;
+	s5p_nand_writel(nfconf | (tacls << 12) | (twrph0 << 8) | (twrph1 << 4), nfconf);
+
+	s5p_nand_clk_rate = rate;
+
+	//调频时每次都会进来，只在调试时打印
+	pr_debug("s5p_nand: HCLK %lu.%03lu MHz, TACLS=%d TWRPH0=%d TWRPH1=%d\n",
+		 rate / 1000000, (rate / 1000) % 1000, tacls, twrph0, twrph1);
+}
+
+static void s5p_nand_show_timing(void)
+{
+	unsigned long nfconf = s5p_nand_readl(nfconf);
+	unsigned long rate = s5p_nand_clk_rate;
+
+	printk("s5p_nand: HCLK %lu.%03lu MHz, TACLS=%lu TWRPH0=%lu TWRPH1=%lu\n",
+		rate / 1000000, (rate / 1000) % 1000,
+		(nfconf >> 12) & 7, (nfconf >> 8) & 7, (nfconf >> 4) & 7);
+}
+
+//识别完成后选择芯片的时序: ONFI芯片用它报告的最快时序模式，其他查表，都找不到就保持mode 0
+static void s5p_nand_select_timing(struct mtd_info *mtd)
+{
+	struct nand_chip *chip = mtd->priv;
+	u8 maf_id, dev_id;
+	int mode;
+	int i;
+
+	if (chip->onfi_version) {
+		s5p_nand_nop = chip->onfi_params.programs_per_page;
+
+		//ONFI可选命令bit1: Read Cache
+		s5p_nand_has_cache_read = !!(le16_to_cpu(chip->onfi_params.opt_cmd) & (1 << 1));
+
+		mode = fls(le16_to_cpu(chip->onfi_params.async_timing_mode)) - 1;
+		if (mode >= 0) {
+			mode = min_t(int, mode, ARRAY_SIZE(s5p_nand_onfi_timings) - 1);
+			s5p_nand_timing = &s5p_nand_onfi_timings[mode];
+			printk("s5p_nand: ONFI timing mode %d\n", mode);
+			return;
+		}
+	}
+
+	chip->select_chip(mtd, 0);
+	chip->cmdfunc(mtd, NAND_CMD_READID, 0x00, -1);
+	maf_id = chip->read_byte(mtd);
+	dev_id = chip->read_byte(mtd);
+	chip->select_chip(mtd, -1);
+
+	for (i = 0; i < ARRAY_SIZE(s5p_nand_chip_table); i++) {
+		if (s5p_nand_chip_table[i].maf_id == maf_id &&
+		    s5p_nand_chip_table[i].dev_id == dev_id) {
+			s5p_nand_timing = &s5p_nand_chip_table[i].timing;
+			s5p_nand_has_cache_read = s5p_nand_chip_table[i].cache_read;
+			s5p_nand_nop = s5p_nand_chip_table[i].nop;
+			printk("s5p_nand: %s timing\n", s5p_nand_chip_table[i].name);
+			return;
+		}
+	}
+
+	printk("s5p_nand: unknown chip %02x:%02x, keep ONFI mode 0 timing\n", maf_id, dev_id);
+}
+
+#ifdef CONFIG_CPU_FREQ
+/*
+ * 调频时HCLK_PSYS可能跟着变化
+ * 调频前按新旧两个频率中较高的一个设置，保证切换过程中时序都满足；调频后按实际频率重新计算
+ */
+static int s5p_nand_cpufreq_transition(struct notifier_block *nb,
+				       unsigned long val, void *data)
+{
+	struct cpufreq_freqs *freqs = data;
+	unsigned long rate = s5p_nand_hclk();
+
+	if (val == CPUFREQ_PRECHANGE) {
+		if (freqs->new > freqs->old)
+			rate = max(rate, (unsigned long)div_u64((u64)rate * freqs->new, freqs->old));
+		if (rate <= s5p_nand_clk_rate)
+			return 0;
+	} else if (val == CPUFREQ_POSTCHANGE) {
+		if (rate == s5p_nand_clk_rate)
+			return 0;
+	} else {
+		return 0;
+	}
+
+	s5p_nand_get_device(s5p_mtd);
+	s5p_nand_set_timing(rate);
+	s5p_nand_release_device(s5p_mtd);
+
+	return 0;
+}
+
+static struct notifier_block s5p_nand_cpufreq_nb = {
+	.notifier_call = s5p_nand_cpufreq_transition,
+};
+
+static int s5p_nand_cpufreq_register(void)
+{
+	return cpufreq_register_notifier(&s5p_nand_cpufreq_nb,
+					 CPUFREQ_TRANSITION_NOTIFIER);
+}
+
+static void s5p_nand_cpufreq_deregister(void)
+{
+	cpufreq_unregister_notifier(&s5p_nand_cpufreq_nb,
+				    CPUFREQ_TRANSITION_NOTIFIER);
+}
+#else
+static inline int s5p_nand_cpufreq_register(void)
+{
+	return 0;
+}
+
+static inline void s5p_nand_cpufreq_deregister(void)
+{
+}
+#endif
+
+static void s5p_nand_init_later(struct mtd_info *mtd)
+{
+	u_long nfconf;
+
+	nfconf = s5p_nand_readl(nfconf);
+
+	if (nand_type == S5P_NAND_TYPE_SLC) {
+		if (mtd->writesize == 512) {
+			nfconf |= (1 << 2);
+		} else {
+			nfconf &= ~(1 << 2);
+		}
+	} else {
+		nfconf |= (3 << 23) | (1 << 3);
+		if (mtd->writesize == 2048) {
+			nfconf |= (1 << 2);
+		} else {
+			nfconf &= ~(1 << 2);
+		}
+	}
+
+	s5p_nand_writel(nfconf, nfconf);
+}
+
+
+static int __init s5p_nand_init(void)
+{
+	int err = 0;
+
+	printk("s5p_nand_init!\n");
+
+	// 1.分配mtd_info和nand_chip结构体
+	s5p_mtd = kzalloc(sizeof(struct mtd_info) + sizeof(struct nand_chip), GFP_KERNEL);
+	if (!s5p_mtd) {
+		err = -ENOMEM;
+		printk("%s(%d) filed to malloc!\n", __FILE__, __LINE__);
+
+		return err;
+	}
+
+	s5p_nand = (struct nand_chip *)(&s5p_mtd[1]);
+
+	//重映射nand寄存器(或者初始化寄存器模型)
+	err = s5p_nand_io_init();
+	if (err) {
+		printk("%s(%d) failed to init %s registers\n", __FILE__, __LINE__, regs);
+
+		goto err_free_s5p_mtd;
+	}
+
+	// 2. 设置nand_chip结构体
+	//设置nand_chip是给nand_scan用的
+	//它应该提供:选中,发命令,发地址,发数据,读数据,判断状态的功能
+	s5p_nand->cmd_ctrl = s5p_nand_hwcontrol;
+	s5p_nand->select_chip = s5p_nand_select_chip;
+	s5p_nand->dev_ready = s5p_nand_device_ready;
+	s5p_nand->read_buf = s5p_nand_read_buf;
+	s5p_nand->write_buf = s5p_nand_write_buf;
+	s5p_nand->read_byte = s5p_nand_read_byte;
+	s5p_nand->verify_buf = s5p_nand_verify_buf;
+	s5p_nand->scan_bbt = s5p_nand_scan_bbt;
+	s5p_nand->options = 0;
+	s5p_nand->badblockbits = 8;
+	s5p_nand->ecc.mode = NAND_ECC_SOFT;
+
+	// 3. 硬件相关设置，根据nandflash手册设置
+	//是能nand控制器时钟
+	err = s5p_nand_clk_get();
+	if (err) {
+		printk("%s(%d) failed to get nand clk!\n", __FILE__, __LINE__);
+	
+		goto err_iounmap;
+	}
+
+	//识别芯片前先用最保守的时序
+	s5p_nand_set_timing(s5p_nand_hclk());
+
+	//取消片选，使能控制器
+	s5p_nand_writel(S5P_NFCONT_CE_MASK | (1 << 0), nfcont);
+
+	//R/nB中断，nand_scan写坏块表时就会用到
+	s5p_nand_rnb_init();
+
+	// 4. 使用nand_scan
+	s5p_mtd->owner = THIS_MODULE;
+	s5p_mtd->priv = s5p_nand;
+	s5p_mtd->name = S5P_NAND_MTD_ID;
+
+	//识别nand flash，构造mtd_info
+	nr_chips = clamp(nr_chips, 1, S5P_NAND_MAX_CHIPS);
+	if (nand_scan_ident(s5p_mtd, nr_chips, NULL)) {
+		err = -ENXIO;
+		printk("%s(%d) failed to scan nand!\n", __FILE__, __LINE__);
+
+		goto err_free_irq;
+	}
+
+	//nand_scan_ident已经选好了大页/小页的命令函数，在它外面包一层处理cache read
+	s5p_nand_cmdfunc_orig = s5p_nand->cmdfunc;
+	s5p_nand->cmdfunc = s5p_nand_cmdfunc;
+	s5p_nand->write_page = s5p_nand_write_page;
+	s5p_nand_block_markbad_orig = s5p_nand->block_markbad;
+	s5p_nand->block_markbad = s5p_nand_attach_markbad;
+
+	//按识别出的芯片重新计算时序，后面扫描坏块就用最紧的时序
+	s5p_nand_select_timing(s5p_mtd);
+
+	//多片芯片时交错访问，cache read的顺序页在交错后落在不同芯片上，不再使用
+	s5p_nand_ilv_setup(s5p_mtd);
+	if (s5p_nand_ways > 1)
+		s5p_nand_has_cache_read = 0;
+	err = s5p_nand_bch_setup(s5p_mtd);
+	if (err) {
+		printk("%s(%d) failed to set up BCH ECC!\n", __FILE__, __LINE__);
+
+		goto err_free_irq;
+	}
+	s5p_nand_subpage_setup(s5p_mtd);
+	s5p_nand_set_timing(s5p_nand_hclk());
+	s5p_nand_show_timing();
+
+	if (nand_scan_tail(s5p_mtd)) {
+		err = -ENXIO;
+		printk("%s(%d) failed to scan nand!\n", __FILE__, __LINE__);
+
+		goto err_free_irq;
+	}
+
+	printk("s5p_nand: page %u, subpage %u, oob %u\n",
+	       s5p_mtd->writesize, s5p_nand->subpagesize, s5p_mtd->oobsize);
+
+	//根据nandflash类型设置控制器flash页大小
+	s5p_nand_init_later(s5p_mtd);
+
+	s5p_nand_health_init(s5p_mtd);
+	s5p_nand_scrub_init(s5p_mtd);
+
+	err = s5p_nand_cpufreq_register();
+	if (err) {
+		printk("%s(%d) failed to register cpufreq notifier!\n", __FILE__, __LINE__);
+
+		goto err_release_nand;
+	}
+
+	//注册mtd设备
+	err = s5p_nand_add_partitions(s5p_mtd);
+	if (err) {
+		printk("%s(%d) failed to add partitions!\n", __FILE__, __LINE__);
+
+		goto err_cpufreq_deregister;
+	}
+
+	s5p_nand_scrub_start(s5p_mtd);
+
+	return 0;
+	
+err_cpufreq_deregister:
+	s5p_nand_cpufreq_deregister();
+	kfree(s5p_nand_parts);
+err_release_nand:
+	s5p_nand_scrub_exit();
+	s5p_nand_health_exit();
+	nand_release(s5p_mtd);
+err_free_irq:
+	s5p_nand_bch_exit();
+	s5p_nand_rnb_exit();
+	s5p_nand_clk_put();
+err_iounmap:
+	s5p_nand_io_exit();
+err_free_s5p_mtd:
+	kfree(s5p_mtd);
+
+	return err;
+}
+
+
+static void __exit s5p_nand_exit(void)
+{
+	printk("s5p_nand_exit!\n");
+
+	//线程用的是整片的mtd，先停掉再注销分区
+	s5p_nand_scrub_exit();
+	//注销分区并释放坏块表和nand_scan分配的buffer，和加载失败的路径一样
+	nand_release(s5p_mtd);
+	kfree(s5p_nand_parts);
+	s5p_nand_health_exit();
+	s5p_nand_cpufreq_deregister();
+	s5p_nand_bch_exit();
+	s5p_nand_rnb_exit();
+	s5p_nand_clk_put();
+	s5p_nand_io_exit();
+	kfree(s5p_mtd);
+}
+
+module_init(s5p_nand_init);
+module_exit(s5p_nand_exit);
+MODULE_AUTHOR("Nick <hbjsxieqi@163.com>");
+MODULE_DESCRIPTION("TINY210 Nand Flash MTD Driver");
+MODULE_LICENSE("GPL");
+
+
+
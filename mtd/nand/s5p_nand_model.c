@@ -0,0 +1,527 @@
+/*
+ * s5pv210 nandflash控制器的软件模型
+ *
+ * 按寄存器语义模拟NFCONF/NFCONT/NFCMMD/NFADDR/NFDATA/NFSTAT，后面接一片内存中的K9F1G08U0B
+ * (2048+64字节/页，64页/块，1024块)，驱动用regs=model加载时所有寄存器访问都到这里
+ * 支持的命令: RESET、READID、READ(00h-30h)、RNDOUT(05h-E0h)、PROG(80h-10h/15h)、
+ *             RNDIN(85h)、ERASE(60h-D0h)、STATUS(70h)，其他命令计数后忽略
+ * 操作立即完成，R/nB一直是就绪，阵列的忙时间(tR/tPROG/tBERS)只累加到统计里
+ * 总线时间按NFCONF里的TACLS/TWRPH0/TWRPH1计算: 命令/地址周期 TACLS+(TWRPH0+1)+(TWRPH1+1)，
+ * 数据周期 (TWRPH0+1)+(TWRPH1+1)，单位HCLK，用来比较不同时序设置和访问方式的开销
+ * model_flips>0时每次读页在输出的数据里随机翻转几个bit，用来测试ECC
+ * 块在第一次编程时才分配，没分配的块读出来是0xff
+ */
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#include <linux/vmalloc.h>
+#include <linux/random.h>
+#include <linux/math64.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/mtd/nand.h>
+
+#include "s5p_nand.h"
+
+#define MODEL_PAGE		2048
+#define MODEL_OOB		64
+#define MODEL_PAGE_SIZE		(MODEL_PAGE + MODEL_OOB)
+#define MODEL_BLOCK_PAGES	64
+#define MODEL_BLOCKS		1024
+#define MODEL_PAGES		(MODEL_BLOCKS * MODEL_BLOCK_PAGES)
+#define MODEL_NOP		4
+
+//K9F1G08U0B手册的典型值(ns)
+#define MODEL_T_R		25000
+#define MODEL_T_PROG		200000
+#define MODEL_T_BERS		1500000
+#define MODEL_T_RST		5000
+
+static int model_flips;
+module_param(model_flips, int, 0644);
+MODULE_PARM_DESC(model_flips, "Register model: random bitflips injected into each page read");
+
+static const u8 model_id[] = { NAND_MFR_SAMSUNG, 0xf1, 0x00, 0x95, 0x40 };
+
+enum {
+	MODEL_OUT_NONE,
+	MODEL_OUT_ID,
+	MODEL_OUT_STATUS,
+	MODEL_OUT_PAGE,
+};
+
+static u8 **model_blocks;
+static u8 *model_nop;			//每页已经编程的次数
+static u8 model_page[MODEL_PAGE_SIZE];	//芯片的页寄存器
+
+static u32 model_nfconf;
+static u32 model_nfcont;
+static u32 model_nfstat;
+
+static unsigned int model_cmd;
+static int model_naddr;
+static u8 model_addr[5];
+static int model_out;
+static int model_ptr;
+static u8 model_status;
+
+static struct {
+	unsigned long cmds;
+	unsigned long addrs;
+	unsigned long reg_reads;
+	unsigned long reg_writes;
+	unsigned long byte_access;		//nfdata按字节访问的次数
+	unsigned long word_access;		//nfdata按字访问的次数
+	unsigned long long data_in;		//写入芯片的字节
+	unsigned long long data_out;		//从芯片读出的字节
+	unsigned long page_reads;
+	unsigned long page_progs;
+	unsigned long erases;
+	unsigned long nop_violations;
+	unsigned long unknown_cmds;
+	unsigned long flips;
+	unsigned long long bus_cycles;		//HCLK
+	unsigned long long array_ns;
+} model_stat;
+
+static int model_selected(void)
+{
+	return !(model_nfcont & S5P_NFCONT_NCE0);
+}
+
+static unsigned int model_cmd_cycles(void)
+{
+	return ((model_nfconf >> 12) & 7) + ((model_nfconf >> 8) & 7) + 1 + ((model_nfconf >> 4) & 7) + 1;
+}
+
+static unsigned int model_data_cycles(void)
+{
+	return ((model_nfconf >> 8) & 7) + 1 + ((model_nfconf >> 4) & 7) + 1;
+}
+
+static int model_col(void)
+{
+	return model_addr[0] | (model_addr[1] << 8);
+}
+
+//READ/PROG的行地址在第3、4个地址周期，ERASE在第1、2个
+static int model_row(int first)
+{
+	return (model_addr[first] | (model_addr[first + 1] << 8)) % MODEL_PAGES;
+}
+
+static u8 *model_page_ptr(int row, int alloc)
+{
+	int block = row / MODEL_BLOCK_PAGES;
+
+	if (!model_blocks[block]) {
+		if (!alloc)
+			return NULL;
+		model_blocks[block] = vmalloc(MODEL_BLOCK_PAGES * MODEL_PAGE_SIZE);
+		if (!model_blocks[block])
+			return NULL;
+		memset(model_blocks[block], 0xff, MODEL_BLOCK_PAGES * MODEL_PAGE_SIZE);
+	}
+
+	return model_blocks[block] + (row % MODEL_BLOCK_PAGES) * MODEL_PAGE_SIZE;
+}
+
+static void model_busy(unsigned int ns)
+{
+	model_stat.array_ns += ns;
+	model_nfstat |= S5P_NFSTAT_RNB_TRANS;
+}
+
+static void model_load_page(void)
+{
+	int row = model_row(2);
+	u8 *p = model_page_ptr(row, 0);
+	int i, bit;
+
+	if (p)
+		memcpy(model_page, p, MODEL_PAGE_SIZE);
+	else
+		memset(model_page, 0xff, MODEL_PAGE_SIZE);
+
+	for (i = 0; i < model_flips; i++) {
+		bit = random32() % (MODEL_PAGE_SIZE * 8);
+		model_page[bit / 8] ^= 1 << (bit % 8);
+		model_stat.flips++;
+	}
+
+	model_stat.page_reads++;
+	model_busy(MODEL_T_R);
+}
+
+//编程只能把1变成0
+static void model_program_page(void)
+{
+	int row = model_row(2);
+	u8 *p = model_page_ptr(row, 1);
+	int i;
+
+	model_status = NAND_STATUS_READY | NAND_STATUS_WP;
+	if (!p) {
+		model_status |= NAND_STATUS_FAIL;
+		return;
+	}
+
+	if (++model_nop[row] > MODEL_NOP)
+		model_stat.nop_violations++;
+
+	for (i = 0; i < MODEL_PAGE_SIZE; i++)
+		p[i] &= model_page[i];
+
+	model_stat.page_progs++;
+	model_busy(MODEL_T_PROG);
+}
+
+static void model_erase_block(void)
+{
+	int block = model_row(0) / MODEL_BLOCK_PAGES;
+
+	vfree(model_blocks[block]);
+	model_blocks[block] = NULL;
+	memset(model_nop + block * MODEL_BLOCK_PAGES, 0, MODEL_BLOCK_PAGES);
+
+	model_status = NAND_STATUS_READY | NAND_STATUS_WP;
+	model_stat.erases++;
+	model_busy(MODEL_T_BERS);
+}
+
+static void model_command(u8 cmd)
+{
+	model_stat.cmds++;
+	model_stat.bus_cycles += model_cmd_cycles();
+	if (!model_selected())
+		return;
+
+	switch (cmd) {
+	case NAND_CMD_RESET:
+		model_out = MODEL_OUT_NONE;
+		model_status = NAND_STATUS_READY | NAND_STATUS_WP;
+		model_busy(MODEL_T_RST);
+		break;
+
+	case NAND_CMD_READID:
+		model_out = MODEL_OUT_ID;
+		model_ptr = 0;
+		break;
+
+	case NAND_CMD_STATUS:
+		model_out = MODEL_OUT_STATUS;
+		break;
+
+	case NAND_CMD_READ0:
+		//读状态之后不带地址的READ0回到数据输出
+		if (model_out == MODEL_OUT_STATUS)
+			model_out = MODEL_OUT_PAGE;
+		break;
+
+	case NAND_CMD_RNDOUT:
+	case NAND_CMD_ERASE1:
+		break;
+
+	case NAND_CMD_SEQIN:
+		memset(model_page, 0xff, sizeof(model_page));
+		model_out = MODEL_OUT_NONE;
+		break;
+
+	case NAND_CMD_RNDIN:
+		break;
+
+	case NAND_CMD_READSTART:
+		model_load_page();
+		model_out = MODEL_OUT_PAGE;
+		model_ptr = model_col();
+		break;
+
+	case NAND_CMD_RNDOUTSTART:
+		model_out = MODEL_OUT_PAGE;
+		model_ptr = model_col();
+		break;
+
+	case NAND_CMD_PAGEPROG:
+	case NAND_CMD_CACHEDPROG:
+		model_program_page();
+		break;
+
+	case NAND_CMD_ERASE2:
+		model_erase_block();
+		break;
+
+	default:
+		model_stat.unknown_cmds++;
+		return;
+	}
+
+	model_cmd = cmd;
+	model_naddr = 0;
+}
+
+static void model_address(u8 addr)
+{
+	model_stat.addrs++;
+	model_stat.bus_cycles += model_cmd_cycles();
+	if (!model_selected())
+		return;
+
+	if (model_naddr < sizeof(model_addr))
+		model_addr[model_naddr++] = addr;
+
+	//RNDIN的两个列地址之后就可以写数据了
+	if (model_cmd == NAND_CMD_RNDIN || model_cmd == NAND_CMD_SEQIN)
+		model_ptr = model_col();
+}
+
+static u8 model_data_out(void)
+{
+	u8 val = 0xff;
+
+	if (!model_selected())
+		return val;
+
+	switch (model_out) {
+	case MODEL_OUT_ID:
+		val = model_id[model_ptr++ % sizeof(model_id)];
+		break;
+	case MODEL_OUT_STATUS:
+		val = model_status;
+		break;
+	case MODEL_OUT_PAGE:
+		if (model_ptr < MODEL_PAGE_SIZE)
+			val = model_page[model_ptr++];
+		break;
+	}
+
+	model_stat.data_out++;
+
+	return val;
+}
+
+static void model_data_in(u8 val)
+{
+	if (!model_selected())
+		return;
+
+	if ((model_cmd == NAND_CMD_SEQIN || model_cmd == NAND_CMD_RNDIN) &&
+	    model_ptr < MODEL_PAGE_SIZE)
+		model_page[model_ptr++] = val;
+
+	model_stat.data_in++;
+}
+
+static u32 model_reg_read(unsigned int reg)
+{
+	u32 val = 0;
+	int i;
+
+	model_stat.reg_reads++;
+
+	switch (reg) {
+	case S5P_NAND_REG(nfconf):
+		return model_nfconf;
+	case S5P_NAND_REG(nfcont):
+		return model_nfcont;
+	case S5P_NAND_REG(nfstat):
+		return model_nfstat | S5P_NFSTAT_RNB_READY;
+	case S5P_NAND_REG(nfdata):
+		model_stat.word_access++;
+		model_stat.bus_cycles += 4 * model_data_cycles();
+		for (i = 0; i < 4; i++)
+			val |= model_data_out() << (8 * i);
+		return val;
+	}
+
+	return 0;
+}
+
+static void model_reg_write(u32 val, unsigned int reg)
+{
+	int i;
+
+	model_stat.reg_writes++;
+
+	switch (reg) {
+	case S5P_NAND_REG(nfconf):
+		model_nfconf = val;
+		break;
+	case S5P_NAND_REG(nfcont):
+		model_nfcont = val;
+		break;
+	case S5P_NAND_REG(nfcmmd):
+		model_command(val & 0xff);
+		break;
+	case S5P_NAND_REG(nfaddr):
+		model_address(val & 0xff);
+		break;
+	case S5P_NAND_REG(nfdata):
+		model_stat.word_access++;
+		model_stat.bus_cycles += 4 * model_data_cycles();
+		for (i = 0; i < 4; i++)
+			model_data_in(val >> (8 * i));
+		break;
+	case S5P_NAND_REG(nfstat):
+		model_nfstat &= ~(val & S5P_NFSTAT_RNB_TRANS);
+		break;
+	}
+}
+
+static u8 model_data_readb(void)
+{
+	model_stat.byte_access++;
+	model_stat.bus_cycles += model_data_cycles();
+
+	return model_data_out();
+}
+
+static void model_data_writeb(u8 val)
+{
+	model_stat.byte_access++;
+	model_stat.bus_cycles += model_data_cycles();
+	model_data_in(val);
+}
+
+//按字的连续访问，页数据直接整段拷贝
+static void model_data_reads(void *buf, int words)
+{
+	int len = words * 4;
+	int n = 0;
+
+	model_stat.word_access += words;
+	model_stat.bus_cycles += (u64)len * model_data_cycles();
+
+	if (model_selected() && model_out == MODEL_OUT_PAGE) {
+		n = min(len, MODEL_PAGE_SIZE - model_ptr);
+		memcpy(buf, model_page + model_ptr, n);
+		model_ptr += n;
+		model_stat.data_out += n;
+	}
+
+	for (; n < len; n++)
+		((u8 *)buf)[n] = model_data_out();
+}
+
+static void model_data_writes(const void *buf, int words)
+{
+	int len = words * 4;
+	int n = 0;
+
+	model_stat.word_access += words;
+	model_stat.bus_cycles += (u64)len * model_data_cycles();
+
+	if (model_selected() && (model_cmd == NAND_CMD_SEQIN || model_cmd == NAND_CMD_RNDIN)) {
+		n = min(len, MODEL_PAGE_SIZE - model_ptr);
+		memcpy(model_page + model_ptr, buf, n);
+		model_ptr += n;
+		model_stat.data_in += n;
+	}
+
+	for (; n < len; n++)
+		model_data_in(((const u8 *)buf)[n]);
+}
+
+static int model_init(void)
+{
+	model_blocks = vzalloc(MODEL_BLOCKS * sizeof(*model_blocks));
+	model_nop = vzalloc(MODEL_PAGES);
+	if (!model_blocks || !model_nop) {
+		vfree(model_blocks);
+		vfree(model_nop);
+		return -ENOMEM;
+	}
+
+	model_nfconf = 0;
+	model_nfcont = S5P_NFCONT_NCE0;
+	model_nfstat = 0;
+	model_out = MODEL_OUT_NONE;
+	model_status = NAND_STATUS_READY | NAND_STATUS_WP;
+	memset(&model_stat, 0, sizeof(model_stat));
+
+	printk("s5p_nand: register model, K9F1G08U0B %d MiB in memory\n",
+	       MODEL_BLOCKS * MODEL_BLOCK_PAGES * MODEL_PAGE >> 20);
+
+	return 0;
+}
+
+static void model_exit(void)
+{
+	int i;
+
+	for (i = 0; i < MODEL_BLOCKS; i++)
+		vfree(model_blocks[i]);
+	vfree(model_blocks);
+	vfree(model_nop);
+}
+
+const struct s5p_nand_reg_ops s5p_nand_model_ops = {
+	.name		= "model",
+	.init		= model_init,
+	.exit		= model_exit,
+	.reg_read	= model_reg_read,
+	.reg_write	= model_reg_write,
+	.data_readb	= model_data_readb,
+	.data_writeb	= model_data_writeb,
+	.data_reads	= model_data_reads,
+	.data_writes	= model_data_writes,
+};
+
+static int model_show(struct seq_file *m, void *v)
+{
+	unsigned long long bus_ns = div_u64(model_stat.bus_cycles * 1000, S5P_NAND_MODEL_HCLK / 1000000);
+	int blocks = 0;
+	int i;
+
+	for (i = 0; i < MODEL_BLOCKS; i++)
+		blocks += !!model_blocks[i];
+
+	seq_printf(m, "timing:          TACLS %u, TWRPH0 %u, TWRPH1 %u (HCLK %u MHz)\n",
+		   (model_nfconf >> 12) & 7, (model_nfconf >> 8) & 7, (model_nfconf >> 4) & 7,
+		   S5P_NAND_MODEL_HCLK / 1000000);
+	seq_printf(m, "commands:        %lu (%lu unknown)\n", model_stat.cmds, model_stat.unknown_cmds);
+	seq_printf(m, "address cycles:  %lu\n", model_stat.addrs);
+	seq_printf(m, "nfdata:          %lu byte, %lu word accesses\n",
+		   model_stat.byte_access, model_stat.word_access);
+	seq_printf(m, "other regs:      %lu reads, %lu writes\n",
+		   model_stat.reg_reads, model_stat.reg_writes);
+	seq_printf(m, "data:            %llu bytes in, %llu bytes out\n",
+		   model_stat.data_in, model_stat.data_out);
+	seq_printf(m, "array:           %lu page reads, %lu programs, %lu erases\n",
+		   model_stat.page_reads, model_stat.page_progs, model_stat.erases);
+	seq_printf(m, "nop violations:  %lu\n", model_stat.nop_violations);
+	seq_printf(m, "injected flips:  %lu\n", model_stat.flips);
+	seq_printf(m, "bus time:        %llu us (%llu HCLK)\n", div_u64(bus_ns, 1000), model_stat.bus_cycles);
+	seq_printf(m, "array busy:      %llu us\n", div_u64(model_stat.array_ns, 1000));
+	seq_printf(m, "allocated:       %d / %d blocks\n", blocks, MODEL_BLOCKS);
+
+	return 0;
+}
+
+static int model_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, model_show, NULL);
+}
+
+static ssize_t model_write(struct file *file, const char __user *buf,
+			   size_t count, loff_t *ppos)
+{
+	memset(&model_stat, 0, sizeof(model_stat));
+
+	return count;
+}
+
+static const struct file_operations model_fops = {
+	.owner		= THIS_MODULE,
+	.open		= model_open,
+	.read		= seq_read,
+	.write		= model_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+void s5p_nand_model_debugfs(struct dentry *dir)
+{
+	//随s5p_nand目录一起删除
+	debugfs_create_file("model", S_IRUSR | S_IWUSR, dir, NULL, &model_fops);
+}